@@ -0,0 +1,259 @@
+//*****************************************************************************
+//
+// testco.cpp - Host test of the coroutine interface on a simulated CDC adapter.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <cstring>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserialco.hpp"
+#include "usbhserialbackend.h"
+#include "usbhserialsim.h"
+#include "usbhserialsimdev.h"
+#include "usbhstest.h"
+
+USBHS_DRIVERS(usbhs::CdcDriver, usbhs::Cp210xDriver);
+
+using namespace usbhs::co;
+
+//*****************************************************************************
+//
+// A failed frame allocation must produce an empty task, not a call to the
+// promise of a coroutine without a frame.
+//
+//*****************************************************************************
+static_assert(requires { Task::promise_type::
+                         get_return_object_on_allocation_failure(); },
+              "Task handles frame allocation failure");
+
+//*****************************************************************************
+//
+// Frames the simulation may run for each wave of sessions.
+//
+//*****************************************************************************
+#define TEST_FRAMES             100000
+
+static Executor g_sExecutor;
+static Stream<16384> g_sStream(g_sExecutor);
+static uint8_t g_pui8RxA[USB_TRANSFER_SIZE];
+static uint8_t g_pui8RxB[USB_TRANSFER_SIZE];
+
+static tUSBHSSimDevice g_sDevice;
+static tUSBHSSimSerial g_sSerial;
+
+static uint32_t g_ui32Done;
+static uint32_t g_ui32Bad;
+
+static uint32_t
+TestCallback(void *pvCBData, uint32_t ui32Event, uint32_t, void *)
+{
+    if(ui32Event == USB_EVENT_CONNECTED)
+    {
+        g_sStream.Open(static_cast<tSerialInstance *>(pvCBData), g_pui8RxA,
+                       g_pui8RxB);
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// One session: sends its number and reads it back through the loopback.
+// Writes complete in order and each reader waits behind the previous one,
+// so every session gets its own bytes back.
+//
+//*****************************************************************************
+static Task
+Session(uint32_t ui32Id)
+{
+    uint8_t pui8Out[4], pui8In[4];
+    std::size_t uSent, uRead;
+
+    memcpy(pui8Out, &ui32Id, sizeof(pui8Out));
+
+    uSent = co_await g_sStream.Write(usbhs::span<const uint8_t>(
+                                         pui8Out, sizeof(pui8Out)));
+    uRead = co_await g_sStream.Read(usbhs::span<uint8_t>(pui8In,
+                                                         sizeof(pui8In)));
+
+    if((uSent == sizeof(pui8Out)) && (uRead == sizeof(pui8In)) &&
+       (memcmp(pui8In, pui8Out, sizeof(pui8In)) == 0))
+    {
+        g_ui32Done++;
+    }
+    else
+    {
+        g_ui32Bad++;
+    }
+}
+
+//*****************************************************************************
+//
+// Spawns USBHS_CO_FRAMES sessions and runs them to the end.  Returns the
+// number of frames simulated.
+//
+//*****************************************************************************
+static uint32_t
+TestWave(uint32_t ui32First)
+{
+    uint32_t ui32Idx, ui32Spawned, ui32Frames;
+
+    g_ui32Done = 0;
+    g_ui32Bad = 0;
+
+    for(ui32Idx = 0, ui32Spawned = 0; ui32Idx < USBHS_CO_FRAMES; ui32Idx++)
+    {
+        ui32Spawned += g_sExecutor.Spawn(Session(ui32First + ui32Idx));
+    }
+    USBHS_CHECK_EQUAL(ui32Spawned, USBHS_CO_FRAMES);
+    USBHS_CHECK_EQUAL(g_sFramePool.Used(), USBHS_CO_FRAMES);
+
+    //
+    // With every frame in use the next session cannot start.  Its frame
+    // allocation fails and the task is empty.
+    //
+    std::size_t uFailed = g_sFramePool.Failed();
+    USBHS_CHECK(!g_sExecutor.Spawn(Session(0xFFFFFFFF)));
+    USBHS_CHECK_EQUAL(g_sFramePool.Failed(), uFailed + 1);
+    USBHS_CHECK(!Session(0xFFFFFFFF).Release());
+    USBHS_CHECK_EQUAL(g_sFramePool.Failed(), uFailed + 2);
+    USBHS_CHECK_EQUAL(g_sFramePool.Used(), USBHS_CO_FRAMES);
+
+    for(ui32Frames = 0;
+        ((g_ui32Done + g_ui32Bad) < USBHS_CO_FRAMES) &&
+        (ui32Frames < TEST_FRAMES); ui32Frames++)
+    {
+        g_sExecutor.Run();
+        USBHostSerialSimStep();
+        USBHostSerialProcess();
+        USBHostSerialProcessEvents();
+    }
+    g_sExecutor.Run();
+
+    USBHS_CHECK_EQUAL(g_ui32Done, USBHS_CO_FRAMES);
+    USBHS_CHECK_EQUAL(g_ui32Bad, 0);
+    USBHS_CHECK_EQUAL(g_sFramePool.Used(), 0);
+    USBHS_CHECK(g_sExecutor.Idle());
+
+    return(ui32Frames);
+}
+
+//*****************************************************************************
+//
+// A write that is still being sent when the stream is closed.
+//
+//*****************************************************************************
+static uint8_t g_pui8Long[4096];
+static std::size_t g_uLongSent;
+static bool g_bLongDone;
+
+static Task
+LongWrite()
+{
+    g_uLongSent = co_await g_sStream.Write(usbhs::span<const uint8_t>(
+                                               g_pui8Long,
+                                               sizeof(g_pui8Long)));
+    g_bLongDone = true;
+}
+
+static void
+TestRun(uint32_t ui32Frames)
+{
+    while(ui32Frames--)
+    {
+        g_sExecutor.Run();
+        USBHostSerialSimStep();
+        USBHostSerialProcess();
+        USBHostSerialProcessEvents();
+    }
+    g_sExecutor.Run();
+}
+
+int
+main()
+{
+    uint32_t ui32Frames;
+    tSerialInstance *psInstance;
+
+    USBHostSerialSetBackend(&g_sUSBHSBackendSim);
+    USBHostSerialInit(TestCallback);
+
+    g_sSerial.bLoopback = true;
+    g_sSerial.ui32FifoSize = USBHS_SIM_FIFO_MAX;
+    USBHostSerialSimSerialSetup(&g_sDevice, &g_sSerial, USBHS_SIM_CDC);
+    USBHostSerialSimConnect(&g_sDevice);
+    USBHS_CHECK(g_sStream.GetPort() != nullptr);
+    if(g_sStream.GetPort() == nullptr)
+    {
+        return(USBHS_TEST_END("testco"));
+    }
+
+    USBHostSerialInitNewDevice(g_sStream.GetPort()->Instance());
+    g_sStream.GetPort()->SetLineConfig(usbhs::LineConfig(921600));
+
+    //
+    // Two waves, the second one on the frames the first one gave back.
+    //
+    ui32Frames = TestWave(0);
+    ui32Frames += TestWave(USBHS_CO_FRAMES);
+
+    USBHS_CHECK_EQUAL(g_sFramePool.Peak(), USBHS_CO_FRAMES);
+    USBHS_CHECK_EQUAL(g_sStream.Overruns(), 0);
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Overruns, 0);
+
+    printf("testco: %u sessions in %u frames\n", 2 * USBHS_CO_FRAMES,
+           (unsigned)ui32Frames);
+
+    //
+    // Closing the stream purges a write in progress.  Its coroutine only
+    // resumes once the library gave the buffer back, and then the port is
+    // released.
+    //
+    psInstance = g_sStream.GetPort()->Instance();
+    USBHS_CHECK(g_sExecutor.Spawn(LongWrite()));
+    TestRun(5);
+    USBHS_CHECK(!g_bLongDone);
+
+    g_sStream.Close();
+    g_sExecutor.Run();
+    USBHS_CHECK(!g_bLongDone);
+    USBHS_CHECK(g_sStream.GetPort() != nullptr);
+    USBHS_CHECK(g_sStream.Closed());
+
+    TestRun(20);
+    USBHS_CHECK(g_bLongDone);
+    USBHS_CHECK(g_uLongSent < sizeof(g_pui8Long));
+    USBHS_CHECK(g_sStream.GetPort() == nullptr);
+    USBHS_CHECK(psInstance->pfnCallback == 0);
+    USBHS_CHECK_EQUAL(g_sFramePool.Used(), 0);
+
+    //
+    // Writes after closing complete at once.
+    //
+    g_bLongDone = false;
+    USBHS_CHECK(g_sExecutor.Spawn(LongWrite()));
+    g_sExecutor.Run();
+    USBHS_CHECK(g_bLongDone);
+    USBHS_CHECK_EQUAL(g_uLongSent, 0);
+
+    return(USBHS_TEST_END("testco"));
+}
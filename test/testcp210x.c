@@ -0,0 +1,206 @@
+//*****************************************************************************
+//
+// testcp210x.c - Host test of the CP210x driver on a simulated adapter.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialbackend.h"
+#include "usbhserialsim.h"
+#include "usbhserialsimdev.h"
+#include "usbhstest.h"
+
+//*****************************************************************************
+//
+// Vendor request setting the line control of a CP210x.
+//
+//*****************************************************************************
+#define CPCDC_SET_LINE_CTL      0x03
+
+//*****************************************************************************
+//
+// The simulated backend, with control transfers passed through
+// TestControlTransfer() to record the last SET_LINE_CTL request.
+//
+//*****************************************************************************
+static tUSBHSBackend g_sTestBackend;
+static uint32_t g_ui32LineCtl;
+static uint32_t g_ui32LineCtlCount;
+
+static tUSBHSSimDevice g_sDevice;
+static tUSBHSSimSerial g_sSerial;
+static tSerialInstance *g_psInstance;
+
+static uint32_t
+TestControlTransfer(tUSBHostDevice *psDevice, tUSBRequest *psSetupPacket,
+                    uint8_t *pui8Data, uint32_t ui32Size)
+{
+    if(((psSetupPacket->bmRequestType & USB_RTYPE_TYPE_M) ==
+        USB_RTYPE_VENDOR) &&
+       (psSetupPacket->bRequest == CPCDC_SET_LINE_CTL))
+    {
+        g_ui32LineCtl = psSetupPacket->wValue;
+        g_ui32LineCtlCount++;
+    }
+
+    return(g_sUSBHSBackendSim.pfnControlTransfer(psDevice, psSetupPacket,
+                                                 pui8Data, ui32Size));
+}
+
+static uint32_t
+TestCallback(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgParam,
+             void *pvMsgData)
+{
+    if(ui32Event == USB_EVENT_CONNECTED)
+    {
+        g_psInstance = (tSerialInstance *)pvCBData;
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Line settings and the SET_LINE_CTL value application note AN571 gives for
+// them.
+//
+//*****************************************************************************
+static const struct
+{
+    uint32_t ui32Coding;
+    uint16_t ui16LineCtl;
+}
+g_psLineCtl[] =
+{
+    { USBHS_CONF_DATA_8 | USBHS_CONF_PAR_NONE | USBHS_CONF_STOP_1, 0x0800 },
+    { USBHS_CONF_DATA_7 | USBHS_CONF_PAR_EVEN | USBHS_CONF_STOP_1, 0x0720 },
+    { USBHS_CONF_DATA_8 | USBHS_CONF_PAR_ODD | USBHS_CONF_STOP_2, 0x0812 },
+    { USBHS_CONF_DATA_5 | USBHS_CONF_PAR_MARK | USBHS_CONF_STOP_1_5, 0x0531 },
+    { USBHS_CONF_DATA_6 | USBHS_CONF_PAR_SPACE | USBHS_CONF_STOP_1, 0x0640 },
+};
+
+int
+main(void)
+{
+    tUSBHSBaudRange sRange;
+    uint32_t ui32Idx, ui32Stalls;
+
+    g_sTestBackend = g_sUSBHSBackendSim;
+    g_sTestBackend.pfnControlTransfer = TestControlTransfer;
+    USBHostSerialSetBackend(&g_sTestBackend);
+    USBHostSerialInit(TestCallback);
+
+    USBHostSerialSimSerialSetup(&g_sDevice, &g_sSerial, USBHS_SIM_CP210X);
+    USBHostSerialSimConnect(&g_sDevice);
+    USBHS_CHECK(g_psInstance != 0);
+    if(g_psInstance == 0)
+    {
+        return(USBHS_TEST_END("testcp210x"));
+    }
+    USBHostSerialInitNewDevice(g_psInstance);
+
+    //
+    // Every setting is encoded as AN571 describes and reads back unchanged.
+    //
+    for(ui32Idx = 0; ui32Idx < sizeof(g_psLineCtl) / sizeof(g_psLineCtl[0]);
+        ui32Idx++)
+    {
+        g_ui32LineCtlCount = 0;
+        USBHostSerialSetLineConfig(g_psInstance, 115200,
+                                   g_psLineCtl[ui32Idx].ui32Coding);
+        USBHS_CHECK_EQUAL(g_ui32LineCtlCount, 1);
+        USBHS_CHECK_EQUAL(g_ui32LineCtl, g_psLineCtl[ui32Idx].ui16LineCtl);
+        USBHS_CHECK_EQUAL(USBHostSerialGetCoding(g_psInstance),
+                          g_psLineCtl[ui32Idx].ui32Coding);
+    }
+
+    //
+    // The adapter takes the settings of a line configuration and stalls
+    // those it does not support, leaving the line as it was.
+    //
+    ui32Stalls = g_sSerial.ui32Stalls;
+    USBHostSerialSetLineConfig(g_psInstance, 57600,
+                               USBHS_CONF_DATA_7 | USBHS_CONF_PAR_ODD |
+                               USBHS_CONF_STOP_2);
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Stalls, ui32Stalls);
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Baud, 57600);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8DataBits, 7);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8Parity, 1);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8StopBits, 2);
+
+    USBHostSerialSetLineConfig(g_psInstance, 57600,
+                               0x00000900 | USBHS_CONF_PAR_NONE |
+                               USBHS_CONF_STOP_1);
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Stalls, ui32Stalls + 1);
+    USBHostSerialSetLineConfig(g_psInstance, 57600,
+                               USBHS_CONF_DATA_8 | 0x00000050 |
+                               USBHS_CONF_STOP_1);
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Stalls, ui32Stalls + 2);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8DataBits, 7);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8Parity, 1);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8StopBits, 2);
+
+    //
+    // A CP2102 produces the AN205 rates below 1000000 baud and is sent
+    // higher rates as they are.
+    //
+    USBHostSerialGetBaudRange(g_psInstance, &sRange);
+    USBHS_CHECK_EQUAL(sRange.ui32Max, 1000000);
+    USBHS_CHECK_EQUAL(sRange.ui32Flags, 0);
+    USBHS_CHECK_EQUAL(USBHostSerialGetBaudActual(g_psInstance, 110000, 0),
+                      115200);
+    USBHS_CHECK_EQUAL(USBHostSerialGetBaudActual(g_psInstance, 999999, 0),
+                      921600);
+    USBHS_CHECK_EQUAL(USBHostSerialGetBaudActual(g_psInstance, 1000000, 0),
+                      1000000);
+    USBHS_CHECK_EQUAL(USBHostSerialGetBaudActual(g_psInstance, 1500000, 0),
+                      1000000);
+
+    //
+    // A CP2108 takes rates up to 2000000 baud.
+    //
+    g_sSerial.ui8PartNum = 0x08;
+    USBHostSerialInitNewDevice(g_psInstance);
+    USBHostSerialGetBaudRange(g_psInstance, &sRange);
+    USBHS_CHECK_EQUAL(sRange.ui32Max, 2000000);
+    USBHS_CHECK_EQUAL(sRange.ui32Flags, 0);
+    USBHS_CHECK_EQUAL(USBHostSerialGetBaudActual(g_psInstance, 1500000, 0),
+                      1500000);
+    USBHS_CHECK_EQUAL(USBHostSerialGetBaudActual(g_psInstance, 57600, 0),
+                      57600);
+
+    //
+    // A CP2102N divides its clock, so the driver knows the rates.
+    //
+    g_sSerial.ui8PartNum = 0x20;
+    USBHostSerialInitNewDevice(g_psInstance);
+    USBHostSerialGetBaudRange(g_psInstance, &sRange);
+    USBHS_CHECK_EQUAL(sRange.ui32Max, 3000000);
+    USBHS_CHECK_EQUAL(sRange.ui32Flags, USBHS_BAUD_COMPUTED);
+    USBHS_CHECK_EQUAL(USBHostSerialGetBaudActual(g_psInstance, 3000000, 0),
+                      3000000);
+
+    return(USBHS_TEST_END("testcp210x"));
+}
@@ -0,0 +1,45 @@
+//*****************************************************************************
+//
+// testdrivers.c - Driver table for the usbhserial host tests.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialdriver.h"
+#include "usbhserialcdc.h"
+#include "usbhserialcp210x.h"
+
+//*****************************************************************************
+//
+// Driver table of the test programs, as an application declares it.
+//
+//*****************************************************************************
+tUSBSerialDriver g_psDrivers[] =
+{
+    DECLARE_USB_SERIAL_CDC_DRIVER,
+    DECLARE_USB_SERIAL_CP210X_DRIVER
+};
+
+uint8_t g_ui8NumDrivers = sizeof(g_psDrivers) / sizeof(g_psDrivers[0]);
@@ -0,0 +1,240 @@
+//*****************************************************************************
+//
+// testhpp.cpp - Host test of the C++ interface on a simulated CDC adapter.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <cstring>
+#include <optional>
+#include <type_traits>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.hpp"
+#include "usbhserialbackend.h"
+#include "usbhserialsim.h"
+#include "usbhserialsimdev.h"
+#include "usbhstest.h"
+
+//*****************************************************************************
+//
+// The test is built twice, with usbhs::span being std::span and with its
+// own fallback.  TEST_NAME tells the two apart in the output.
+//
+//*****************************************************************************
+#if defined(__cpp_lib_span)
+#define TEST_NAME               "testhpp (std::span)"
+static_assert(std::is_same<usbhs::span<uint8_t>, std::span<uint8_t>>::value,
+              "usbhs::span is std::span");
+#else
+#define TEST_NAME               "testhpp (fallback span)"
+#endif
+
+USBHS_DRIVERS(usbhs::CdcDriver, usbhs::Cp210xDriver);
+
+//*****************************************************************************
+//
+// Records what the port reports.
+//
+//*****************************************************************************
+struct TestHandler
+{
+    uint8_t pui8Rx[1024];
+    uint32_t ui32RxSize = 0;
+    const uint8_t *pui8Sent = nullptr;
+    uint32_t ui32SentSize = 0;
+    uint32_t ui32Sent = 0;
+    uint32_t ui32Notify = 0;
+    uint32_t ui32NotifySize = 0;
+    bool bDisconnected = false;
+
+    void OnReceive(usbhs::Port<TestHandler> &, usbhs::span<const uint8_t> sData)
+    {
+        if(ui32RxSize + sData.size() <= sizeof(pui8Rx))
+        {
+            memcpy(pui8Rx + ui32RxSize, sData.data(), sData.size());
+        }
+        ui32RxSize += static_cast<uint32_t>(sData.size());
+    }
+
+    void OnSent(usbhs::Port<TestHandler> &, usbhs::span<const uint8_t> sData)
+    {
+        pui8Sent = sData.data();
+        ui32SentSize = static_cast<uint32_t>(sData.size());
+        ui32Sent++;
+    }
+
+    void OnEvent(usbhs::Port<TestHandler> &, uint32_t ui32Event,
+                 uint32_t ui32MsgParam)
+    {
+        if(ui32Event == USBHS_EVENT_NOTIFY)
+        {
+            ui32NotifySize = ui32MsgParam;
+            ui32Notify++;
+        }
+        else if(ui32Event == USB_EVENT_DISCONNECTED)
+        {
+            bDisconnected = true;
+        }
+    }
+};
+
+static TestHandler g_sHandler;
+static std::optional<usbhs::Port<TestHandler>> g_oPort;
+static uint8_t g_pui8RxA[USB_TRANSFER_SIZE];
+static uint8_t g_pui8RxB[USB_TRANSFER_SIZE];
+
+static tUSBHSSimDevice g_sDevice;
+static tUSBHSSimSerial g_sSerial;
+
+static uint32_t
+TestCallback(void *pvCBData, uint32_t ui32Event, uint32_t, void *)
+{
+    if(ui32Event == USB_EVENT_CONNECTED)
+    {
+        g_oPort.emplace(static_cast<tSerialInstance *>(pvCBData), g_sHandler,
+                        usbhs::span<uint8_t>(g_pui8RxA),
+                        usbhs::span<uint8_t>(g_pui8RxB));
+    }
+
+    return(0);
+}
+
+static void
+TestRun(uint32_t ui32Frames)
+{
+    while(ui32Frames--)
+    {
+        USBHostSerialSimStep();
+        USBHostSerialProcess();
+        USBHostSerialProcessEvents();
+    }
+}
+
+int
+main()
+{
+    static uint8_t pui8Message[300];
+    uint8_t pui8RxA[sizeof(g_pui8RxA)], pui8RxB[sizeof(g_pui8RxB)];
+    uint32_t ui32Idx;
+    constexpr auto sConfig8N1 = usbhs::LineConfig(115200);
+    constexpr auto sConfig7E2 = usbhs::LineConfig(9600)
+                                    .Data(usbhs::DataBits::Seven)
+                                    .Parity(usbhs::Parity::Even)
+                                    .Stop(usbhs::StopBits::Two);
+
+    static_assert(sConfig8N1.Coding() ==
+                  (USBHS_CONF_DATA_8 | USBHS_CONF_PAR_NONE |
+                   USBHS_CONF_STOP_1), "8N1 coding");
+    static_assert(sConfig7E2.Coding() ==
+                  (USBHS_CONF_DATA_7 | USBHS_CONF_PAR_EVEN |
+                   USBHS_CONF_STOP_2), "7E2 coding");
+    static_assert(sConfig7E2 != sConfig8N1, "LineConfig comparison");
+
+    for(ui32Idx = 0; ui32Idx < sizeof(pui8Message); ui32Idx++)
+    {
+        pui8Message[ui32Idx] = static_cast<uint8_t>(ui32Idx * 7);
+    }
+
+    USBHostSerialSetBackend(&g_sUSBHSBackendSim);
+    USBHostSerialInit(TestCallback);
+
+    g_sSerial.bLoopback = true;
+    USBHostSerialSimSerialSetup(&g_sDevice, &g_sSerial, USBHS_SIM_CDC);
+    USBHostSerialSimConnect(&g_sDevice);
+    USBHS_CHECK(g_oPort.has_value());
+    if(!g_oPort)
+    {
+        return(USBHS_TEST_END(TEST_NAME));
+    }
+
+    USBHostSerialInitNewDevice(g_oPort->Instance());
+
+    //
+    // Line settings reach the adapter and read back the same.
+    //
+    USBHS_CHECK_EQUAL(g_oPort->SetLineConfig(sConfig7E2), 0);
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Baud, 9600);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8DataBits, 7);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8StopBits, 2);
+    USBHS_CHECK(g_oPort->GetLineConfig() == sConfig7E2);
+
+    USBHS_CHECK_EQUAL(g_oPort->SetLineConfig(sConfig8N1), 0);
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Baud, 115200);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8DataBits, 8);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8Parity, 0);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8StopBits, 0);
+    USBHS_CHECK(g_oPort->GetLineConfig() == sConfig8N1);
+
+    //
+    // Modem control lines.
+    //
+    g_oPort->SetControl(usbhs::Control::Dtr | usbhs::Control::Rts);
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Control &
+                      (USBHS_CONTROL_DTR | USBHS_CONTROL_RTS),
+                      USBHS_CONTROL_DTR | USBHS_CONTROL_RTS);
+    g_oPort->SetControl(usbhs::Control::Dtr);
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Control &
+                      (USBHS_CONTROL_DTR | USBHS_CONTROL_RTS),
+                      USBHS_CONTROL_DTR);
+
+    //
+    // Data written through the port comes back through the loopback and the
+    // buffer is reported as sent.
+    //
+    TestRun(20);
+    USBHS_CHECK_EQUAL(g_oPort->Write(usbhs::span<const uint8_t>(
+                          pui8Message, sizeof(pui8Message))), 0);
+    TestRun(200);
+    USBHS_CHECK_EQUAL(g_sHandler.ui32Sent, 1);
+    USBHS_CHECK(g_sHandler.pui8Sent == pui8Message);
+    USBHS_CHECK_EQUAL(g_sHandler.ui32SentSize, sizeof(pui8Message));
+    USBHS_CHECK_EQUAL(g_sHandler.ui32RxSize, sizeof(pui8Message));
+    USBHS_CHECK(memcmp(g_sHandler.pui8Rx, pui8Message,
+                       sizeof(pui8Message)) == 0);
+
+    //
+    // A change of the modem inputs is reported as a SERIAL_STATE
+    // notification and leaves the receive buffers alone.
+    //
+    memcpy(pui8RxA, g_pui8RxA, sizeof(pui8RxA));
+    memcpy(pui8RxB, g_pui8RxB, sizeof(pui8RxB));
+    USBHostSerialSimSerialModem(&g_sSerial, USBHS_CONTROL_DSR);
+    TestRun(20);
+    USBHS_CHECK_EQUAL(g_sHandler.ui32Notify, 1);
+    USBHS_CHECK_EQUAL(g_sHandler.ui32NotifySize, 10);
+    USBHS_CHECK_EQUAL(g_oPort->Instance()->pui8Notify[1], 0x20);
+    USBHS_CHECK_EQUAL(g_sHandler.ui32RxSize, sizeof(pui8Message));
+    USBHS_CHECK(memcmp(pui8RxA, g_pui8RxA, sizeof(pui8RxA)) == 0);
+    USBHS_CHECK(memcmp(pui8RxB, g_pui8RxB, sizeof(pui8RxB)) == 0);
+
+    //
+    // The disconnect reaches the handler, after which the port is destroyed
+    // and gives the instance callback back.
+    //
+    tSerialInstance *psInstance = g_oPort->Instance();
+    USBHostSerialSimDisconnect(&g_sDevice);
+    TestRun(2);
+    USBHS_CHECK(g_sHandler.bDisconnected);
+    g_oPort.reset();
+    USBHS_CHECK(psInstance->pfnCallback == 0);
+
+    return(USBHS_TEST_END(TEST_NAME));
+}
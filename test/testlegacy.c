@@ -0,0 +1,123 @@
+//*****************************************************************************
+//
+// testlegacy.c - Host test of a driver table without the later operations.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialdriver.h"
+#include "usbhserialcp210x.h"
+#include "usbhserialbackend.h"
+#include "usbhserialsim.h"
+#include "usbhserialsimdev.h"
+#include "usbhstest.h"
+
+//*****************************************************************************
+//
+// Driver table as applications declared it before the operations following
+// pfnBreakClear were added, which are left 0.
+//
+//*****************************************************************************
+tUSBSerialDriver g_psDrivers[] =
+{
+    {
+        USB_SERIAL_CP210X_MATCH,
+        USBHSerialCPInit,
+        USBHSerialCPSetBaud,
+        USBHSerialCPGetBaud,
+        USBHSerialCPSetCoding,
+        USBHSerialCPGetCoding,
+        USBHSerialCPSetControlLineState,
+        USBHSerialCPGetControlLineState,
+        USBHSerialCPSetFlow,
+        USBHSerialCPBreakSet,
+        USBHSerialCPBreakClear
+    }
+};
+
+uint8_t g_ui8NumDrivers = sizeof(g_psDrivers) / sizeof(g_psDrivers[0]);
+
+static tUSBHSSimDevice g_sDevice;
+static tUSBHSSimSerial g_sSerial;
+static tSerialInstance *g_psInstance;
+
+static uint32_t
+TestCallback(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgParam,
+             void *pvMsgData)
+{
+    if(ui32Event == USB_EVENT_CONNECTED)
+    {
+        g_psInstance = (tSerialInstance *)pvCBData;
+    }
+
+    return(0);
+}
+
+int
+main(void)
+{
+    tUSBHSBaudRange sRange;
+    int32_t i32Error;
+
+    USBHostSerialSetBackend(&g_sUSBHSBackendSim);
+    USBHostSerialInit(TestCallback);
+
+    USBHostSerialSimSerialSetup(&g_sDevice, &g_sSerial, USBHS_SIM_CP210X);
+    USBHostSerialSimConnect(&g_sDevice);
+    USBHS_CHECK(g_psInstance != 0);
+    if(g_psInstance == 0)
+    {
+        return(USBHS_TEST_END("testlegacy"));
+    }
+    USBHostSerialInitNewDevice(g_psInstance);
+
+    //
+    // The line is configured with the baud rate and coding operations.
+    //
+    USBHS_CHECK_EQUAL(USBHostSerialSetLineConfig(g_psInstance, 57600,
+                                                 USBHS_CONF_DATA_7 |
+                                                 USBHS_CONF_PAR_EVEN |
+                                                 USBHS_CONF_STOP_2), 0);
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Baud, 57600);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8DataBits, 7);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8Parity, 2);
+    USBHS_CHECK_EQUAL(g_sSerial.ui8StopBits, 2);
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Stalls, 0);
+
+    //
+    // Without the other operations the device cannot purge and any rate is
+    // taken to be produced as requested.
+    //
+    USBHS_CHECK(USBHostSerialPurge(g_psInstance, true, true) != 0);
+    USBHS_CHECK_EQUAL(USBHostSerialGetBaudActual(g_psInstance, 123456,
+                                                 &i32Error), 123456);
+    USBHS_CHECK_EQUAL(i32Error, 0);
+    USBHostSerialGetBaudRange(g_psInstance, &sRange);
+    USBHS_CHECK_EQUAL(sRange.ui32Min, 1);
+    USBHS_CHECK_EQUAL(sRange.ui32Max, 0xFFFFFFFF);
+    USBHS_CHECK_EQUAL(sRange.ui32Flags, 0);
+
+    return(USBHS_TEST_END("testlegacy"));
+}
@@ -0,0 +1,160 @@
+//*****************************************************************************
+//
+// testrs485.c - Host test of RS-485 direction control on a simulated adapter.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialbackend.h"
+#include "usbhserialsim.h"
+#include "usbhserialsimdev.h"
+#include "usbhstest.h"
+
+static tUSBHSSimDevice g_sDevice;
+static tUSBHSSimSerial g_sSerial;
+static tSerialInstance *g_psInstance;
+
+//*****************************************************************************
+//
+// The transmit completions reported to the instance callback.
+//
+//*****************************************************************************
+static struct
+{
+    void *pvData;
+    uint32_t ui32Size;
+}
+g_psDone[8];
+static uint32_t g_ui32Done;
+
+static uint8_t g_pui8A[200];
+static uint8_t g_pui8B[10];
+static uint8_t g_pui8C[5];
+
+static uint32_t
+TestCallback(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgParam,
+             void *pvMsgData)
+{
+    if(ui32Event == USB_EVENT_CONNECTED)
+    {
+        g_psInstance = (tSerialInstance *)pvCBData;
+    }
+    else if((ui32Event == USB_EVENT_TX_COMPLETE) &&
+            (g_ui32Done < sizeof(g_psDone) / sizeof(g_psDone[0])))
+    {
+        g_psDone[g_ui32Done].pvData = pvMsgData;
+        g_psDone[g_ui32Done].ui32Size = ui32MsgParam;
+        g_ui32Done++;
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Runs the bus and the main loop for a number of frames.
+//
+//*****************************************************************************
+static void
+TestRun(uint32_t ui32Frames)
+{
+    while(ui32Frames--)
+    {
+        USBHostSerialSimStep();
+        USBHostSerialProcess();
+    }
+}
+
+int
+main(void)
+{
+    tUSBHSRs485 sRs485;
+    tUSBHSRs485Stats sStats;
+
+    USBHostSerialSetBackend(&g_sUSBHSBackendSim);
+    USBHostSerialSetClock(USBHostSerialSimClock);
+    USBHostSerialInit(TestCallback);
+
+    USBHostSerialSimSerialSetup(&g_sDevice, &g_sSerial, USBHS_SIM_CP210X);
+    USBHostSerialSimConnect(&g_sDevice);
+    USBHS_CHECK(g_psInstance != 0);
+    if(g_psInstance == 0)
+    {
+        return(USBHS_TEST_END("testrs485"));
+    }
+    USBHostSerialSetupInstance(g_psInstance, TestCallback, 0);
+    USBHostSerialInitNewDevice(g_psInstance);
+    USBHostSerialSetLineConfig(g_psInstance, 115200, USBHS_CONF_DATA_8 |
+                               USBHS_CONF_PAR_NONE | USBHS_CONF_STOP_1);
+
+    //
+    // RTS drives the transceiver, which needs three frames to switch.
+    //
+    sRs485.ui32Control = 0;
+    sRs485.ui32Drive = USBHS_CONTROL_RTS;
+    sRs485.ui32PreDelay = 3000;
+    sRs485.ui32PostDelay = 0;
+    USBHS_CHECK_EQUAL(USBHostSerialSetRs485(g_psInstance, &sRs485), 0);
+
+    //
+    // Buffers purged while the transceiver switches to send are dropped
+    // without a byte reaching the line, and reported in order.
+    //
+    USBHS_CHECK_EQUAL(USBHostSerialScheduleWrite(g_psInstance, g_pui8A,
+                                                 sizeof(g_pui8A)), 0);
+    USBHS_CHECK_EQUAL(USBHostSerialScheduleWrite(g_psInstance, g_pui8B,
+                                                 sizeof(g_pui8B)), 0);
+    TestRun(1);
+    USBHS_CHECK(g_sSerial.ui32Control & USBHS_CONTROL_RTS);
+    USBHostSerialPurge(g_psInstance, false, true);
+    TestRun(50);
+
+    USBHS_CHECK_EQUAL(g_sSerial.ui32LineOut, 0);
+    USBHS_CHECK_EQUAL(g_ui32Done, 2);
+    USBHS_CHECK(g_psDone[0].pvData == g_pui8A);
+    USBHS_CHECK_EQUAL(g_psDone[0].ui32Size, 0);
+    USBHS_CHECK(g_psDone[1].pvData == g_pui8B);
+    USBHS_CHECK_EQUAL(g_psDone[1].ui32Size, 0);
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Control & USBHS_CONTROL_RTS, 0);
+
+    //
+    // The next buffer is sent as usual.
+    //
+    g_ui32Done = 0;
+    USBHS_CHECK_EQUAL(USBHostSerialScheduleWrite(g_psInstance, g_pui8C,
+                                                 sizeof(g_pui8C)), 0);
+    TestRun(50);
+
+    USBHS_CHECK_EQUAL(g_sSerial.ui32LineOut, sizeof(g_pui8C));
+    USBHS_CHECK_EQUAL(g_ui32Done, 1);
+    USBHS_CHECK(g_psDone[0].pvData == g_pui8C);
+    USBHS_CHECK_EQUAL(g_psDone[0].ui32Size, sizeof(g_pui8C));
+    USBHS_CHECK_EQUAL(g_sSerial.ui32Control & USBHS_CONTROL_RTS, 0);
+
+    USBHostSerialGetRs485Stats(g_psInstance, &sStats);
+    USBHS_CHECK_EQUAL(sStats.ui32Transmissions, 2);
+
+    return(USBHS_TEST_END("testrs485"));
+}
@@ -0,0 +1,138 @@
+//*****************************************************************************
+// testselftest.c - Host test of the loopback self-test on a simulated adapter.
+// testrs485.c - Host test of RS-485 direction control on a simulated adapter.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialbackend.h"
+#include "usbhserialselftest.h"
+#include "usbhserialsim.h"
+#include "usbhserialsimdev.h"
+#include "usbhstest.h"
+
+static tUSBHSSimDevice g_sDevice;
+static tUSBHSSimSerial g_sSerial;
+static tSerialInstance *g_psInstance;
+static tUSBHSSelfTest g_sTest;
+static tUSBHSSelfTestResult g_psResults[3];
+
+//
+// The steps that time out stop with blocks still queued behind the slow line.
+//
+static const uint32_t g_pui32Baud[3] = { 300, 115200, 300 };
+
+//
+// The transmit completions the application callback received.
+//
+static uint32_t g_ui32Done;
+
+static uint32_t
+TestCallback(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgParam,
+             void *pvMsgData)
+{
+    if(ui32Event == USB_EVENT_CONNECTED)
+    {
+        g_psInstance = (tSerialInstance *)pvCBData;
+    }
+    else if(ui32Event == USB_EVENT_TX_COMPLETE)
+    {
+        g_ui32Done++;
+    }
+
+    return(0);
+}
+
+int
+main(void)
+{
+    uint32_t ui32Frames;
+
+    USBHostSerialSetBackend(&g_sUSBHSBackendSim);
+    USBHostSerialSetClock(USBHostSerialSimClock);
+    USBHostSerialInit(TestCallback);
+
+    USBHostSerialSimSerialSetup(&g_sDevice, &g_sSerial, USBHS_SIM_CP210X);
+    g_sSerial.bLoopback = true;
+    USBHostSerialSimConnect(&g_sDevice);
+    USBHS_CHECK(g_psInstance != 0);
+    if(g_psInstance == 0)
+    {
+        return(USBHS_TEST_END("testselftest"));
+    }
+    USBHostSerialSetupInstance(g_psInstance, TestCallback, 0);
+    USBHostSerialInitNewDevice(g_psInstance);
+
+    //
+    // The clock counts microseconds, a step ends 20ms after the last byte
+    // came back.
+    //
+    g_sTest.pui32Baud = g_pui32Baud;
+    g_sTest.ui32NumBaud = 3;
+    g_sTest.ui32Coding = USBHS_CONF_DATA_8 | USBHS_CONF_PAR_NONE |
+                         USBHS_CONF_STOP_1;
+    g_sTest.ui32Bytes = 1000;
+    g_sTest.ui32TicksPerSecond = 1000000;
+    g_sTest.ui32Timeout = 20000;
+    g_sTest.psResults = g_psResults;
+    USBHS_CHECK_EQUAL(USBHostSerialSelfTestStart(g_psInstance, &g_sTest), 0);
+
+    for(ui32Frames = 0; ui32Frames < 10000; ui32Frames++)
+    {
+        USBHostSerialSimStep();
+        USBHostSerialProcess();
+        if(USBHostSerialSelfTestProcess(&g_sTest))
+        {
+            break;
+        }
+    }
+    USBHS_CHECK(ui32Frames < 10000);
+
+    //
+    // The slow steps lose most of the pattern.
+    //
+    USBHS_CHECK_EQUAL(g_psResults[0].ui32Baud, 300);
+    USBHS_CHECK(g_psResults[0].ui32Lost != 0);
+    USBHS_CHECK_EQUAL(g_psResults[2].ui32Baud, 300);
+    USBHS_CHECK(g_psResults[2].ui32Lost != 0);
+
+    //
+    // Nothing left over from the first step shows up in the second one.
+    //
+    USBHS_CHECK_EQUAL(g_psResults[1].ui32Baud, 115200);
+    USBHS_CHECK_EQUAL(g_psResults[1].ui32BytesSent, 1000);
+    USBHS_CHECK_EQUAL(g_psResults[1].ui32BytesReceived, 1000);
+    USBHS_CHECK_EQUAL(g_psResults[1].ui32Errors, 0);
+    USBHS_CHECK_EQUAL(g_psResults[1].ui32Lost, 0);
+
+    //
+    // The blocks of the last step are not reported to the application and
+    // the instance has its own callback back.
+    //
+    USBHostSerialSimStep();
+    USBHostSerialProcess();
+    USBHS_CHECK_EQUAL(g_ui32Done, 0);
+    USBHS_CHECK(g_psInstance->pfnCallback == TestCallback);
+
+    return(USBHS_TEST_END("testselftest"));
+}
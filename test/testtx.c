@@ -0,0 +1,498 @@
+//*****************************************************************************
+//
+// testtx.c - Host test of the transmit path on a simulated adapter.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialbackend.h"
+#include "usbhserialpriv.h"
+#include "usbhserialsim.h"
+#include "usbhserialsimdev.h"
+#include "usbhstest.h"
+
+//*****************************************************************************
+//
+// The test is built with and without USBHS_DMA, which sends several packets
+// per transfer.  TEST_NAME tells the two apart in the output.
+//
+//*****************************************************************************
+#ifdef USBHS_DMA
+#define TEST_NAME               "testtx (dma)"
+#else
+#define TEST_NAME               "testtx"
+#endif
+
+//*****************************************************************************
+//
+// Packet size of the bulk OUT endpoint, small enough for the segments below
+// to cross packets.
+//
+//*****************************************************************************
+#define TEST_PACKET             16
+
+static tUSBHSSimDevice g_sDevice;
+static tUSBHSSimSerial g_sSerial;
+static tSerialInstance *g_psInstance;
+static tUSBHSBackend g_sBackend;
+
+//*****************************************************************************
+//
+// The bulk OUT transfers scheduled, their sizes and where they started, and
+// the bytes of all of them in order.
+//
+//*****************************************************************************
+static uint32_t g_pui32Out[32];
+static uint8_t *g_ppui8Out[32];
+static uint32_t g_ui32Out;
+static uint8_t g_pui8Line[512];
+static uint32_t g_ui32Line;
+
+//*****************************************************************************
+//
+// The transmit completions reported to the instance callback.
+//
+//*****************************************************************************
+static struct
+{
+    void *pvData;
+    uint32_t ui32Size;
+}
+g_psDone[16];
+static uint32_t g_ui32Done;
+
+//*****************************************************************************
+//
+// The data sent, and the bytes each test expects on the line.
+//
+//*****************************************************************************
+static uint8_t g_pui8Data[256];
+static uint8_t g_pui8Expect[512];
+
+//*****************************************************************************
+//
+// A copy of the configuration descriptor of the simulated adapter, with the
+// packet size of its bulk OUT endpoint changed.
+//
+//*****************************************************************************
+static uint8_t g_pui8Config[64];
+
+static const uint8_t *
+TestConfigOut(const uint8_t *pui8Config, uint16_t ui16MaxPacket)
+{
+    uint32_t ui32Size, ui32Pos;
+
+    ui32Size = pui8Config[2] | ((uint32_t)pui8Config[3] << 8);
+    memcpy(g_pui8Config, pui8Config, ui32Size);
+
+    for(ui32Pos = 0; ui32Pos < ui32Size; ui32Pos += g_pui8Config[ui32Pos])
+    {
+        if((g_pui8Config[ui32Pos + 1] == USB_DTYPE_ENDPOINT) &&
+           !(g_pui8Config[ui32Pos + 2] & USB_EP_DESC_IN) &&
+           ((g_pui8Config[ui32Pos + 3] & USB_EP_ATTR_TYPE_M) ==
+            USB_EP_ATTR_BULK))
+        {
+            g_pui8Config[ui32Pos + 4] = (uint8_t)ui16MaxPacket;
+            g_pui8Config[ui32Pos + 5] = (uint8_t)(ui16MaxPacket >> 8);
+        }
+    }
+
+    return(g_pui8Config);
+}
+
+static void
+TestPipeSchedule(uint32_t ui32Pipe, uint8_t *pui8Data, uint32_t ui32Size)
+{
+    if((g_psInstance != 0) && (ui32Pipe == g_psInstance->ui32BulkOutPipe) &&
+       (g_ui32Out < sizeof(g_pui32Out) / sizeof(g_pui32Out[0])) &&
+       (g_ui32Line + ui32Size <= sizeof(g_pui8Line)))
+    {
+        g_pui32Out[g_ui32Out] = ui32Size;
+        g_ppui8Out[g_ui32Out] = pui8Data;
+        g_ui32Out++;
+        memcpy(g_pui8Line + g_ui32Line, pui8Data, ui32Size);
+        g_ui32Line += ui32Size;
+    }
+
+    g_sUSBHSBackendSim.pfnPipeSchedule(ui32Pipe, pui8Data, ui32Size);
+}
+
+static uint32_t
+TestCallback(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgParam,
+             void *pvMsgData)
+{
+    if(ui32Event == USB_EVENT_CONNECTED)
+    {
+        g_psInstance = (tSerialInstance *)pvCBData;
+    }
+    else if((ui32Event == USB_EVENT_TX_COMPLETE) &&
+            (g_ui32Done < sizeof(g_psDone) / sizeof(g_psDone[0])))
+    {
+        g_psDone[g_ui32Done].pvData = pvMsgData;
+        g_psDone[g_ui32Done].ui32Size = ui32MsgParam;
+        g_ui32Done++;
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Runs the bus and the main loop for a number of frames, and forgets the
+// traffic of the previous test.
+//
+//*****************************************************************************
+static void
+TestRun(uint32_t ui32Frames)
+{
+    while(ui32Frames--)
+    {
+        USBHostSerialSimStep();
+        USBHostSerialProcess();
+    }
+}
+
+static void
+TestClear(void)
+{
+    g_ui32Out = 0;
+    g_ui32Line = 0;
+    g_ui32Done = 0;
+}
+
+//*****************************************************************************
+//
+// Appends segments to the expected line data and returns its new size.
+//
+//*****************************************************************************
+static uint32_t
+TestExpect(uint32_t ui32Pos, const tUSBHSIoVec *psVec, uint32_t ui32Count)
+{
+    while(ui32Count--)
+    {
+        memcpy(g_pui8Expect + ui32Pos, psVec->pvData, psVec->ui32Size);
+        ui32Pos += psVec->ui32Size;
+        psVec++;
+    }
+
+    return(ui32Pos);
+}
+
+//*****************************************************************************
+//
+// Checks the sizes of the bulk OUT transfers and the bytes sent.
+//
+//*****************************************************************************
+static void
+TestCheckOut(const uint32_t *pui32Sizes, uint32_t ui32Count,
+             uint32_t ui32Bytes)
+{
+    uint32_t ui32Idx;
+
+    USBHS_CHECK_EQUAL(g_ui32Out, ui32Count);
+    for(ui32Idx = 0; (ui32Idx < ui32Count) && (ui32Idx < g_ui32Out);
+        ui32Idx++)
+    {
+        USBHS_CHECK_EQUAL(g_pui32Out[ui32Idx], pui32Sizes[ui32Idx]);
+    }
+    USBHS_CHECK_EQUAL(g_ui32Line, ui32Bytes);
+    USBHS_CHECK(memcmp(g_pui8Line, g_pui8Expect, ui32Bytes) == 0);
+}
+
+//*****************************************************************************
+//
+// Producers of the submission queue test.  Each pushes its number and a
+// sequence count, and retries while the queue is full.  The threads yield
+// while they wait so that the test also runs quickly on a single core.
+//
+//*****************************************************************************
+#define TEST_PRODUCERS          2
+#define TEST_PUSHES             100000
+
+static tUSBHSQueue g_sQueue;
+static tUSBHSQueueEntry g_psEntries[8];
+
+static void *
+TestProducer(void *pvArg)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < TEST_PUSHES; ui32Idx++)
+    {
+        while(!USBHSQueuePush(&g_sQueue, pvArg, ui32Idx))
+        {
+            sched_yield();
+        }
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Several threads push to one queue while the main thread pops.  Every entry
+// must come out once, and the entries of each producer in order.
+//
+//*****************************************************************************
+static void
+TestQueue(void)
+{
+    pthread_t psThread[TEST_PRODUCERS];
+    uint32_t pui32Next[TEST_PRODUCERS];
+    uint32_t ui32Idx, ui32Value, ui32Popped, ui32Errors;
+    void *pvData;
+
+    USBHSQueueInit(&g_sQueue, g_psEntries,
+                   sizeof(g_psEntries) / sizeof(g_psEntries[0]));
+
+    for(ui32Idx = 0; ui32Idx < TEST_PRODUCERS; ui32Idx++)
+    {
+        pui32Next[ui32Idx] = 0;
+        pthread_create(&psThread[ui32Idx], 0, TestProducer,
+                       (void *)(uintptr_t)ui32Idx);
+    }
+
+    ui32Errors = 0;
+    for(ui32Popped = 0; ui32Popped < TEST_PRODUCERS * TEST_PUSHES; )
+    {
+        if(!USBHSQueuePop(&g_sQueue, &pvData, &ui32Value))
+        {
+            sched_yield();
+            continue;
+        }
+
+        ui32Idx = (uint32_t)(uintptr_t)pvData;
+        if((ui32Idx >= TEST_PRODUCERS) || (ui32Value != pui32Next[ui32Idx]))
+        {
+            ui32Errors++;
+        }
+        else
+        {
+            pui32Next[ui32Idx]++;
+        }
+        ui32Popped++;
+    }
+
+    for(ui32Idx = 0; ui32Idx < TEST_PRODUCERS; ui32Idx++)
+    {
+        pthread_join(psThread[ui32Idx], 0);
+        USBHS_CHECK_EQUAL(pui32Next[ui32Idx], TEST_PUSHES);
+    }
+    USBHS_CHECK_EQUAL(ui32Errors, 0);
+    USBHS_CHECK(USBHSQueueEmpty(&g_sQueue));
+}
+
+int
+main(void)
+{
+    //
+    // Segment boundaries inside packets, with empty segments in the middle
+    // and at the end.
+    //
+    static const tUSBHSIoVec psVecShort[5] =
+    {
+        { g_pui8Data, 5 },
+        { g_pui8Data + 5, 20 },
+        { g_pui8Data + 25, 0 },
+        { g_pui8Data + 25, 7 },
+        { g_pui8Data + 32, 0 }
+    };
+    static const uint32_t pui32Short[2] = { 16, 16 };
+
+    //
+    // A segment longer than a packet followed by a short one.  A DMA
+    // transfer from the long segment stops at its last full packet.
+    //
+    static const tUSBHSIoVec psVecLong[2] =
+    {
+        { g_pui8Data + 32, 40 },
+        { g_pui8Data + 72, 3 }
+    };
+#ifdef USBHS_DMA
+    static const uint32_t pui32Long[2] = { 32, 11 };
+#else
+    static const uint32_t pui32Long[3] = { 16, 16, 11 };
+#endif
+
+    static const tUSBHSIoVec psVecEmpty[2] =
+    {
+        { g_pui8Data, 0 },
+        { g_pui8Data + 1, 0 }
+    };
+    static const uint32_t pui32Zlp[1] = { 0 };
+
+    //
+    // A buffer, a segment list, a zero length write and a buffer queued
+    // together.
+    //
+    static const tUSBHSIoVec psVecQueue[3] =
+    {
+        { g_pui8Data + 100, 20 },
+        { g_pui8Data + 120, 0 },
+        { g_pui8Data + 120, 3 }
+    };
+#ifdef USBHS_DMA
+    static const uint32_t pui32Queue[5] = { 20, 16, 16, 0, 3 };
+#else
+    static const uint32_t pui32Queue[6] = { 16, 4, 16, 16, 0, 3 };
+#endif
+
+    const uint8_t *pui8Config;
+    uint32_t ui32Idx, ui32Bytes;
+
+    for(ui32Idx = 0; ui32Idx < sizeof(g_pui8Data); ui32Idx++)
+    {
+        g_pui8Data[ui32Idx] = (uint8_t)(ui32Idx * 7 + 1);
+    }
+
+    g_sBackend = g_sUSBHSBackendSim;
+    g_sBackend.pfnPipeSchedule = TestPipeSchedule;
+    USBHostSerialSetBackend(&g_sBackend);
+    USBHostSerialInit(TestCallback);
+
+    USBHostSerialSimSerialSetup(&g_sDevice, &g_sSerial, USBHS_SIM_CP210X);
+    pui8Config = g_sDevice.pui8Config;
+
+    //
+    // A bulk OUT endpoint with packets of 0 bytes or larger than
+    // USBHS_MAX_PACKET is not opened, and the pipes allocated for the device
+    // are given back every time.
+    //
+    for(ui32Idx = 0; ui32Idx < USBHS_SIM_PIPES; ui32Idx++)
+    {
+        g_sDevice.pui8Config =
+            TestConfigOut(pui8Config, (ui32Idx & 1) ? 0 : USBHS_MAX_PACKET + 1);
+        USBHS_CHECK(USBHostSerialSimConnect(&g_sDevice) == 0);
+    }
+    USBHS_CHECK(g_psInstance == 0);
+
+    g_sDevice.pui8Config = TestConfigOut(pui8Config, TEST_PACKET);
+    USBHS_CHECK(USBHostSerialSimConnect(&g_sDevice) != 0);
+    USBHS_CHECK(g_psInstance != 0);
+    if(g_psInstance == 0)
+    {
+        return(USBHS_TEST_END(TEST_NAME));
+    }
+    USBHostSerialSetupInstance(g_psInstance, TestCallback, 0);
+    USBHostSerialInitNewDevice(g_psInstance);
+    USBHostSerialSetLineConfig(g_psInstance, 115200, USBHS_CONF_DATA_8 |
+                               USBHS_CONF_PAR_NONE | USBHS_CONF_STOP_1);
+    TestRun(2);
+
+    //
+    // Every packet but the last is full, packed across segment boundaries
+    // and over the empty segments.
+    //
+    TestClear();
+    USBHS_CHECK_EQUAL(USBHostSerialWriteV(g_psInstance, psVecShort, 5), 0);
+    TestRun(10);
+    TestCheckOut(pui32Short, 2, TestExpect(0, psVecShort, 5));
+    USBHS_CHECK_EQUAL(g_ui32Done, 1);
+    USBHS_CHECK(g_psDone[0].pvData == psVecShort);
+    USBHS_CHECK_EQUAL(g_psDone[0].ui32Size, 32);
+
+    //
+    // Full packets of a long segment are sent straight from it.
+    //
+    TestClear();
+    USBHS_CHECK_EQUAL(USBHostSerialWriteV(g_psInstance, psVecLong, 2), 0);
+    TestRun(10);
+    TestCheckOut(pui32Long, sizeof(pui32Long) / sizeof(pui32Long[0]),
+                 TestExpect(0, psVecLong, 2));
+    USBHS_CHECK(g_ppui8Out[0] == g_pui8Data + 32);
+    USBHS_CHECK_EQUAL(g_ui32Done, 1);
+    USBHS_CHECK(g_psDone[0].pvData == psVecLong);
+    USBHS_CHECK_EQUAL(g_psDone[0].ui32Size, 43);
+
+    //
+    // A list of empty segments is refused, a zero length buffer is sent as a
+    // zero length packet.
+    //
+    TestClear();
+    USBHS_CHECK(USBHostSerialWriteV(g_psInstance, psVecEmpty, 2) != 0);
+    USBHS_CHECK(USBHostSerialWriteV(g_psInstance, psVecEmpty, 0) != 0);
+    USBHS_CHECK_EQUAL(USBHostSerialScheduleWrite(g_psInstance, g_pui8Data, 0),
+                      0);
+    TestRun(10);
+    TestCheckOut(pui32Zlp, 1, 0);
+    USBHS_CHECK_EQUAL(g_ui32Done, 1);
+    USBHS_CHECK(g_psDone[0].pvData == g_pui8Data);
+    USBHS_CHECK_EQUAL(g_psDone[0].ui32Size, 0);
+
+    //
+    // Writes queued behind each other are sent and completed in order.
+    //
+    TestClear();
+    USBHS_CHECK_EQUAL(USBHostSerialScheduleWrite(g_psInstance,
+                                                 g_pui8Data + 100, 20), 0);
+    USBHS_CHECK_EQUAL(USBHostSerialWriteV(g_psInstance, psVecShort, 5), 0);
+    USBHS_CHECK_EQUAL(USBHostSerialScheduleWrite(g_psInstance, g_pui8Data, 0),
+                      0);
+    USBHS_CHECK_EQUAL(USBHostSerialScheduleWrite(g_psInstance,
+                                                 g_pui8Data + 120, 3), 0);
+    TestRun(20);
+    ui32Bytes = TestExpect(0, psVecQueue, 1);
+    ui32Bytes = TestExpect(ui32Bytes, psVecShort, 5);
+    ui32Bytes = TestExpect(ui32Bytes, psVecQueue + 1, 2);
+    TestCheckOut(pui32Queue, sizeof(pui32Queue) / sizeof(pui32Queue[0]),
+                 ui32Bytes);
+    USBHS_CHECK_EQUAL(g_ui32Done, 4);
+    USBHS_CHECK(g_psDone[0].pvData == g_pui8Data + 100);
+    USBHS_CHECK_EQUAL(g_psDone[0].ui32Size, 20);
+    USBHS_CHECK(g_psDone[1].pvData == psVecShort);
+    USBHS_CHECK_EQUAL(g_psDone[1].ui32Size, 32);
+    USBHS_CHECK(g_psDone[2].pvData == g_pui8Data);
+    USBHS_CHECK_EQUAL(g_psDone[2].ui32Size, 0);
+    USBHS_CHECK(g_psDone[3].pvData == g_pui8Data + 120);
+    USBHS_CHECK_EQUAL(g_psDone[3].ui32Size, 3);
+
+    //
+    // The pipe takes the first write, the queue holds USBHS_TX_QUEUE_DEPTH
+    // more.
+    //
+    TestClear();
+    for(ui32Idx = 0; ui32Idx < USBHS_TX_QUEUE_DEPTH + 1; ui32Idx++)
+    {
+        USBHS_CHECK_EQUAL(USBHostSerialScheduleWrite(g_psInstance,
+                                                     g_pui8Data + ui32Idx, 1),
+                          0);
+    }
+    USBHS_CHECK(USBHostSerialScheduleWrite(g_psInstance, g_pui8Data, 1) != 0);
+    TestRun(20);
+    USBHS_CHECK_EQUAL(g_ui32Done, USBHS_TX_QUEUE_DEPTH + 1);
+    for(ui32Idx = 0; (ui32Idx < g_ui32Done) && (ui32Idx < g_ui32Out);
+        ui32Idx++)
+    {
+        USBHS_CHECK(g_psDone[ui32Idx].pvData == g_pui8Data + ui32Idx);
+        USBHS_CHECK(g_ppui8Out[ui32Idx] == g_pui8Data + ui32Idx);
+    }
+
+    TestQueue();
+
+    return(USBHS_TEST_END(TEST_NAME));
+}
@@ -0,0 +1,73 @@
+//*****************************************************************************
+//
+// usbhstest.h - Checks shared by the usbhserial host tests.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#ifndef __USBHSTEST_H__
+#define __USBHSTEST_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+//*****************************************************************************
+//
+// Minimal checking for the host test programs.  A failed check is printed
+// and counted, USBHS_TEST_END() prints the totals and gives the exit status.
+//
+//*****************************************************************************
+static uint32_t g_ui32TestChecks;
+static uint32_t g_ui32TestFailed;
+
+#define USBHS_CHECK(bCond)                                                    \
+    do                                                                        \
+    {                                                                         \
+        g_ui32TestChecks++;                                                   \
+        if(!(bCond))                                                          \
+        {                                                                     \
+            g_ui32TestFailed++;                                               \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #bCond);  \
+        }                                                                     \
+    }                                                                         \
+    while(0)
+
+#define USBHS_CHECK_EQUAL(ui32Got, ui32Expected)                              \
+    do                                                                        \
+    {                                                                         \
+        uint32_t ui32G = (uint32_t)(ui32Got);                                 \
+        uint32_t ui32E = (uint32_t)(ui32Expected);                            \
+        g_ui32TestChecks++;                                                   \
+        if(ui32G != ui32E)                                                    \
+        {                                                                     \
+            g_ui32TestFailed++;                                               \
+            printf("%s:%d: check failed: %s is 0x%x, expected 0x%x\n",        \
+                   __FILE__, __LINE__, #ui32Got, (unsigned)ui32G,             \
+                   (unsigned)ui32E);                                          \
+        }                                                                     \
+    }                                                                         \
+    while(0)
+
+#define USBHS_TEST_END(pcName)                                                \
+    (printf("%s: %u checks, %u failed\n", (pcName),                           \
+            (unsigned)g_ui32TestChecks, (unsigned)g_ui32TestFailed),          \
+     (g_ui32TestFailed != 0))
+
+#endif // __USBHSTEST_H__
@@ -34,703 +34,2952 @@
 #include "usblib/host/usbhostpriv.h"
 #include "usbhserial.h"
 #include "usbhserialdriver.h"
+#include "usbhserialcdc.h"
+#include "usbhserialcp210x.h"
+#include "usbhserialcapture.h"
+#include "usbhserialbackend.h"
+#include "usbhserialpriv.h"
+#include "usbhserialusblib.h"
 
-void *SerialDriverOpen(tUSBHostDevice *psDevice);
-void SerialDriverClose(void *pvInstance);
+tUSBCallback g_pfnGlobalAppCB = 0;
 
+#ifdef USBHS_STATIC_DRIVERS
 //*****************************************************************************
 //
-//! This constant global structure defines the CDC Class Driver that is
-//! provided with the USB library.
+// The driver set is fixed at build time.  Only the device matching fields are
+// kept in the table, driver operations are called directly through
+// USBHS_DRIVER_CALL() so drivers that are not selected are never referenced
+// and are left out by the linker.
 //
 //*****************************************************************************
-const tUSBHostClassDriver g_sUSBSerialCDCClassDriver =
+static const tUSBSerialDriver g_psDrivers[] =
 {
-    USB_CLASS_CDC,
-    SerialDriverOpen,
-    SerialDriverClose,
-    0
+#ifdef USBHS_STATIC_CDC
+    { USB_SERIAL_CDC_MATCH },
+#endif
+#ifdef USBHS_STATIC_CP210X
+    { USB_SERIAL_CP210X_MATCH },
+#endif
 };
 
-const tUSBHostClassDriver g_sUSBSerialVendorClassDriver =
-{
-    USB_CLASS_VEND_SPECIFIC,
-    SerialDriverOpen,
-    SerialDriverClose,
-    0
-};
+#define g_ui8NumDrivers         (sizeof(g_psDrivers) / sizeof(g_psDrivers[0]))
+#else
+extern tUSBSerialDriver g_psDrivers[];
+extern uint8_t g_ui8NumDrivers;
+#endif
 
 //*****************************************************************************
 //
-// Declare the USB Events driver interface.
+// Pipe types of the bulk endpoints.
 //
 //*****************************************************************************
-DECLARE_EVENT_DRIVER(g_sUSBEventDriver, 0, 0, USBHCDEvents);
+#ifdef USBHS_DMA
+#define USBHS_PIPE_BULK_IN      USBHCD_PIPE_BULK_IN_DMA
+#define USBHS_PIPE_BULK_OUT     USBHCD_PIPE_BULK_OUT_DMA
+#else
+#define USBHS_PIPE_BULK_IN      USBHCD_PIPE_BULK_IN
+#define USBHS_PIPE_BULK_OUT     USBHCD_PIPE_BULK_OUT
+#endif
+
+tSerialInstance g_psInstances[USBHS_MAX_INSTANCES];
+uint8_t g_ui8NumInstances = 0;
 
+#if USBHS_DEFERRED_INIT
 //*****************************************************************************
 //
-// The global that holds all of the host drivers in use in the application.
-// In this case, only the CDC class is loaded.
+// The instance whose queued setup USBHostSerialProcess() looks at next.
 //
 //*****************************************************************************
-static tUSBHostClassDriver const * const g_ppHostClassDrivers[] =
-{
-    &g_sUSBSerialCDCClassDriver,
-    &g_sUSBSerialVendorClassDriver,
-    &g_sUSBEventDriver
-};
+static uint8_t g_ui8NextSetup = 0;
+#define USBHS_SETUP_SIZE        sizeof(g_ui8NextSetup)
+#else
+#define USBHS_SETUP_SIZE        0
+#endif
+
+#if USBHS_SCRATCH_BUFFER
+uint8_t g_pui8TmpBuf[USB_TRANSFER_SIZE];
+#define USBHS_SCRATCH_SIZE      sizeof(g_pui8TmpBuf)
+#else
+#define USBHS_SCRATCH_SIZE      0
+#endif
 
 //*****************************************************************************
 //
-// This global holds the number of class drivers in the g_ppHostClassDrivers
-// list.
+// The application supplied time source, or 0 if none was registered.
 //
 //*****************************************************************************
-static const uint32_t g_ui32NumHostClassDrivers =
-    sizeof(g_ppHostClassDrivers) / sizeof(tUSBHostClassDriver *);
+tUSBHSClock g_pfnUSBHSClock = 0;
 
-tUSBCallback g_pfnGlobalAppCB = 0;
+#ifdef USBHS_BACKEND_TABLE
+//*****************************************************************************
+//
+// The host controller backend, set with USBHostSerialSetBackend().
+//
+//*****************************************************************************
+#ifdef USBHS_BACKEND_USBLIB
+const tUSBHSBackend *g_psUSBHSBackend = &g_sUSBHSBackendUsblib;
+#else
+const tUSBHSBackend *g_psUSBHSBackend = 0;
+#endif
+#endif
 
 //*****************************************************************************
 //
-// This is the generic callback from host stack.
+// Static RAM used by the library.  When USBHS_RAM_BUDGET is defined the build
+// fails if the library needs more than that many bytes.
+//
+//*****************************************************************************
+#define USBHS_STATIC_SIZE                                                    \
+        (sizeof(g_psInstances) + USBHS_SCRATCH_SIZE +                        \
+         sizeof(g_ui8NumInstances) + sizeof(g_pfnGlobalAppCB) +              \
+         sizeof(g_pfnUSBHSClock) + USBHS_CONFIG_SIZE + USBHS_SETUP_SIZE +   \
+         USBHS_IN_SIZE + USBHS_EVENT_SIZE + USBHS_POOL_SIZE)
+
+//*****************************************************************************
 //
-// \param pvData is actually a pointer to a tEventInfo structure.
+// Bytes of each instance taken by the options that cost the most RAM.
 //
-// This function will be called to inform the application when a USB event has
-// occurred that is outside those related to the CDC device.  At this
-// point this is used to detect unsupported devices being inserted and removed.
-// It is also used to inform the application when a power fault has occurred.
-// This function is required when the g_USBGenericEventDriver is included in
-// the host controller driver array that is passed in to the
-// USBHCDRegisterDrivers() function.
+//*****************************************************************************
+#if USBHS_TX_QUEUE_DEPTH > 0
+#define USBHS_TX_QUEUE_SIZE                                                  \
+        (sizeof(tUSBHSQueue) +                                               \
+         (USBHS_TX_QUEUE_DEPTH * sizeof(tUSBHSQueueEntry)))
+#else
+#define USBHS_TX_QUEUE_SIZE     0
+#endif
+
+#if USBHS_TX_GATHER
+#define USBHS_TX_GATHER_SIZE    USBHS_MAX_PACKET
+#else
+#define USBHS_TX_GATHER_SIZE    0
+#endif
+
+#if USBHS_INT_IN_PIPE
+#define USBHS_NOTIFY_BYTES      USBHS_NOTIFY_SIZE
+#else
+#define USBHS_NOTIFY_BYTES      0
+#endif
+
+const tUSBHSMemoryReport g_sUSBHSMemoryReport =
+{
+    sizeof(tSerialInstance),
+    USBHS_MAX_INSTANCES,
+    USBHS_SCRATCH_SIZE,
+    USBHS_STATIC_SIZE,
+    USBHS_TX_QUEUE_SIZE,
+    USBHS_TX_GATHER_SIZE,
+    USBHS_NOTIFY_BYTES
+};
+
+#ifdef USBHS_RAM_BUDGET
+typedef char tUSBHSRamBudgetCheck[(USBHS_STATIC_SIZE <= USBHS_RAM_BUDGET) ?
+                                  1 : -1];
+#endif
+
+//*****************************************************************************
 //
-// \return None.
+// Pipe access used by the data path.  Every pipe operation goes through these
+// helpers so that the capture module can substitute recorded traffic while a
+// log is replayed.
 //
 //*****************************************************************************
-void
-USBHCDEvents(void *pvData)
+#if !defined(USBHS_DMA) || USBHS_INT_IN_PIPE
+static uint32_t
+USBHSerialPipeSizeGet(uint32_t ui32Pipe)
+{
+#ifdef USBHS_CAPTURE
+    if(g_bUSBHSReplay)
+    {
+        return(g_ui32USBHSReplaySize);
+    }
+#endif
+
+    return(USBHS_BACKEND_CALL(PipeSizeGet, (ui32Pipe)));
+}
+
+static void
+USBHSerialPipeRead(uint32_t ui32Pipe, uint8_t *pui8Data, uint32_t ui32Size)
 {
-    tEventInfo *pEventInfo;
+#ifdef USBHS_CAPTURE
+    if(g_bUSBHSReplay)
+    {
+        memcpy(pui8Data, g_pui8USBHSReplayData, ui32Size);
+        return;
+    }
+#endif
+
+    USBHS_BACKEND_CALL(PipeRead, (ui32Pipe, pui8Data, ui32Size));
+}
+#endif
+
+#ifdef USBHS_DMA
+static uint32_t
+USBHSerialPipeTransferSizeGet(uint32_t ui32Pipe, uint8_t *pui8Data)
+{
+#ifdef USBHS_CAPTURE
+    if(g_bUSBHSReplay)
+    {
+        memcpy(pui8Data, g_pui8USBHSReplayData, g_ui32USBHSReplaySize);
+        return(g_ui32USBHSReplaySize);
+    }
+#endif
+
+    return(USBHS_BACKEND_CALL(PipeTransferSizeGet, (ui32Pipe)));
+}
+#endif
+
+static void
+USBHSerialPipeSchedule(uint32_t ui32Pipe, uint8_t *pui8Data, uint32_t ui32Size)
+{
+#ifdef USBHS_CAPTURE
+    if(g_bUSBHSReplay)
+    {
+        return;
+    }
+#endif
+
+    USBHS_BACKEND_CALL(PipeSchedule, (ui32Pipe, pui8Data, ui32Size));
+}
 
+//*****************************************************************************
+//
+// Returns the buffer received data is stored in, or 0 if there is none.
+//
+//*****************************************************************************
+static uint8_t *
+USBHSerialRxBuffer(tSerialInstance *psInstance)
+{
+#if USBHS_BRIDGE_BUFFERS
     //
-    // Cast this pointer to its actual type.
+    // A bridged device receives into the buffer reserved when its pipe was
+    // armed.
     //
-    pEventInfo = (tEventInfo *)pvData;
+    if(psInstance && psInstance->psBridge && psInstance->psBridge->bArmed)
+    {
+        return(psInstance->psBridge->pui8Data[psInstance->psBridge->ui32Filled %
+                                              USBHS_BRIDGE_BUFFERS]);
+    }
+#endif
 
-    switch(pEventInfo->ui32Event)
+    //
+    // An application buffer smaller than a packet is not used.
+    //
+    if(psInstance && psInstance->pvInBuffer &&
+       (psInstance->ui16InBufferSize >= psInstance->ui16PacketSizeIn))
     {
-        //
-        // New CDC device detected.
-        //
-        case USB_EVENT_CONNECTED:
-        {
+        return(psInstance->pvInBuffer);
+    }
 
-            break;
-        }
-        //
-        // Unsupported device detected.
-        //
-        case USB_EVENT_UNKNOWN_CONNECTED:
+#if USBHS_POOL_BLOCKS
+    //
+    // Otherwise the block taken from the pool when the pipe was armed.
+    //
+    if(psInstance && psInstance->pui8PoolRx)
+    {
+        return(psInstance->pui8PoolRx);
+    }
+#endif
+
+#if USBHS_SCRATCH_BUFFER
+    return(g_pui8TmpBuf);
+#else
+    return(0);
+#endif
+}
+
+//*****************************************************************************
+//
+//! Performs a control transfer on endpoint 0 of a serial device.
+//!
+//! \param psInstance is the serial instance the request is addressed to.
+//! \param psSetupPacket is the setup packet of the request.
+//! \param pui8Data is the data stage buffer.
+//! \param ui32Size is the size of the data stage.
+//!
+//! Serial drivers issue all their requests through this function rather than
+//! the host controller backend so that the requests can be captured.
+//!
+//! \return The number of bytes transferred in the data stage.
+//
+//*****************************************************************************
+uint32_t
+USBHSControlTransfer(tSerialInstance *psInstance, tUSBRequest *psSetupPacket,
+                     uint8_t *pui8Data, uint32_t ui32Size)
+{
+    uint32_t ui32Bytes;
+
+#ifdef USBHS_CAPTURE
+    //
+    // There is no device behind a replayed instance.
+    //
+    if(g_bUSBHSReplay)
+    {
+        if(pui8Data && (psSetupPacket->bmRequestType & USB_RTYPE_DIR_IN))
         {
-            if(g_pfnGlobalAppCB != 0)
-            {
-                g_pfnGlobalAppCB(0, USB_EVENT_UNKNOWN_CONNECTED, 0, 0);
-            }
-            break;
+            memset(pui8Data, 0, ui32Size);
         }
-        //
-        // Device has been unplugged.
-        //
-        case USB_EVENT_DISCONNECTED:
+        return(ui32Size);
+    }
+#endif
+
+    ui32Bytes = USBHS_BACKEND_CALL(ControlTransfer,
+                                   (psInstance->psDevice, psSetupPacket,
+                                    pui8Data, ui32Size));
+
+    USBHS_CAPTURE_EVENT(USBHS_CAP_CONTROL, psInstance, 0, psSetupPacket,
+                        sizeof(tUSBRequest), pui8Data, ui32Size);
+
+    return(ui32Bytes);
+}
+
+#if USBHS_RS485
+//*****************************************************************************
+//
+// RS-485 direction states.  A writer that finds the transceiver receiving
+// keeps ownership of the bulk OUT pipe and asks USBHostSerialProcess() to
+// switch it; the pipe is started once the switch and the pre-delay are done.
+// When the pipe runs empty the device is left to send what it holds, then
+// the post-delay passes and the transceiver is switched back.  A writer
+// arriving before that takes the transmission over again.
+//
+//*****************************************************************************
+#define RS485_OFF               0
+#define RS485_IDLE              1   // Receiving.
+#define RS485_ASSERT            2   // A writer waits for the switch.
+#define RS485_PRE               3   // Switched, waiting for the pre-delay.
+#define RS485_ACTIVE            4   // The bulk OUT pipe is sending.
+#define RS485_DRAIN             5   // The device still sends.
+#define RS485_POST              6   // Waiting for the post-delay.
+#define RS485_RELEASE           7   // Switching back.
+
+//*****************************************************************************
+//
+// Called by a writer that owns the bulk OUT pipe.  Returns true if the pipe
+// must not be started yet because the transceiver is not sending.
+//
+//*****************************************************************************
+static bool
+USBHSerialRs485Hold(tSerialInstance *psInstance)
+{
+    uint32_t ui32State;
+
+    for(;;)
+    {
+        ui32State = psInstance->ui32Rs485State;
+
+        if((ui32State == RS485_OFF) || (ui32State == RS485_ACTIVE))
         {
-            break;
+            return(false);
         }
-        //
-        // Power Fault has occurred.
-        //
-        case USB_EVENT_POWER_FAULT:
+
+        if((ui32State == RS485_DRAIN) || (ui32State == RS485_POST))
         {
-            if(g_pfnGlobalAppCB != 0)
+            if(USBHSAtomicCAS(&psInstance->ui32Rs485State, ui32State,
+                              RS485_ACTIVE))
             {
-                g_pfnGlobalAppCB(0, USB_EVENT_POWER_FAULT, 0, 0);
+                return(false);
             }
-            break;
+            continue;
         }
-        default:
+
+        if(ui32State == RS485_IDLE)
         {
-            break;
+            psInstance->ui32Rs485Queued = USBHSClockGet();
+            if(!USBHSAtomicCAS(&psInstance->ui32Rs485State, RS485_IDLE,
+                               RS485_ASSERT))
+            {
+                continue;
+            }
         }
+
+        return(true);
     }
 }
 
-extern tUSBSerialDriver g_psDrivers[];
-extern uint8_t g_ui8NumDrivers;
+//*****************************************************************************
+//
+// Called when the bulk OUT pipe was released with nothing left to send.
+//
+//*****************************************************************************
+static void
+USBHSerialRs485TxIdle(tSerialInstance *psInstance)
+{
+    psInstance->ui32Rs485Time = USBHSClockGet();
+    USBHSAtomicCAS(&psInstance->ui32Rs485State, RS485_ACTIVE, RS485_DRAIN);
+}
 
-tSerialInstance g_psInstances[10];
-uint8_t g_ui8NumInstances = 0;
+#define USBHS_RS485_TX_IDLE(psInstance)                                      \
+        USBHSerialRs485TxIdle(psInstance)
+#define USBHS_RS485_HOLD(psInstance)                                         \
+        USBHSerialRs485Hold(psInstance)
+#else
+#define USBHS_RS485_TX_IDLE(psInstance)
+#define USBHS_RS485_HOLD(psInstance)                                         \
+        false
+#endif
 
-uint8_t g_pui8TmpBuf[USB_TRANSFER_SIZE];
+//*****************************************************************************
+//
+// Marks a transmit queue entry holding a segment list and its count instead
+// of a buffer and its size.
+//
+//*****************************************************************************
+#define USBHS_TX_VECTOR         0x80000000
 
 //*****************************************************************************
 //
-//! This function handles event callbacks from the USB serial driver layer.
-//!
-//! \param pvCdc is the pointer that was passed in to the USBHCDCOpen()
-//! call.
-//! \param ui32Event is the event that has been passed up from the CDC driver.
-//! \param ui32MsgParam has meaning related to the \e ui32Event that occurred.
-//! \param pvMsgData has meaning related to the \e ui32Event that occurred.
-//!
-//! This function will receive all event updates from the CDC driver layer.
-//!
-//! \return Non-zero values should be assumed to indicate an error condition.
+// Makes a buffer or segment list taken from the transmit queue the one being
+// sent.
 //
 //*****************************************************************************
-void USBHSerialCallback(uint32_t ui32Pipe, uint32_t ui32Event)
+static void
+USBHSerialTxLoad(tSerialInstance *psInstance, void *pvData,
+                 uint32_t ui32Value)
 {
-    tSerialInstance *psInstance = 0;
-    int i;
+    const tUSBHSIoVec *psVec;
+    uint32_t ui32Size;
 
-    switch (ui32Event)
+    psInstance->pvTxBuffer = pvData;
+
+    if(ui32Value & USBHS_TX_VECTOR)
     {
         //
-        // Called when new data is available on the interrupt IN pipe.
+        // The first segment is loaded when the first packet is sent.
         //
-        case USB_EVENT_RX_AVAILABLE:
+        psVec = (const tUSBHSIoVec *)pvData;
+        ui32Value &= ~USBHS_TX_VECTOR;
+        for(ui32Size = 0; ui32Value != 0; ui32Value--)
         {
-            //
-            // Find instance using this pipe for IN endpoint
-            //
-            for(i = 0; i < g_ui8NumInstances; i++)
-            {
-                if(g_psInstances[i].bConnected && g_psInstances[i].ui32BulkInPipe == ui32Pipe)
-                {
-                    psInstance = g_psInstances + i;
-                    break;
-                }
-            }
-            //
-            // Check for how much data has been received.
-            //
-            uint16_t ui16Size = USBHCDPipeCurrentSizeGet(ui32Pipe);
+            ui32Size += psVec[ui32Value - 1].ui32Size;
+        }
 
-            //
-            // Read out the data into the USB IN buffer.
-            // Call this even if read size is 0 to reset pipe state
-            // Read to temporary buffer if application did not provide buffer
-            //
-            USBHCDPipeReadNonBlocking(ui32Pipe, (psInstance && psInstance->pvInBuffer) ? psInstance->pvInBuffer : g_pui8TmpBuf, (uint32_t)ui16Size);
+        psInstance->psTxVec = psVec;
+        psInstance->ui32TxSegment = 0;
+    }
+    else
+    {
+        ui32Size = ui32Value;
+        psInstance->pui8TxData = (uint8_t *)pvData;
+        psInstance->ui32TxSegment = ui32Size;
+    }
 
-            //
-            // If the callback exists then call it.
-            //
-            if(psInstance && psInstance->pfnCallback != 0 && ui16Size != 0)
-            {
-                psInstance->ui16PipeSizeIn = ui16Size;
-                //
-                // Notify the application about received data.
-                //
-                psInstance->pfnCallback(psInstance, ui32Event,
-                                          0,
-                                          psInstance->pvCBData);
-            }
+    psInstance->ui32TxRemaining = ui32Size;
+    psInstance->ui32TxSize = ui32Size;
+    psInstance->bTxZlp = (ui32Size == 0);
+}
 
-            break;
-        }
+//*****************************************************************************
+//
+// Takes the next transfer of at most *pui32Size bytes from the data being
+// sent and returns where it starts.  *pui32Size receives its size.  Data
+// crossing into the next segment is packed into the packet buffer, so every
+// packet but the last is full.
+//
+//*****************************************************************************
+static uint8_t *
+USBHSerialTxNext(tSerialInstance *psInstance, uint32_t *pui32Size)
+{
+    uint32_t ui32Size;
+    uint8_t *pui8Data;
+#if USBHS_TX_GATHER
+    uint32_t ui32Packet, ui32Done, ui32Copy;
+#endif
+
+    while(psInstance->ui32TxSegment == 0)
+    {
+        psInstance->pui8TxData = (uint8_t *)psInstance->psTxVec->pvData;
+        psInstance->ui32TxSegment = psInstance->psTxVec->ui32Size;
+        psInstance->psTxVec++;
+    }
+
+    ui32Size = *pui32Size;
+
+#if USBHS_TX_GATHER
+    ui32Packet = psInstance->ui16PipeSizeOut;
+    if(ui32Packet > sizeof(psInstance->pui8TxPacket))
+    {
+        ui32Packet = sizeof(psInstance->pui8TxPacket);
+    }
+    if((psInstance->ui32TxSegment < ui32Packet) &&
+       (psInstance->ui32TxSegment < psInstance->ui32TxRemaining))
+    {
         //
-        // Called when data has finished transferring on the interrupt OUT pipe.
+        // Pack the rest of this segment and the start of the following ones
+        // into one packet.
         //
-        case USB_EVENT_TX_COMPLETE:
+        if(ui32Size > ui32Packet)
         {
-            //
-            // Find instance using this pipe for OUT endpoint
-            //
-            for(i = 0; i < g_ui8NumInstances; i++)
+            ui32Size = ui32Packet;
+        }
+
+        for(ui32Done = 0; ui32Done < ui32Size; ui32Done += ui32Copy)
+        {
+            while(psInstance->ui32TxSegment == 0)
             {
-                if(g_psInstances[i].bConnected && g_psInstances[i].ui32BulkOutPipe == ui32Pipe)
-                {
-                    psInstance = g_psInstances + i;
-                    break;
-                }
+                psInstance->pui8TxData =
+                    (uint8_t *)psInstance->psTxVec->pvData;
+                psInstance->ui32TxSegment = psInstance->psTxVec->ui32Size;
+                psInstance->psTxVec++;
             }
-            //
-            // If the callback exists then call it.
-            //
-            if(psInstance && psInstance->pfnCallback != 0)
+
+            ui32Copy = ui32Size - ui32Done;
+            if(ui32Copy > psInstance->ui32TxSegment)
             {
-                //
-                // Notify the application that the TX Complete occurred.
-                //
-                psInstance->pfnCallback(psInstance, ui32Event,
-                                          0,
-                                          psInstance->pvCBData);
+                ui32Copy = psInstance->ui32TxSegment;
             }
 
-            break;
+            memcpy(psInstance->pui8TxPacket + ui32Done,
+                   psInstance->pui8TxData, ui32Copy);
+            psInstance->pui8TxData += ui32Copy;
+            psInstance->ui32TxSegment -= ui32Copy;
         }
 
-        //
-        // Called for polling if pipe is not busy.
-        //
-        case USB_EVENT_SCHEDULER:
-        {
-            //
-            // Find instance using this pipe for IN endpoint
-            //
-            for(i = 0; i < g_ui8NumInstances; i++)
-            {
-                if(g_psInstances[i].bConnected && g_psInstances[i].ui32BulkInPipe == ui32Pipe)
-                {
-                    psInstance = g_psInstances + i;
-                    break;
-                }
-            }
-            //
-            // Schedule TX request
-            //
-            USBHCDPipeSchedule(psInstance->ui32BulkInPipe, 0, 1);
+        psInstance->ui32TxRemaining -= ui32Size;
+        *pui32Size = ui32Size;
 
-            break;
-        }
+        return(psInstance->pui8TxPacket);
+    }
+#endif
 
+    //
+    // Send straight from the segment.  A transfer that stops inside the data
+    // ends on a packet boundary, the rest is packed with the next segment.
+    //
+    if(ui32Size > psInstance->ui32TxSegment)
+    {
+        ui32Size = psInstance->ui32TxSegment;
+#if USBHS_TX_GATHER
+        if(ui32Size < psInstance->ui32TxRemaining)
+        {
+            ui32Size -= ui32Size % ui32Packet;
+        }
+#endif
     }
+
+    pui8Data = psInstance->pui8TxData;
+    psInstance->pui8TxData += ui32Size;
+    psInstance->ui32TxSegment -= ui32Size;
+    psInstance->ui32TxRemaining -= ui32Size;
+    *pui32Size = ui32Size;
+
+    return(pui8Data);
 }
 
 //*****************************************************************************
 //
-// This function handles callbacks for the Interrupt IN endpoint.
+// Feeds the bulk OUT pipe from the transmit submission queue.
+//
+// The caller must own psInstance->ui32TxBusy.  The next packet of the current
+// buffer is scheduled, or the next buffer is taken from the queue.  When
+// nothing is left to send ownership is released, after which the queue is
+// checked once more so that a buffer pushed by a producer that lost the
+// ownership race is not left behind.  Without a queue ownership is released
+// as soon as the current buffer is done.
 //
 //*****************************************************************************
-void USBHSerialIntINCallback(uint32_t ulPipe, uint32_t ulEvent)
+static void
+USBHSerialTxStart(tSerialInstance *psInstance)
 {
-    tSerialInstance *psInstance = 0;
-    int i;
-    //
-    // Handles a request to schedule a new request on the interrupt IN
-    // pipe.
-    //
-    if(ulEvent == USB_EVENT_SCHEDULER)
+#if USBHS_TX_QUEUE_DEPTH > 0
+    void *pvData;
+#endif
+    uint32_t ui32Size;
+    uint8_t *pui8Data;
+
+    for(;;)
     {
-        //
-        // Find instance using this pipe for IN endpoint
-        //
-        for(i = 0; i < g_ui8NumInstances; i++)
+        if((psInstance->ui32TxRemaining == 0) && !psInstance->bTxZlp)
         {
-            if(g_psInstances[i].bConnected && g_psInstances[i].ui32BulkInPipe == ulPipe)
+#if USBHS_TX_QUEUE_DEPTH == 0
+            psInstance->ui32TxBusy = 0;
+            USBHS_RS485_TX_IDLE(psInstance);
+            return;
+#else
+            if(!USBHSQueuePop(&psInstance->sTxQueue, &pvData, &ui32Size))
             {
-                psInstance = g_psInstances + i;
-                break;
+                psInstance->ui32TxBusy = 0;
+                USBHSMemoryBarrier();
+
+                if(USBHSQueueEmpty(&psInstance->sTxQueue) ||
+                   !USBHSAtomicCAS(&psInstance->ui32TxBusy, 0, 1))
+                {
+                    USBHS_RS485_TX_IDLE(psInstance);
+                    return;
+                }
+                continue;
             }
+
+            USBHSerialTxLoad(psInstance, pvData, ui32Size);
+#endif
         }
+
         //
-        // Schedule TX request
+        // Send at most one packet, or one DMA transfer.  The state is updated
+        // before the pipe is scheduled because the completion interrupt may
+        // preempt a task caller as soon as the transfer starts.  An empty
+        // buffer is sent as a zero length packet and completes as usual.
         //
-        USBHCDPipeSchedule(psInstance->ui32BulkInPipe, 0, 1);
+        if(psInstance->bTxZlp)
+        {
+            psInstance->bTxZlp = false;
+            pui8Data = (uint8_t *)psInstance->pvTxBuffer;
+            ui32Size = 0;
+        }
+        else
+        {
+            ui32Size = psInstance->ui32TxRemaining;
+#ifdef USBHS_DMA
+            if(ui32Size > USBHS_DMA_MAX_TRANSFER)
+            {
+                ui32Size = USBHS_DMA_MAX_TRANSFER;
+            }
+#else
+            if(ui32Size > psInstance->ui16PipeSizeOut)
+            {
+                ui32Size = psInstance->ui16PipeSizeOut;
+            }
+#endif
+            pui8Data = USBHSerialTxNext(psInstance, &ui32Size);
+        }
+#if USBHS_RECOVERY_RETRIES
+        psInstance->pui8TxLast = pui8Data;
+        psInstance->ui16TxLast = ui32Size;
+#endif
+
+        USBHS_CAPTURE_EVENT(USBHS_CAP_TX, psInstance, 0, pui8Data, ui32Size,
+                            0, 0);
+
+        USBHSerialPipeSchedule(psInstance->ui32BulkOutPipe, pui8Data,
+                               ui32Size);
+
+        return;
+    }
+}
+
+//*****************************************************************************
+//
+// Reports a buffer the bulk OUT pipe is done with, to its bridge or to the
+// application.  ui32Size is the number of bytes sent.
+//
+//*****************************************************************************
+static void
+USBHSerialTxDone(tSerialInstance *psInstance, uint8_t *pui8Data,
+                 uint32_t ui32Size)
+{
+    if(!USBHS_BRIDGE_TX_DONE(psInstance, pui8Data) &&
+       (psInstance->pfnCallback != 0))
+    {
+        USBHS_CALLBACK(psInstance, USB_EVENT_TX_COMPLETE, ui32Size, pui8Data);
+    }
+}
+
+//*****************************************************************************
+//
+// Drops the data not yet sent after USBHostSerialPurge(), from the completion
+// of the bulk OUT pipe or before an RS-485 hold starts it.  The buffers are
+// reported with the number of bytes that were sent from them, so the
+// application may reuse them as usual.  bLoaded is false if no buffer was
+// taken from the queue yet.
+//
+//*****************************************************************************
+static void
+USBHSerialTxPurge(tSerialInstance *psInstance, bool bLoaded)
+{
+#if USBHS_TX_QUEUE_DEPTH > 0
+    void *pvData;
+    uint32_t ui32Size;
+#endif
+    uint32_t ui32Sent;
+
+    psInstance->bTxPurge = false;
+
+    ui32Sent = psInstance->ui32TxSize - psInstance->ui32TxRemaining;
+    psInstance->ui32TxRemaining = 0;
+    psInstance->bTxZlp = false;
+
+#if USBHS_TX_QUEUE_DEPTH == 0
+    psInstance->ui32TxBusy = 0;
+    USBHS_RS485_TX_IDLE(psInstance);
+    USBHSerialTxDone(psInstance, psInstance->pvTxBuffer, ui32Sent);
+#else
+    if(bLoaded)
+    {
+        USBHSerialTxDone(psInstance, psInstance->pvTxBuffer, ui32Sent);
+    }
+
+    while(USBHSQueuePop(&psInstance->sTxQueue, &pvData, &ui32Size))
+    {
+        USBHSerialTxDone(psInstance, (uint8_t *)pvData, 0);
     }
 
     //
-    // Called when new data is available on the interrupt IN pipe.
+    // Release the pipe, or send what was queued meanwhile.
     //
-    if(ulEvent == USB_EVENT_RX_AVAILABLE)
+    USBHSerialTxStart(psInstance);
+#endif
+}
+
+#if USBHS_RECOVERY_RETRIES
+//*****************************************************************************
+//
+// Frame numbers count modulo 2048.
+//
+//*****************************************************************************
+#define USBHS_FRAME_MASK        0x7FF
+
+//*****************************************************************************
+//
+// Marks a pipe that stalled or failed so that USBHostSerialProcess() clears
+// and restarts it.  The first halt after a recovery sets the time of the next
+// try, later ones until then are handled by the same try.
+//
+//*****************************************************************************
+static void
+USBHSerialPipeHalted(uint32_t ui32Pipe, uint32_t ui32Event)
+{
+    tSerialInstance *psInstance;
+    uint32_t ui32Halt, ui32Delay;
+    int i;
+
+    for(i = 0; i < g_ui8NumInstances; i++)
     {
-        //
-        // Find instance using this pipe for IN endpoint
-        //
-        for(i = 0; i < g_ui8NumInstances; i++)
+        psInstance = g_psInstances + i;
+        if(!psInstance->bConnected)
         {
-            if(g_psInstances[i].bConnected && g_psInstances[i].ui32BulkInPipe == ulPipe)
-            {
-                psInstance = g_psInstances + i;
-                break;
-            }
+            continue;
         }
-        //
-        // Check for how much data has been received.
-        //
-        uint16_t ui16Size = USBHCDPipeCurrentSizeGet(ulPipe);
 
-        //
-        // Read out the data into the USB IN buffer.
-        // Call this even if read size is 0 to reset pipe state
-        // Read to temporary buffer if application did not provide buffer
-        //
-        USBHCDPipeReadNonBlocking(ulPipe, (psInstance && psInstance->pvInBuffer) ? psInstance->pvInBuffer : g_pui8TmpBuf, (uint32_t)ui16Size);
+        if(psInstance->ui32BulkInPipe == ui32Pipe)
+        {
+            ui32Halt = USBHS_HALT_IN;
+        }
+        else if(psInstance->ui32BulkOutPipe == ui32Pipe)
+        {
+            ui32Halt = USBHS_HALT_OUT;
+        }
+#if USBHS_INT_IN_PIPE
+        else if(psInstance->ui32IntInPipe == ui32Pipe)
+        {
+            ui32Halt = USBHS_HALT_INT;
+        }
+#endif
+        else
+        {
+            continue;
+        }
 
-        //
-        // If the callback exists then call it.
-        //
-        if(psInstance && psInstance->pfnCallback != 0)
+        if(ui32Event == USB_EVENT_STALL)
         {
-            //
-            // Notify the application about received data.
-            //
-            psInstance->pfnCallback(psInstance, ulEvent,
-                                      0,
-                                      psInstance->pvCBData);
+            psInstance->sErrors.ui32Stalls++;
+        }
+        else
+        {
+            psInstance->sErrors.ui32Errors++;
+        }
+
+        if(psInstance->ui32Halted == 0)
+        {
+            ui32Delay = USBHS_RECOVERY_DELAY << psInstance->ui8Retries;
+            if(ui32Delay > (USBHS_FRAME_MASK >> 1))
+            {
+                ui32Delay = USBHS_FRAME_MASK >> 1;
+            }
+            psInstance->ui16RetryFrame = (USBHS_BACKEND_CALL(FrameGet, ()) +
+                                          ui32Delay) & USBHS_FRAME_MASK;
         }
+        psInstance->ui32Halted |= ui32Halt;
 
+        return;
     }
 }
+#endif
 
+#if USBHS_EVENT_QUEUE_DEPTH
 //*****************************************************************************
 //
-//! This function is used to open an instance of the serial driver.
+// Returns true if every receive buffer of an instance holds a packet whose
+// event has not been handled yet.
+//
+//*****************************************************************************
+static bool
+USBHSerialRxHeld(tSerialInstance *psInstance)
+{
+    uint8_t ui8Pending;
+
+    //
+    // Every packet received into the pool gets a block of its own.
+    //
+    if(USBHS_POOL_RX(psInstance))
+    {
+        return(false);
+    }
+
+    ui8Pending = psInstance->ui8RxQueued - psInstance->ui8RxHandled;
+
+#if USBHS_RX_REARM
+    if(psInstance->pvInBufferAlt != 0)
+    {
+        return(ui8Pending >= 2);
+    }
+#endif
+
+    return(ui8Pending != 0);
+}
+#endif
+
+//*****************************************************************************
+//
+// Arms the bulk IN pipe of an instance, unless the pipe is halted, the
+// receive buffer is still in use or the bridge or the frame budget hold the
+// device back.
+//
+//*****************************************************************************
+static void
+USBHSerialInArm(tSerialInstance *psInstance)
+{
+#ifdef USBHS_DMA
+    uint8_t *pui8Buffer;
+#endif
+
+#if USBHS_RECOVERY_RETRIES
+    //
+    // A halted pipe is polled again once it has been cleared.
+    //
+    if(psInstance->ui32Halted & USBHS_HALT_IN)
+    {
+        return;
+    }
+#endif
+
+#if USBHS_EVENT_QUEUE_DEPTH
+    //
+    // Keep the receive buffers until their packets were handled.
+    //
+    if(USBHSerialRxHeld(psInstance))
+    {
+        return;
+    }
+#endif
+
+    //
+    // A bridged device is only polled while one of the bridge
+    // buffers is free, which holds it back until the other device
+    // has caught up.
+    //
+    if(!USBHS_BRIDGE_ARM(psInstance))
+    {
+        return;
+    }
+
+    //
+    // A device receiving into the pool is only polled once it has a
+    // block, otherwise it NAKs until the application frees one.
+    //
+    if(!USBHS_POOL_ARM(psInstance))
+    {
+        return;
+    }
+
+    //
+    // With a frame budget the scheduler decides whether this device
+    // is polled now or at a later frame.
+    //
+    if(!USBHS_IN_ARM(psInstance))
+    {
+        return;
+    }
+
+#ifdef USBHS_DMA
+    //
+    // Let the DMA store the next packet straight into the receive
+    // buffer.  Without a buffer the device is not polled.
+    //
+    pui8Buffer = USBHSerialRxBuffer(psInstance);
+    if(pui8Buffer != 0)
+    {
+        USBHSerialPipeSchedule(psInstance->ui32BulkInPipe, pui8Buffer,
+                               psInstance->ui16PacketSizeIn);
+    }
+#else
+    //
+    // Schedule TX request
+    //
+    USBHSerialPipeSchedule(psInstance->ui32BulkInPipe, 0, 1);
+#endif
+}
+
+//*****************************************************************************
+//
+//! This function handles event callbacks from the USB serial driver layer.
 //!
-//! \param psDevice is a pointer to the device information structure.
+//! \param pvCdc is the pointer that was passed in to the USBHCDCOpen()
+//! call.
+//! \param ui32Event is the event that has been passed up from the CDC driver.
+//! \param ui32MsgParam has meaning related to the \e ui32Event that occurred.
+//! \param pvMsgData has meaning related to the \e ui32Event that occurred.
 //!
-//! This function will attempt to open an instance of the serial driver based on
-//! the information contained in the \e psDevice structure.  This call can fail
-//! if there are not sufficient resources to open the device.  The function
-//! returns a value that should be passed back into USBSerialClose() when the
-//! driver is no longer needed.
+//! This function will receive all event updates from the CDC driver layer.
 //!
-//! \return The function will return a pointer to a serial driver instance.
+//! \return Non-zero values should be assumed to indicate an error condition.
 //
 //*****************************************************************************
-void *SerialDriverOpen(tUSBHostDevice *psDevice)
+void USBHSerialCallback(uint32_t ui32Pipe, uint32_t ui32Event)
 {
-    int32_t i32Idx;
-    uint8_t NumOfInterfaces, i, j;
-    tEndpointDescriptor *psEndpointDescriptor;
-    tInterfaceDescriptor *psInterface;
-
-    NumOfInterfaces = psDevice->psConfigDescriptor->bNumInterfaces;
-
-    psInterface = USBDescGetInterface(psDevice->psConfigDescriptor, 0, 0);
+    tSerialInstance *psInstance = 0;
+    uint32_t ui32Start = USBHSClockGet();
+    int i;
 
-    for(i = 0; i < g_ui8NumDrivers; i++)
+    switch (ui32Event)
     {
-        if(g_psDrivers[i].ui32InterfaceClass == psInterface->bInterfaceClass)
+        //
+        // Called when new data is available on the interrupt IN pipe.
+        //
+        case USB_EVENT_RX_AVAILABLE:
         {
-            if(((g_psDrivers[i].ui16VID == 0) || (g_psDrivers[i].ui16VID == psDevice->sDeviceDescriptor.idVendor)) &&
-               ((g_psDrivers[i].ui16PID == 0) || (g_psDrivers[i].ui16PID == psDevice->sDeviceDescriptor.idProduct)))
+            //
+            // Find instance using this pipe for IN endpoint
+            //
+            for(i = 0; i < g_ui8NumInstances; i++)
             {
-                // Consider device is supported by the driver
-                tSerialInstance *psInstance = g_psInstances + g_ui8NumInstances;
+                if(g_psInstances[i].bConnected && g_psInstances[i].ui32BulkInPipe == ui32Pipe)
+                {
+                    psInstance = g_psInstances + i;
+                    break;
+                }
+            }
+#if USBHS_RX_TIMESTAMP
+            //
+            // Take the arrival time before anything else is done with the
+            // packet.
+            //
+            uint32_t ui32RxTime = USBHSClockGet();
+            uint16_t ui16RxFrame = (uint16_t)USBHS_BACKEND_CALL(FrameGet, ());
+#endif
+            uint8_t *pui8Buffer = USBHSerialRxBuffer(psInstance);
+#ifdef USBHS_DMA
+            //
+            // The DMA has already stored the data in the buffer that was
+            // given when the transfer was scheduled.
+            //
+            uint16_t ui16Size = pui8Buffer ?
+                    USBHSerialPipeTransferSizeGet(ui32Pipe, pui8Buffer) : 0;
+#else
+            //
+            // Check for how much data has been received.
+            //
+            uint16_t ui16Size = USBHSerialPipeSizeGet(ui32Pipe);
+
+            //
+            // Without a buffer the packet is dropped.
+            //
+            if(pui8Buffer == 0)
+            {
+                ui16Size = 0;
+            }
+
+            //
+            // Read out the data into the USB IN buffer.
+            // Call this even if read size is 0 to reset pipe state
+            // Read to temporary buffer if application did not provide buffer
+            //
+            USBHSerialPipeRead(ui32Pipe, pui8Buffer, (uint32_t)ui16Size);
+#endif
+
+            USBHS_CAPTURE_EVENT(USBHS_CAP_RX, psInstance, 0, pui8Buffer,
+                                ui16Size, 0, 0);
+            USBHS_IN_RECEIVED(psInstance, ui16Size);
+#if USBHS_RECOVERY_RETRIES
+            if(psInstance && (ui16Size != 0))
+            {
+                psInstance->ui8Retries = 0;
+            }
+#endif
+
+            //
+            // Bridged data goes to the other device instead of the
+            // application.  Otherwise, if the callback exists then call it.
+            //
+            bool bDeliver = !USBHS_BRIDGE_RECEIVED(psInstance, ui16Size) &&
+                            psInstance && (psInstance->pfnCallback != 0) &&
+                            (ui16Size != 0);
+            bool bRearm = false;
+
+            if(bDeliver)
+            {
+                psInstance->ui16PipeSizeIn = ui16Size;
+#if USBHS_POOL_BLOCKS
                 //
-                // Save the device pointer.
+                // A pool block now belongs to the application, the next
+                // packet is received into a new one.
                 //
-                psInstance->psDevice = psDevice;
-                psInstance->bConnected = true;
-                psInstance->pfnCallback = 0;
-                psInstance->pvInBuffer = 0;
-                psInstance->ui8Driver = (uint8_t)i;
+                if(pui8Buffer == psInstance->pui8PoolRx)
+                {
+                    psInstance->pui8PoolRx = 0;
+                }
+#endif
+#if USBHS_RX_TIMESTAMP
+                psInstance->ui32RxTime = ui32RxTime;
+                psInstance->ui16RxFrame = ui16RxFrame;
+#endif
+#if USBHS_RX_REARM
+                //
+                // Receive the next packet into the other buffer while the
+                // application handles this one.  Pool blocks and the scratch
+                // buffer are not part of the pair.
+                //
+                if((psInstance->pvInBufferAlt != 0) &&
+                   (pui8Buffer == psInstance->pvInBuffer))
+                {
+                    psInstance->pvInBuffer = psInstance->pvInBufferAlt;
+                    psInstance->pvInBufferAlt = pui8Buffer;
+                }
+#endif
+            }
 
-                for (j = 0; j < NumOfInterfaces; j++)
+#if USBHS_QUEUE_POLL
+            //
+            // While the device reported more data queued than has been
+            // received since, read it without waiting for the next poll.  A
+            // short packet means the device has nothing left.
+            //
+            if(psInstance && (psInstance->ui32DeviceQueue != 0))
+            {
+                if((ui16Size < psInstance->ui16PacketSizeIn) ||
+                   (ui16Size >= psInstance->ui32DeviceQueue))
                 {
-                    //
-                    // Get the interface descriptor for each interface
-                    //
-                    psInterface = USBDescGetInterface(psDevice->psConfigDescriptor, j, 0);
+                    psInstance->ui32DeviceQueue = 0;
+                }
+                else
+                {
+                    psInstance->ui32DeviceQueue -= ui16Size;
+                    bRearm = true;
+                }
+            }
+#endif
+#if USBHS_RX_REARM
+            //
+            // A device that sent data may have more, ask for it right away.
+            //
+            if(psInstance && (ui16Size != 0))
+            {
+                bRearm = true;
+            }
+#endif
 
+            //
+            // Arm the pipe before the application sees the packet, so the
+            // device is not left waiting for the callback.  With DMA the
+            // next packet would be written into the buffer the application
+            // reads, so without a second buffer the pipe is only armed after
+            // the callback.  A deferred callback only queues the event, which
+            // is done first so the pipe is held while both buffers are in
+            // use.
+            //
+            bool bLate = false;
+#if USBHS_EVENT_QUEUE_DEPTH
+            bLate = bRearm && bDeliver;
+#elif defined(USBHS_DMA)
+            if(bRearm && bDeliver &&
+               (USBHSerialRxBuffer(psInstance) == pui8Buffer))
+            {
+                bLate = true;
+            }
+#endif
+            if(bRearm && !bLate)
+            {
+                USBHSerialInArm(psInstance);
+            }
+
+            if(bDeliver)
+            {
+                //
+                // Notify the application about received data.
+                //
+                USBHS_CALLBACK(psInstance, ui32Event, ui16Size, pui8Buffer);
+            }
+
+            if(bLate)
+            {
+                USBHSerialInArm(psInstance);
+            }
+
+            break;
+        }
+        //
+        // Called when data has finished transferring on the interrupt OUT pipe.
+        //
+        case USB_EVENT_TX_COMPLETE:
+        {
+            //
+            // Find instance using this pipe for OUT endpoint
+            //
+            for(i = 0; i < g_ui8NumInstances; i++)
+            {
+                if(g_psInstances[i].bConnected && g_psInstances[i].ui32BulkOutPipe == ui32Pipe)
+                {
+                    psInstance = g_psInstances + i;
+                    break;
+                }
+            }
+            //
+            // Ignore completions when no transfer is in flight.
+            //
+            if((psInstance == 0) || (psInstance->ui32TxBusy == 0))
+            {
+                break;
+            }
+
+            USBHS_CAPTURE_EVENT(USBHS_CAP_TX_COMPLETE, psInstance, 0, 0, 0,
+                                0, 0);
+#if USBHS_RECOVERY_RETRIES
+            psInstance->ui8Retries = 0;
+#endif
+
+            if(psInstance->bTxPurge)
+            {
+                USBHSerialTxPurge(psInstance, true);
+                break;
+            }
+
+            //
+            // If the whole buffer has been sent and the callback exists then
+            // call it with the completed buffer.
+            //
+            if(psInstance->ui32TxRemaining == 0)
+            {
+#if USBHS_TX_QUEUE_DEPTH == 0
+                //
+                // Without a queue the pipe is free once the buffer is done,
+                // so the application may send the next one from the
+                // callback.
+                //
+                psInstance->ui32TxBusy = 0;
+                USBHS_RS485_TX_IDLE(psInstance);
+#endif
+                //
+                // Notify the application that the TX Complete occurred.
+                //
+                USBHSerialTxDone(psInstance, psInstance->pvTxBuffer,
+                                 psInstance->ui32TxSize);
+#if USBHS_TX_QUEUE_DEPTH == 0
+                break;
+#endif
+            }
+
+            //
+            // Continue with the rest of the submission queue.
+            //
+            USBHSerialTxStart(psInstance);
+
+            break;
+        }
+
+        //
+        // Called for polling if pipe is not busy.
+        //
+        case USB_EVENT_SCHEDULER:
+        {
+            //
+            // Find instance using this pipe for IN endpoint
+            //
+            for(i = 0; i < g_ui8NumInstances; i++)
+            {
+                if(g_psInstances[i].bConnected && g_psInstances[i].ui32BulkInPipe == ui32Pipe)
+                {
+                    psInstance = g_psInstances + i;
+                    break;
+                }
+            }
+            if(psInstance == 0)
+            {
+                break;
+            }
+
+            USBHS_CAPTURE_EVENT(USBHS_CAP_SCHEDULER, psInstance, 0, 0, 0, 0, 0);
+
+            USBHSerialInArm(psInstance);
+
+            break;
+        }
+
+#if USBHS_RECOVERY_RETRIES
+        //
+        // Called when the device stalled the pipe or the transfer failed.
+        //
+        case USB_EVENT_STALL:
+        case USB_EVENT_ERROR:
+        {
+            USBHSerialPipeHalted(ui32Pipe, ui32Event);
+
+            break;
+        }
+#endif
+    }
+
+    USBHSIsrTime(ui32Start);
+}
+
+#if USBHS_INT_IN_PIPE
+//*****************************************************************************
+//
+// This function handles callbacks for the Interrupt IN endpoint.
+//
+//*****************************************************************************
+void USBHSerialIntINCallback(uint32_t ulPipe, uint32_t ulEvent)
+{
+    tSerialInstance *psInstance = 0;
+    uint32_t ui32Start = USBHSClockGet();
+    int i;
+    //
+    // Handles a request to schedule a new request on the interrupt IN
+    // pipe.
+    //
+    if(ulEvent == USB_EVENT_SCHEDULER)
+    {
+        //
+        // Find instance using this pipe for IN endpoint
+        //
+        for(i = 0; i < g_ui8NumInstances; i++)
+        {
+            if(g_psInstances[i].bConnected && g_psInstances[i].ui32IntInPipe == ulPipe)
+            {
+                psInstance = g_psInstances + i;
+                break;
+            }
+        }
+        //
+        // Schedule TX request
+        //
+#if USBHS_RECOVERY_RETRIES
+        if((psInstance != 0) && (psInstance->ui32Halted & USBHS_HALT_INT))
+        {
+            psInstance = 0;
+        }
+#endif
+#if USBHS_EVENT_QUEUE_DEPTH
+        //
+        // Keep the notification until its event was handled.
+        //
+        if((psInstance != 0) && psInstance->bNotifyQueued)
+        {
+            psInstance = 0;
+        }
+#endif
+        if(psInstance != 0)
+        {
+            USBHSerialPipeSchedule(psInstance->ui32IntInPipe, 0, 1);
+        }
+    }
+
+#if USBHS_RECOVERY_RETRIES
+    //
+    // Called when the device stalled the pipe or the transfer failed.
+    //
+    if((ulEvent == USB_EVENT_STALL) || (ulEvent == USB_EVENT_ERROR))
+    {
+        USBHSerialPipeHalted(ulPipe, ulEvent);
+    }
+#endif
+
+    //
+    // Called when new data is available on the interrupt IN pipe.
+    //
+    if(ulEvent == USB_EVENT_RX_AVAILABLE)
+    {
+        //
+        // Find instance using this pipe for IN endpoint
+        //
+        for(i = 0; i < g_ui8NumInstances; i++)
+        {
+            if(g_psInstances[i].bConnected && g_psInstances[i].ui32IntInPipe == ulPipe)
+            {
+                psInstance = g_psInstances + i;
+                break;
+            }
+        }
+        //
+        // Check for how much data has been received.
+        //
+        uint16_t ui16Size = USBHSerialPipeSizeGet(ulPipe);
+        uint8_t *pui8Buffer = psInstance ? psInstance->pui8Notify : 0;
+
+        //
+        // The notification is read into its own buffer, longer ones are cut
+        // short.  Without an instance the packet is dropped.
+        //
+        if(pui8Buffer == 0)
+        {
+            ui16Size = 0;
+        }
+        else if(ui16Size > USBHS_NOTIFY_SIZE)
+        {
+            ui16Size = USBHS_NOTIFY_SIZE;
+        }
+
+        //
+        // Read out the data.  Call this even if read size is 0 to reset pipe
+        // state.
+        //
+        USBHSerialPipeRead(ulPipe, pui8Buffer, (uint32_t)ui16Size);
+
+        USBHS_CAPTURE_EVENT(USBHS_CAP_INT_RX, psInstance, 0, pui8Buffer,
+                            ui16Size, 0, 0);
+
+        //
+        // If the callback exists then call it.
+        //
+        if(psInstance && psInstance->pfnCallback != 0)
+        {
+            //
+            // Pass the notification to the application.
+            //
+            USBHS_CALLBACK(psInstance, USBHS_EVENT_NOTIFY, ui16Size,
+                           pui8Buffer);
+        }
+
+    }
+
+    USBHSIsrTime(ui32Start);
+}
+#endif
+
+//*****************************************************************************
+//
+// Returns an instance to the state of a freshly connected device with no
+// pipes allocated and an empty transmit submission queue.
+//
+//*****************************************************************************
+void
+USBHSerialInstanceReset(tSerialInstance *psInstance)
+{
+    psInstance->pfnCallback = 0;
+    psInstance->pvInBuffer = 0;
+#if USBHS_RX_REARM
+    psInstance->pvInBufferAlt = 0;
+#endif
+    psInstance->ui32BulkInPipe = 0;
+    psInstance->ui32BulkOutPipe = 0;
+    psInstance->ui8BulkInEndpoint = 0;
+    psInstance->ui8BulkOutEndpoint = 0;
+#if USBHS_INT_IN_PIPE
+    psInstance->ui32IntInPipe = 0;
+    psInstance->ui8IntInEndpoint = 0;
+#endif
+
+#if USBHS_TX_QUEUE_DEPTH > 0
+    USBHSQueueInit(&psInstance->sTxQueue, psInstance->psTxEntries,
+                   USBHS_TX_QUEUE_DEPTH);
+#endif
+    psInstance->ui32TxBusy = 0;
+    psInstance->ui32TxRemaining = 0;
+    psInstance->bTxZlp = false;
+    psInstance->bTxPurge = false;
+    psInstance->ui16PipeSizeOut = USB_TRANSFER_SIZE;
+    psInstance->ui16PacketSizeIn = USB_TRANSFER_SIZE;
+    psInstance->ui16InBufferSize = USB_TRANSFER_SIZE;
+    psInstance->ui8Variant = 0;
+
+#if USBHS_POOL_BLOCKS
+    psInstance->pui8PoolRx = 0;
+    psInstance->ui32PoolUsed = 0;
+    psInstance->ui32PoolDenied = 0;
+    psInstance->ui8PoolQuota = USBHS_POOL_QUOTA;
+#endif
+
+#if USBHS_DEFERRED_INIT
+    psInstance->sPending.ui32Items = 0;
+#endif
+
+    USBHS_IN_RESET(psInstance);
+
+#if USBHS_EVENT_QUEUE_DEPTH
+    psInstance->ui8RxQueued = 0;
+    psInstance->ui8RxHandled = 0;
+#if USBHS_INT_IN_PIPE
+    psInstance->bNotifyQueued = false;
+#endif
+#endif
+
+#if USBHS_QUEUE_POLL
+    psInstance->ui32DeviceQueue = 0;
+    psInstance->ui16QueueFrame = 0;
+    psInstance->bQueueUnknown = false;
+#endif
+
+#if USBHS_RS485
+    psInstance->ui32Rs485State = RS485_OFF;
+#endif
+
+#if USBHS_RECOVERY_RETRIES
+    psInstance->ui32Halted = 0;
+    psInstance->ui8Retries = 0;
+    psInstance->sErrors.ui32Stalls = 0;
+    psInstance->sErrors.ui32Errors = 0;
+    psInstance->sErrors.ui32Recoveries = 0;
+    psInstance->sErrors.ui32Failures = 0;
+#endif
+}
+
+//*****************************************************************************
+//
+// Frees the pipes allocated for an instance.
+//
+//*****************************************************************************
+static void
+USBHSerialPipesFree(tSerialInstance *psInst)
+{
+#if USBHS_INT_IN_PIPE
+    //
+    // Free the Interrupt IN pipe.
+    //
+    if(psInst->ui32IntInPipe != 0)
+    {
+        USBHS_BACKEND_CALL(PipeFree, (psInst->ui32IntInPipe));
+    }
+#endif
+
+    //
+    // Free the Bulk IN pipe.
+    //
+    if(psInst->ui32BulkInPipe != 0)
+    {
+        USBHS_BACKEND_CALL(PipeFree, (psInst->ui32BulkInPipe));
+    }
+
+    //
+    // Free the Bulk OUT pipe.
+    //
+    if(psInst->ui32BulkOutPipe != 0)
+    {
+        USBHS_BACKEND_CALL(PipeFree, (psInst->ui32BulkOutPipe));
+    }
+}
+
+//*****************************************************************************
+//
+//! This function is used to open an instance of the serial driver.
+//!
+//! \param psDevice is a pointer to the device information structure.
+//!
+//! This function will attempt to open an instance of the serial driver based on
+//! the information contained in the \e psDevice structure.  This call can fail
+//! if there are not sufficient resources to open the device.  The function
+//! returns a value that should be passed back into USBSerialClose() when the
+//! driver is no longer needed.
+//!
+//! \return The function will return a pointer to a serial driver instance.
+//
+//*****************************************************************************
+void *SerialDriverOpen(tUSBHostDevice *psDevice)
+{
+    int32_t i32Idx;
+    uint8_t NumOfInterfaces, i, j;
+    tEndpointDescriptor *psEndpointDescriptor;
+    tInterfaceDescriptor *psInterface;
+    tSerialInstance *psInstance;
+    uint32_t ui32Restored = 0;
+    bool bUsable = true;
+
+    //
+    // Reuse the first instance that is not connected.
+    //
+    for(i = 0; i < USBHS_MAX_INSTANCES; i++)
+    {
+        if(!g_psInstances[i].bConnected)
+        {
+            break;
+        }
+    }
+    if(i == USBHS_MAX_INSTANCES)
+    {
+        return 0;
+    }
+    psInstance = g_psInstances + i;
+
+    NumOfInterfaces = psDevice->psConfigDescriptor->bNumInterfaces;
+
+    psInterface = USBDescGetInterface(psDevice->psConfigDescriptor, 0, 0);
+
+    for(i = 0; i < g_ui8NumDrivers; i++)
+    {
+        if(g_psDrivers[i].ui32InterfaceClass == psInterface->bInterfaceClass)
+        {
+            if(((g_psDrivers[i].ui16VID == 0) || (g_psDrivers[i].ui16VID == psDevice->sDeviceDescriptor.idVendor)) &&
+               ((g_psDrivers[i].ui16PID == 0) || (g_psDrivers[i].ui16PID == psDevice->sDeviceDescriptor.idProduct)))
+            {
+                // Consider device is supported by the driver
+                //
+                // Save the device pointer.
+                //
+                USBHSerialInstanceReset(psInstance);
+                psInstance->psDevice = psDevice;
+                psInstance->bConnected = true;
+                psInstance->ui8Driver = (uint8_t)i;
+
+                for (j = 0; j < NumOfInterfaces; j++)
+                {
+                    //
+                    // Get the interface descriptor for each interface
+                    //
+                    psInterface = USBDescGetInterface(psDevice->psConfigDescriptor, j, 0);
+
+                    //
+                    // Loop through the endpoints of the device.
+                    //
+                    for(i32Idx = 0; i32Idx < 3; i32Idx++)
+                    {
+                        //
+                        // Get the interrupt endpoint descriptor
+                        //
+                        psEndpointDescriptor =
+                                USBDescGetInterfaceEndpoint(psInterface, i32Idx,
+                                                            psDevice->ui32ConfigDescriptorSize);
+
+                        //
+                        // If no more endpoints then break out.
+                        //
+                        if(psEndpointDescriptor == 0)
+                        {
+                            break;
+                        }
+
+                        //
+                        // See if this is a bulk endpoint.
+                        //
+                        if((psEndpointDescriptor->bmAttributes & USB_EP_ATTR_TYPE_M) ==
+                                USB_EP_ATTR_BULK)
+                        {
+                            //
+                            // See if this is bulk IN or bulk OUT.
+                            //
+                            if(psEndpointDescriptor->bEndpointAddress & USB_EP_DESC_IN)
+                            {
+                                //
+                                // A packet that does not fit the receive
+                                // buffers cannot be received.
+                                //
+                                if((psEndpointDescriptor->wMaxPacketSize == 0) ||
+                                   (psEndpointDescriptor->wMaxPacketSize > USBHS_MAX_PACKET))
+                                {
+                                    bUsable = false;
+                                    continue;
+                                }
+                                psInstance->ui16PacketSizeIn =
+                                        psEndpointDescriptor->wMaxPacketSize;
+
+                                //
+                                // Allocate the USB Pipe for this Bulk IN endpoint.
+                                //
+                                psInstance->ui32BulkInPipe =
+                                        USBHS_BACKEND_CALL(PipeAlloc,
+                                                (USBHS_PIPE_BULK_IN, psDevice,
+                                                 psEndpointDescriptor->wMaxPacketSize,
+                                                 USBHSerialCallback));
+                                //
+                                // Configure the USB pipe as a Bulk IN endpoint.
+                                //
+                                USBHS_BACKEND_CALL(PipeConfig,
+                                        (psInstance->ui32BulkInPipe,
+                                         psEndpointDescriptor->wMaxPacketSize,
+                                         g_psDrivers[i].bPolling ? g_psDrivers[i].ui32Interval : 0,
+                                         ((psEndpointDescriptor->bEndpointAddress) &
+                                                 USB_EP_DESC_NUM_M)));
+                                psInstance->ui8BulkInEndpoint =
+                                        psEndpointDescriptor->bEndpointAddress;
+                            }
+                            else
+                            {
+                                //
+                                // Packets packed from several segments are
+                                // built in a buffer of USBHS_MAX_PACKET bytes.
+                                //
+                                if((psEndpointDescriptor->wMaxPacketSize == 0) ||
+                                   (psEndpointDescriptor->wMaxPacketSize > USBHS_MAX_PACKET))
+                                {
+                                    bUsable = false;
+                                    continue;
+                                }
+
+                                //
+                                // Allocate the USB Pipe for this Bulk OUT endpoint.
+                                //
+                                psInstance->ui32BulkOutPipe =
+                                        USBHS_BACKEND_CALL(PipeAlloc,
+                                                (USBHS_PIPE_BULK_OUT, psDevice,
+                                                 psEndpointDescriptor->wMaxPacketSize,
+                                                 USBHSerialCallback));
+                                //
+                                // Configure the USB pipe as a Bulk OUT endpoint.
+                                //
+                                USBHS_BACKEND_CALL(PipeConfig,
+                                        (psInstance->ui32BulkOutPipe,
+                                         psEndpointDescriptor->wMaxPacketSize,
+                                         0, (psEndpointDescriptor->bEndpointAddress &
+                                                 USB_EP_DESC_NUM_M)));
+
+                                //
+                                // Transmit buffers are split into packets of
+                                // this size.
+                                //
+                                psInstance->ui16PipeSizeOut =
+                                        psEndpointDescriptor->wMaxPacketSize;
+                                psInstance->ui8BulkOutEndpoint =
+                                        psEndpointDescriptor->bEndpointAddress;
+                            }
+                        }
+
+#if USBHS_INT_IN_PIPE
+                        if(!g_psDrivers[i].bPolling)
+                        {
+                            //
+                            // See if this is an interrupt endpoint.
+                            //
+                            if((psEndpointDescriptor->bmAttributes & USB_EP_ATTR_TYPE_M) ==
+                                    USB_EP_ATTR_INT)
+                            {
+                                //
+                                // See if this is interrupt IN endpoint.
+                                //
+                                if(psEndpointDescriptor->bEndpointAddress & USB_EP_DESC_IN)
+                                {
+                                    //
+                                    // Allocate the USB Pipe for this Interrupt IN endpoint.
+                                    // The FIFO is the 64 bytes
+                                    // USBHCDPipeAlloc() gives a pipe.
+                                    //
+                                    psInstance->ui32IntInPipe =
+                                            USBHS_BACKEND_CALL(PipeAlloc,
+                                                    (USBHCD_PIPE_INTR_IN, psDevice,
+                                                     64, USBHSerialIntINCallback));
+
+                                    //
+                                    // Configure the USB pipe as a Interrupt IN endpoint.
+                                    //
+                                    USBHS_BACKEND_CALL(PipeConfig,
+                                            (psInstance->ui32IntInPipe,
+                                             psEndpointDescriptor->wMaxPacketSize,
+                                             psEndpointDescriptor->bInterval,
+                                             (psEndpointDescriptor->bEndpointAddress &
+                                                     USB_EP_DESC_NUM_M)));
+                                    psInstance->ui8IntInEndpoint =
+                                            psEndpointDescriptor->bEndpointAddress;
+                                }
+                            }
+                        }
+#endif
+                    }
+                }
+
+                //
+                // Every interface has been searched for endpoints.  A device
+                // whose packets do not fit is not used.
+                //
+                if(!bUsable)
+                {
                     //
-                    // Loop through the endpoints of the device.
-                    //
-                    for(i32Idx = 0; i32Idx < 3; i32Idx++)
+                    // Nothing else was set up, so give back the pipes and
+                    // the instance without reporting a disconnect.
+                    //
+                    USBHSerialPipesFree(psInstance);
+                    psInstance->psDevice = 0;
+                    psInstance->bConnected = false;
+                    return 0;
+                }
+
+                USBHS_CAPTURE_EVENT(USBHS_CAP_CONNECT, psInstance,
+                                    psDevice->sDeviceDescriptor.idVendor |
+                                    ((uint32_t)psDevice->sDeviceDescriptor.idProduct << 16),
+                                    0, 0, 0, 0);
+
+#if USBHS_CONFIG_STORE
+                //
+                // Apply the configuration the device had when it was
+                // last connected.
+                //
+                ui32Restored = USBHSConfigRestore(psInstance) ?
+                               USBHS_CONNECTED_RESTORED : 0;
+#endif
+
+                //
+                // If global callback exist, call it
+                //
+                if(g_pfnGlobalAppCB != 0)
+                {
+                    g_pfnGlobalAppCB(
+                            psInstance,
+                            USB_EVENT_CONNECTED,
+                            ui32Restored, 0);
+                }
+
+                //
+                // Callbacks search the instances up to the highest one
+                // in use.
+                //
+                if(g_ui8NumInstances <= psInstance - g_psInstances)
+                {
+                    g_ui8NumInstances = psInstance - g_psInstances + 1;
+                }
+
+                return (void *)psInstance;
+            }
+        }
+    }
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//! This function is used to release an instance of the CDC driver.
+//!
+//! \param pvInstance is an instance pointer that needs to be released.
+//!
+//! This function will free up any resources in use by the CDC driver instance
+//! that is passed in.  The \e pvInstance pointer should be a valid value that
+//! was returned from a call to USBCDCOpen().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SerialDriverClose(void *pvInstance)
+{
+    tSerialInstance *psInst;
+
+    //
+    // Get our instance pointer.
+    //
+    psInst = (tSerialInstance *)pvInstance;
+
+    USBHS_CAPTURE_EVENT(USBHS_CAP_DISCONNECT, psInst, 0, 0, 0, 0, 0);
+
+    //
+    // Reset the device pointer.
+    //
+    psInst->psDevice = 0;
+    psInst->bConnected = false;
+
+    USBHS_BRIDGE_CLOSE(psInst);
+
+    USBHSerialPipesFree(psInst);
+
+    //
+    // Give the receive block back to the pool.
+    //
+    USBHS_POOL_CLOSE(psInst);
+
+    //
+    // If the callback exists, call it with a DISCONNECTED event.
+    //
+    if(psInst->pfnCallback != 0)
+    {
+        psInst->pfnCallback(psInst, USB_EVENT_DISCONNECTED,
+                            0, 0);
+    }
+}
+
+//*****************************************************************************
+//
+//! This function is used to initialize serial driver layer.
+//!
+//! \param pfnCallback is callback function used to handle USB_EVENT_CONNECTED
+//!
+//! \return None.
+//
+//*****************************************************************************
+uint32_t USBHostSerialInit(tUSBCallback pfnCallback)
+{
+    //
+    // Let the backend register the host class drivers.
+    //
+    USBHS_BACKEND_CALL(Init, ());
+
+    USBHS_POOL_INIT();
+
+    g_pfnGlobalAppCB = pfnCallback;
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//! Selects the host controller backend.
+//!
+//! \param psBackend is the backend, for example \b g_sUSBHSBackendSim.
+//!
+//! Only a library built with USBHS_BACKEND_TABLE has a choice of backend;
+//! otherwise it always uses usblib and the call does nothing.  Call this
+//! before USBHostSerialInit().  The usblib backend is the default when the
+//! library is built with USBHS_BACKEND_USBLIB.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialSetBackend(const tUSBHSBackend *psBackend)
+{
+#ifdef USBHS_BACKEND_TABLE
+    g_psUSBHSBackend = psBackend;
+#endif
+}
+
+//*****************************************************************************
+//
+//! Announces a device found by a backend.
+//!
+//! \param psDevice describes the device, with its device descriptor, address
+//! and configuration descriptor.  It must stay valid until the device is
+//! disconnected.
+//!
+//! Backends other than usblib call this when a device appeared.  The device
+//! is matched against the drivers and \b USB_EVENT_CONNECTED is sent to the
+//! global callback as with usblib.
+//!
+//! \return The instance of the device, or 0 if no driver supports it or all
+//! instances are in use.
+//
+//*****************************************************************************
+void *
+USBHostSerialBackendConnect(tUSBHostDevice *psDevice)
+{
+    return(SerialDriverOpen(psDevice));
+}
+
+//*****************************************************************************
+//
+//! Removes a device announced with USBHostSerialBackendConnect().
+//!
+//! \param pvInstance is the instance returned when the device was announced.
+//!
+//! The pipes of the device are freed and \b USB_EVENT_DISCONNECTED is sent to
+//! the instance callback.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialBackendDisconnect(void *pvInstance)
+{
+    if(pvInstance != 0)
+    {
+        SerialDriverClose(pvInstance);
+    }
+}
+
+//*****************************************************************************
+//
+//! This function registers the time source used for timestamps.
+//!
+//! \param pfnClock is a function returning a free running tick counter, for
+//! example the SysTick or a general purpose timer count, or 0 to remove the
+//! time source.
+//!
+//! The tick rate is chosen by the application.  Without a time source all
+//! timestamps reported by the library are 0.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void USBHostSerialSetClock(tUSBHSClock pfnClock)
+{
+    g_pfnUSBHSClock = pfnClock;
+}
+
+//*****************************************************************************
+//
+//! This function is used to initialize serial device instance.
+//!
+//! \param psSerialInstance is an instance pointer, received by global callback
+//! function.
+//! \param pfnCallback is callback function for an instance.
+//! \param pvRxBuffer is a pointer to receive buffer provided by application,
+//! of USB_TRANSFER_SIZE bytes or the size given to
+//! USBHostSerialSetRxBufferSize().
+//!
+//! Application should call this function from global callback then received
+//! USB_EVENT_CONNECTED event.  The \b USB_EVENT_RX_AVAILABLE callback receives
+//! the buffer in \e pvMsgData and the number of bytes in \e ui32MsgParam.
+//! When the library is built with a buffer pool, see USBHS_POOL_BLOCKS, and
+//! \e pvRxBuffer is 0, each packet arrives in a pool block that the
+//! application frees with USBHostSerialPoolFree().
+//!
+//! \return None.
+//
+//*****************************************************************************
+uint32_t USBHostSerialSetupInstance(tSerialInstance *psSerialInstance,
+                                           tUSBCallback pfnCallback, void *pvRxBuffer)
+{
+    psSerialInstance->pfnCallback = pfnCallback;
+    psSerialInstance->pvInBuffer = pvRxBuffer;
+    psSerialInstance->ui16InBufferSize = USB_TRANSFER_SIZE;
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+//! This function gives an instance a second receive buffer.
+//!
+//! \param psSerialInstance is an instance pointer, received by global callback
+//! function.
+//! \param pvRxBuffer is a second receive buffer.
+//! \param ui32Size is the size of \e pvRxBuffer in bytes.
+//!
+//! The two buffers take turns: while the application handles the packet in
+//! one, the next packet is received into the other.  The
+//! \b USB_EVENT_RX_AVAILABLE callback finds the buffer holding the data in
+//! \e pvMsgData and its size in \e ui32MsgParam.  The second buffer is
+//! needed to arm the bulk IN pipe again before the callback with DMA and
+//! with the event queue; without them the pipe is armed early anyway.
+//!
+//! Call this after USBHostSerialSetupInstance() in the \b USB_EVENT_CONNECTED
+//! handler.  A buffer that cannot hold a packet of the device, see
+//! USBHostSerialGetPacketSize(), is not used.
+//!
+//! \return Returns 0, or non-zero if the buffer is too small or the library
+//! is built with USBHS_RX_REARM set to 0.
+//
+//*****************************************************************************
+uint32_t USBHostSerialSetupDoubleBuffer(tSerialInstance *psSerialInstance,
+                                        void *pvRxBuffer, uint32_t ui32Size)
+{
+#if USBHS_RX_REARM
+    if(ui32Size < psSerialInstance->ui16PacketSizeIn)
+    {
+        psSerialInstance->pvInBufferAlt = 0;
+
+        return(1);
+    }
+
+    psSerialInstance->pvInBufferAlt = pvRxBuffer;
+
+    return(0);
+#else
+    return(1);
+#endif
+}
+
+//*****************************************************************************
+//
+//! This function returns the bulk IN packet size of a device.
+//!
+//! \param psSerialInstance is an instance pointer, received by global callback
+//! function.
+//!
+//! The size comes from the endpoint descriptor: 64 bytes for a full speed
+//! device and up to 512 bytes for a high speed device, if the library is
+//! built with USBHS_MAX_PACKET raised to match.
+//!
+//! \return The number of bytes a receive buffer must hold.
+//
+//*****************************************************************************
+uint32_t USBHostSerialGetPacketSize(tSerialInstance *psSerialInstance)
+{
+    return(psSerialInstance->ui16PacketSizeIn);
+}
+
+//*****************************************************************************
+//
+//! This function sets the size of the receive buffers of an instance.
+//!
+//! \param psSerialInstance is an instance pointer, received by global callback
+//! function.
+//! \param ui32Size is the size of the buffers given to
+//! USBHostSerialSetupInstance() and USBHostSerialSetupDoubleBuffer().
+//!
+//! Buffers are taken to be USB_TRANSFER_SIZE bytes, which holds any packet
+//! the library accepts.  An application that sizes its buffers for the
+//! device, see USBHostSerialGetPacketSize(), passes the size here so it is
+//! checked.  Buffers that cannot hold a packet are not used: the data goes
+//! to the shared scratch buffer or, without it, is dropped.
+//!
+//! Call this after USBHostSerialSetupInstance(), which resets the size.
+//!
+//! \return Returns 0, or non-zero if the buffers are too small for the
+//! device.
+//
+//*****************************************************************************
+uint32_t USBHostSerialSetRxBufferSize(tSerialInstance *psSerialInstance,
+                                      uint32_t ui32Size)
+{
+    psSerialInstance->ui16InBufferSize =
+            (ui32Size > 0xFFFF) ? 0xFFFF : (uint16_t)ui32Size;
+
+    return((ui32Size < psSerialInstance->ui16PacketSizeIn) ? 1 : 0);
+}
+
+uint32_t USBHostSerialInitNewDevice(tSerialInstance *psSerialInstance)
+{
+    USBHS_CAPTURE_OP(psSerialInstance, USBHS_CAP_OP_INIT, 0, 0);
+    USBHS_CONFIG_SAVE(psSerialInstance, USBHS_CFG_INIT, 0, 0);
+
+    return USBHS_DRIVER_CALL(psSerialInstance, Init, (psSerialInstance));
+}
+
+uint32_t USBHostSerialSetLineConfig(tSerialInstance *psSerialInstance, uint32_t ui32Baud, uint32_t ui32Coding)
+{
+    uint32_t ui32Result;
+
+    USBHS_CAPTURE_OP(psSerialInstance, USBHS_CAP_OP_SET_LINE_CONFIG, ui32Baud,
+                     ui32Coding);
+    USBHS_CONFIG_SAVE(psSerialInstance, USBHS_CFG_LINE, ui32Baud, ui32Coding);
+
+    //
+    // Driver tables written before the operation was added send the two
+    // settings one after the other.
+    //
+    if(!USBHS_DRIVER_HAS(psSerialInstance, SetLineConfig))
+    {
+        ui32Result = USBHS_DRIVER_CALL(psSerialInstance, SetBaud,
+                                       (psSerialInstance, ui32Baud));
+        return(ui32Result | USBHS_DRIVER_CALL(psSerialInstance, SetCoding,
+                                              (psSerialInstance,
+                                               ui32Coding)));
+    }
+
+    return USBHS_DRIVER_CALL(psSerialInstance, SetLineConfig, (psSerialInstance, ui32Baud, ui32Coding));
+}
+
+uint32_t USBHostSerialGetBaud(tSerialInstance *psSerialInstance)
+{
+    return USBHS_DRIVER_CALL(psSerialInstance, GetBaud, (psSerialInstance));
+}
+
+//*****************************************************************************
+//
+//! This function returns the baud rate a device produces for a requested one.
+//!
+//! \param psSerialInstance is an instance pointer, received by global callback
+//! function.
+//! \param ui32Baud is the requested baud rate.
+//! \param pi32Error receives the error of the returned rate against the
+//! requested one in parts per million, or is 0.
+//!
+//! Rates outside the range of the device are moved to the nearest end of it.
+//! USBHostSerialSetLineConfig() sets the same rate.  Drivers that cannot
+//! tell, see USBHostSerialGetBaudRange(), return the requested rate.  No
+//! request is sent.
+//!
+//! \return Returns the baud rate the device produces.
+//
+//*****************************************************************************
+uint32_t USBHostSerialGetBaudActual(tSerialInstance *psSerialInstance,
+                                    uint32_t ui32Baud, int32_t *pi32Error)
+{
+    uint32_t ui32Actual;
+
+    ui32Actual = USBHS_DRIVER_CALL_OPT(psSerialInstance, GetBaudActual,
+                                       (psSerialInstance, ui32Baud, 0),
+                                       ui32Baud);
+
+    if(pi32Error)
+    {
+        *pi32Error = ui32Baud ?
+            (int32_t)((((int64_t)ui32Actual - ui32Baud) * 1000000) /
+                      ui32Baud) : 0;
+    }
+
+    return(ui32Actual);
+}
+
+//*****************************************************************************
+//
+//! This function returns the baud rates a device supports.
+//!
+//! \param psSerialInstance is an instance pointer, received by global callback
+//! function.
+//! \param psRange receives the lowest and highest rate and the
+//! \b USBHS_BAUD_ flags.
+//!
+//! The CP210x driver tells the variants apart by the part number it reads
+//! in USBHostSerialInitNewDevice(), before that the range of the CP2102 is
+//! returned.  A driver without the operation is taken to accept any rate.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void USBHostSerialGetBaudRange(tSerialInstance *psSerialInstance,
+                               tUSBHSBaudRange *psRange)
+{
+    if(!USBHS_DRIVER_HAS(psSerialInstance, GetBaudActual))
+    {
+        psRange->ui32Min = 1;
+        psRange->ui32Max = 0xFFFFFFFF;
+        psRange->ui32Flags = 0;
+        return;
+    }
+
+    USBHS_DRIVER_CALL(psSerialInstance, GetBaudActual,
+                      (psSerialInstance, 0, psRange));
+}
+
+uint32_t USBHostSerialGetCoding(tSerialInstance *psSerialInstance)
+{
+    return USBHS_DRIVER_CALL(psSerialInstance, GetCoding, (psSerialInstance));
+}
+
+uint32_t USBHostSerialSetControlLineState(tSerialInstance *psSerialInstance, uint32_t ui32Control)
+{
+    USBHS_CAPTURE_OP(psSerialInstance, USBHS_CAP_OP_SET_CONTROL, ui32Control, 0);
+    USBHS_CONFIG_SAVE(psSerialInstance, USBHS_CFG_CONTROL, ui32Control, 0);
+
+    return USBHS_DRIVER_CALL(psSerialInstance, SetControlLineState, (psSerialInstance, ui32Control));
+}
+
+uint32_t USBHostSerialGetControlLineState(tSerialInstance *psSerialInstance)
+{
+    return USBHS_DRIVER_CALL(psSerialInstance, GetControlLineState, (psSerialInstance));
+}
+
+uint32_t USBHostSerialSetFlow(tSerialInstance *psSerialInstance, uint32_t ui32Flow)
+{
+    USBHS_CAPTURE_OP(psSerialInstance, USBHS_CAP_OP_SET_FLOW, ui32Flow, 0);
+    USBHS_CONFIG_SAVE(psSerialInstance, USBHS_CFG_FLOW, ui32Flow, 0);
+
+    return USBHS_DRIVER_CALL(psSerialInstance, SetFlow, (psSerialInstance, ui32Flow));
+}
+
+uint32_t USBHostSerialBreakSet(tSerialInstance *psSerialInstance)
+{
+    USBHS_CAPTURE_OP(psSerialInstance, USBHS_CAP_OP_BREAK_SET, 0, 0);
+
+    return USBHS_DRIVER_CALL(psSerialInstance, BreakSet, (psSerialInstance));
+}
+
+uint32_t USBHostSerialBreakClear(tSerialInstance *psSerialInstance)
+{
+    USBHS_CAPTURE_OP(psSerialInstance, USBHS_CAP_OP_BREAK_CLEAR, 0, 0);
+
+    return USBHS_DRIVER_CALL(psSerialInstance, BreakClear, (psSerialInstance));
+}
+
+//*****************************************************************************
+//
+//! This function discards the data buffered for a serial device.
+//!
+//! \param psSerialInstance is an instance pointer, received by global callback
+//! function.
+//! \param bRx is true to discard the data received from the serial line.
+//! \param bTx is true to discard the data not yet sent to the serial line.
+//!
+//! Use this to resynchronize with a protocol after an error instead of
+//! reading and dropping the stale data.  For the transmit direction the
+//! buffers queued with USBHostSerialScheduleWrite() are dropped when the
+//! packet on the bus completes; each is reported with
+//! \b USB_EVENT_TX_COMPLETE and the number of bytes sent from it, which is 0
+//! for the buffers that had not been started.  For the receive direction a
+//! receive event waiting in the event queue is discarded.  The device then
+//! empties its own buffers with a single request.  A packet that is already
+//! on the bus may still arrive after the function returned.
+//!
+//! The function sends a control request and must not be called from the
+//! instance callback of a pipe event.
+//!
+//! \return Returns 0 if the device buffers were purged or non-zero if the
+//! device cannot do so, in which case only the host side was purged.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialPurge(tSerialInstance *psSerialInstance, bool bRx, bool bTx)
+{
+    USBHS_CAPTURE_OP(psSerialInstance, USBHS_CAP_OP_PURGE, bRx, bTx);
+
+    if(bTx)
+    {
+        //
+        // The owner of the bulk OUT pipe drops the data on its next
+        // completion, or when an RS-485 transceiver holding the pipe has
+        // switched to send, before anything is sent.  If the pipe is idle
+        // nothing waits to be sent, unless a buffer was queued meanwhile.
+        // That one is started like any other write, after switching an
+        // RS-485 transceiver to send.
+        //
+        psSerialInstance->bTxPurge = true;
+        USBHSMemoryBarrier();
+
+        if(USBHSAtomicCAS(&psSerialInstance->ui32TxBusy, 0, 1))
+        {
+            psSerialInstance->bTxPurge = false;
+#if USBHS_TX_QUEUE_DEPTH == 0
+            psSerialInstance->ui32TxBusy = 0;
+#else
+            do
+            {
+                if(!USBHSQueueEmpty(&psSerialInstance->sTxQueue))
+                {
+                    if(!USBHS_RS485_HOLD(psSerialInstance))
                     {
-                        //
-                        // Get the interrupt endpoint descriptor
-                        //
-                        psEndpointDescriptor =
-                                USBDescGetInterfaceEndpoint(psInterface, i32Idx,
-                                                            psDevice->ui32ConfigDescriptorSize);
+                        USBHSerialTxStart(psSerialInstance);
+                    }
+                    break;
+                }
 
-                        //
-                        // If no more endpoints then break out.
-                        //
-                        if(psEndpointDescriptor == 0)
-                        {
-                            break;
-                        }
+                psSerialInstance->ui32TxBusy = 0;
+                USBHSMemoryBarrier();
+            }
+            while(!USBHSQueueEmpty(&psSerialInstance->sTxQueue) &&
+                  USBHSAtomicCAS(&psSerialInstance->ui32TxBusy, 0, 1));
+#endif
+        }
+    }
 
-                        //
-                        // See if this is a bulk endpoint.
-                        //
-                        if((psEndpointDescriptor->bmAttributes & USB_EP_ATTR_TYPE_M) ==
-                                USB_EP_ATTR_BULK)
-                        {
-                            //
-                            // See if this is bulk IN or bulk OUT.
-                            //
-                            if(psEndpointDescriptor->bEndpointAddress & USB_EP_DESC_IN)
-                            {
-                                //
-                                // Allocate the USB Pipe for this Bulk IN endpoint.
-                                //
-                                psInstance->ui32BulkInPipe =
-                                        USBHCDPipeAllocSize(0, USBHCD_PIPE_BULK_IN,
-                                                            psDevice,
-                                                            psEndpointDescriptor->wMaxPacketSize,
-                                                            USBHSerialCallback);
-                                //
-                                // Configure the USB pipe as a Bulk IN endpoint.
-                                //
-                                USBHCDPipeConfig(psInstance->ui32BulkInPipe,
-                                                 psEndpointDescriptor->wMaxPacketSize,
-                                                 g_psDrivers[i].bPolling ? g_psDrivers[i].ui32Interval : 0,
-                                                 ((psEndpointDescriptor->bEndpointAddress) &
-                                                         USB_EP_DESC_NUM_M));
-                            }
-                            else
-                            {
-                                //
-                                // Allocate the USB Pipe for this Bulk OUT endpoint.
-                                //
-                                psInstance->ui32BulkOutPipe =
-                                        USBHCDPipeAllocSize(0, USBHCD_PIPE_BULK_OUT,
-                                                            psDevice,
-                                                            psEndpointDescriptor->wMaxPacketSize,
-                                                            USBHSerialCallback);
-                                //
-                                // Configure the USB pipe as a Bulk OUT endpoint.
-                                //
-                                USBHCDPipeConfig(psInstance->ui32BulkOutPipe,
-                                                 psEndpointDescriptor->wMaxPacketSize,
-                                                 0, (psEndpointDescriptor->bEndpointAddress &
-                                                         USB_EP_DESC_NUM_M));
-                            }
-                        }
+    if(bRx)
+    {
+        psSerialInstance->ui16PipeSizeIn = 0;
+#if USBHS_QUEUE_POLL
+        psSerialInstance->ui32DeviceQueue = 0;
+#endif
+        USBHS_EVENT_PURGE(psSerialInstance);
+    }
+
+    return USBHS_DRIVER_CALL_OPT(psSerialInstance, Purge,
+                                 (psSerialInstance, bRx, bTx), 1);
+}
+
+#if USBHS_DEFERRED_INIT
+//*****************************************************************************
+//
+//! This function queues setup steps for a serial device.
+//!
+//! \param psSerialInstance is an instance pointer, received by global callback
+//! function.
+//! \param psSetup selects the steps and their values.
+//!
+//! Instead of running driver init, line configuration, flow control and
+//! control line setup as blocking control transfers while the device is being
+//! enumerated, the application queues them here from its
+//! \b USB_EVENT_CONNECTED handler.  USBHostSerialProcess() then sends them
+//! one request at a time, taking turns between all devices, and the instance
+//! callback receives \b USBHS_EVENT_READY after the last one.  Steps queued
+//! again before they are sent replace the earlier values.
+//!
+//! This function must be called from the same context as
+//! USBHostSerialProcess().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void USBHostSerialSetupDeferred(tSerialInstance *psSerialInstance,
+                                const tUSBHSLineSetup *psSetup)
+{
+    tUSBHSLineSetup *psPending = &psSerialInstance->sPending;
+
+    if(psSetup->ui32Items & USBHS_SETUP_LINE)
+    {
+        psPending->ui32Baud = psSetup->ui32Baud;
+        psPending->ui32Coding = psSetup->ui32Coding;
+    }
+    if(psSetup->ui32Items & USBHS_SETUP_FLOW)
+    {
+        psPending->ui32Flow = psSetup->ui32Flow;
+    }
+    if(psSetup->ui32Items & USBHS_SETUP_CONTROL)
+    {
+        psPending->ui32Control = psSetup->ui32Control;
+    }
+
+    psPending->ui32Items |= psSetup->ui32Items;
+}
+
+//*****************************************************************************
+//
+// Sends the next queued setup step of an instance.  Returns true if a request
+// was sent.
+//
+//*****************************************************************************
+static bool
+USBHSerialSetupStep(tSerialInstance *psInstance)
+{
+    tUSBHSLineSetup *psPending = &psInstance->sPending;
+
+    if(psPending->ui32Items == 0)
+    {
+        return(false);
+    }
+
+    if(psPending->ui32Items & USBHS_SETUP_INIT)
+    {
+        psPending->ui32Items &= ~USBHS_SETUP_INIT;
+        USBHostSerialInitNewDevice(psInstance);
+    }
+    else if(psPending->ui32Items & USBHS_SETUP_LINE)
+    {
+        psPending->ui32Items &= ~USBHS_SETUP_LINE;
+        USBHostSerialSetLineConfig(psInstance, psPending->ui32Baud,
+                                   psPending->ui32Coding);
+    }
+    else if(psPending->ui32Items & USBHS_SETUP_FLOW)
+    {
+        psPending->ui32Items &= ~USBHS_SETUP_FLOW;
+        USBHostSerialSetFlow(psInstance, psPending->ui32Flow);
+    }
+    else
+    {
+        psPending->ui32Items &= ~USBHS_SETUP_CONTROL;
+        USBHostSerialSetControlLineState(psInstance, psPending->ui32Control);
+    }
+
+    if((psPending->ui32Items == 0) && (psInstance->pfnCallback != 0))
+    {
+        psInstance->pfnCallback(psInstance, USBHS_EVENT_READY, 0, 0);
+    }
+
+    return(true);
+}
+#endif
+
+#if USBHS_RECOVERY_RETRIES
+//*****************************************************************************
+//
+// Clears the halted pipes of an instance once their recovery is due and
+// restarts them.  Bulk and interrupt IN pipes are armed again by their next
+// poll, an interrupted bulk OUT transfer is sent again.  Returns true if a
+// request was sent.
+//
+//*****************************************************************************
+static bool
+USBHSerialRecoverStep(tSerialInstance *psInstance)
+{
+    uint32_t ui32Halted, ui32Current, ui32Frame;
+
+    ui32Halted = psInstance->ui32Halted;
+    if((ui32Halted == 0) || (psInstance->ui8Retries > USBHS_RECOVERY_RETRIES))
+    {
+        return(false);
+    }
+
+    ui32Frame = USBHS_BACKEND_CALL(FrameGet, ());
+    if(((ui32Frame - psInstance->ui16RetryFrame) & USBHS_FRAME_MASK) >
+       (USBHS_FRAME_MASK >> 1))
+    {
+        return(false);
+    }
+
+    //
+    // Give up after the last try, the pipes stay halted.
+    //
+    if(psInstance->ui8Retries++ == USBHS_RECOVERY_RETRIES)
+    {
+        psInstance->sErrors.ui32Failures++;
+        if(psInstance->pfnCallback != 0)
+        {
+            psInstance->pfnCallback(psInstance, USBHS_EVENT_PIPE_FAILED,
+                                    ui32Halted, 0);
+        }
+        return(false);
+    }
+
+    //
+    // Clearing the halt feature also resets the data toggle of the pipe.
+    //
+    if(ui32Halted & USBHS_HALT_IN)
+    {
+        USBHS_BACKEND_CALL(ClearFeature,
+                           (psInstance->psDevice, psInstance->ui32BulkInPipe,
+                            USB_FEATURE_EP_HALT));
+    }
+    if(ui32Halted & USBHS_HALT_OUT)
+    {
+        USBHS_BACKEND_CALL(ClearFeature,
+                           (psInstance->psDevice, psInstance->ui32BulkOutPipe,
+                            USB_FEATURE_EP_HALT));
+    }
+#if USBHS_INT_IN_PIPE
+    if(ui32Halted & USBHS_HALT_INT)
+    {
+        USBHS_BACKEND_CALL(ClearFeature,
+                           (psInstance->psDevice, psInstance->ui32IntInPipe,
+                            USB_FEATURE_EP_HALT));
+    }
+#endif
+
+    //
+    // Take the cleared pipes off the list.  The pipe callbacks may have
+    // added others meanwhile.
+    //
+    do
+    {
+        ui32Current = psInstance->ui32Halted;
+    }
+    while(!USBHSAtomicCAS(&psInstance->ui32Halted, ui32Current,
+                          ui32Current & ~ui32Halted));
+
+    //
+    // The transmit state is still owned by the halted transfer, send its
+    // last packet again.
+    //
+    if((ui32Halted & USBHS_HALT_OUT) && psInstance->ui32TxBusy)
+    {
+        USBHS_CAPTURE_EVENT(USBHS_CAP_TX, psInstance, 0,
+                            psInstance->pui8TxLast, psInstance->ui16TxLast,
+                            0, 0);
+        USBHSerialPipeSchedule(psInstance->ui32BulkOutPipe,
+                               psInstance->pui8TxLast,
+                               psInstance->ui16TxLast);
+    }
+
+    psInstance->sErrors.ui32Recoveries++;
+    if(psInstance->pfnCallback != 0)
+    {
+        psInstance->pfnCallback(psInstance, USBHS_EVENT_RECOVERED, ui32Halted,
+                                0);
+    }
+
+    return(true);
+}
+#endif
+
+#if USBHS_QUEUE_POLL
+//*****************************************************************************
+//
+// Reads how many bytes wait in the device every USBHS_QUEUE_POLL frames,
+// while no burst is being read.  Devices whose driver cannot tell are not
+// asked again.  Returns true if a request was sent.
+//
+//*****************************************************************************
+static bool
+USBHSerialQueueStep(tSerialInstance *psInstance)
+{
+    uint32_t ui32Frame, ui32Queue;
+
+    if(psInstance->bQueueUnknown || (psInstance->ui32DeviceQueue != 0))
+    {
+        return(false);
+    }
+
+    ui32Frame = USBHS_BACKEND_CALL(FrameGet, ()) & 0x7FF;
+    if(((ui32Frame - psInstance->ui16QueueFrame) & 0x7FF) < USBHS_QUEUE_POLL)
+    {
+        return(false);
+    }
+    psInstance->ui16QueueFrame = ui32Frame;
 
-                        if(!g_psDrivers[i].bPolling)
-                        {
-                            //
-                            // See if this is an interrupt endpoint.
-                            //
-                            if((psEndpointDescriptor->bmAttributes & USB_EP_ATTR_TYPE_M) ==
-                                    USB_EP_ATTR_INT)
-                            {
-                                //
-                                // See if this is interrupt IN endpoint.
-                                //
-                                if(psEndpointDescriptor->bEndpointAddress & USB_EP_DESC_IN)
-                                {
-                                    //
-                                    // Allocate the USB Pipe for this Interrupt IN endpoint.
-                                    //
-                                    psInstance->ui32IntInPipe =
-                                            USBHCDPipeAlloc(0, USBHCD_PIPE_INTR_IN,
-                                                            psDevice, USBHSerialIntINCallback);
+    ui32Queue = USBHS_DRIVER_CALL_OPT(psInstance, GetRxQueue, (psInstance),
+                                      USBHS_QUEUE_UNKNOWN);
+    if(ui32Queue == USBHS_QUEUE_UNKNOWN)
+    {
+        psInstance->bQueueUnknown = true;
+        return(false);
+    }
 
-                                    //
-                                    // Configure the USB pipe as a Interrupt IN endpoint.
-                                    //
-                                    USBHCDPipeConfig(psInstance->ui32IntInPipe,
-                                                     psEndpointDescriptor->wMaxPacketSize,
-                                                     psEndpointDescriptor->bInterval,
-                                                     (psEndpointDescriptor->bEndpointAddress &
-                                                             USB_EP_DESC_NUM_M));
-                                }
-                            }
-                        }
-                    }
-                    //
-                    // If global callback exist, call it
-                    //
-                    if(g_pfnGlobalAppCB != 0)
-                    {
-                        g_pfnGlobalAppCB(
-                                psInstance,
-                                USB_EVENT_CONNECTED,
-                                0, 0);
-                    }
+    //
+    // The next poll of the pipe starts reading the burst.
+    //
+    psInstance->ui32DeviceQueue = ui32Queue;
 
-                    //
-                    // Increment number of open instances
-                    //
-                    g_ui8NumInstances++;
+    return(true);
+}
+#endif
+
+#if USBHS_RS485
+//*****************************************************************************
+//
+// Moves the RS-485 direction of an instance on.  Returns true if a request
+// was sent.
+//
+//*****************************************************************************
+static bool
+USBHSerialRs485Step(tSerialInstance *psInstance)
+{
+    tUSBHSRs485Stats *psStats;
+    uint32_t ui32Now, ui32Queue;
+
+    psStats = &psInstance->sRs485Stats;
+    ui32Now = USBHSClockGet();
+
+    switch(psInstance->ui32Rs485State)
+    {
+        case RS485_ASSERT:
+        {
+            USBHS_DRIVER_CALL(psInstance, SetControlLineState,
+                              (psInstance, psInstance->sRs485.ui32Control ^
+                                           psInstance->sRs485.ui32Drive));
+            psInstance->ui32Rs485Time = USBHSClockGet();
+            psInstance->ui32Rs485State = RS485_PRE;
+            psStats->ui32Transmissions++;
+
+            return(true);
+        }
+        case RS485_PRE:
+        {
+            if((ui32Now - psInstance->ui32Rs485Time) <
+               psInstance->sRs485.ui32PreDelay)
+            {
+                return(false);
+            }
+
+            //
+            // Start the pipe for the writer that has been holding it, unless
+            // USBHostSerialPurge() dropped the data meanwhile.  The held
+            // buffers are still queued, only without a queue the buffer was
+            // loaded.
+            //
+            psStats->ui32Assert = ui32Now - psInstance->ui32Rs485Queued;
+            psInstance->ui32Rs485State = RS485_ACTIVE;
+            USBHSMemoryBarrier();
+            if(psInstance->bTxPurge)
+            {
+                USBHSerialTxPurge(psInstance, USBHS_TX_QUEUE_DEPTH == 0);
+            }
+            else
+            {
+                USBHSerialTxStart(psInstance);
+            }
+
+            return(false);
+        }
+        case RS485_DRAIN:
+        {
+            if(psInstance->ui32TxBusy)
+            {
+                return(false);
+            }
 
-                    return (void *)psInstance;
+            //
+            // Wait for the device to send what it holds.  Without knowing
+            // the post-delay counts from the last packet.
+            //
+            ui32Queue = USBHS_DRIVER_CALL_OPT(psInstance, GetTxQueue,
+                                              (psInstance),
+                                              USBHS_QUEUE_UNKNOWN);
+            if(ui32Queue == USBHS_QUEUE_UNKNOWN)
+            {
+                psStats->ui32Turnaround = 0;
+                USBHSAtomicCAS(&psInstance->ui32Rs485State, RS485_DRAIN,
+                               RS485_POST);
+                return(false);
+            }
+
+            if(ui32Queue == 0)
+            {
+                ui32Now = USBHSClockGet();
+                if(USBHSAtomicCAS(&psInstance->ui32Rs485State, RS485_DRAIN,
+                                  RS485_POST))
+                {
+                    psStats->ui32Turnaround = ui32Now -
+                                              psInstance->ui32Rs485Time;
+                    psInstance->ui32Rs485Time = ui32Now;
                 }
             }
+
+            return(true);
         }
-    }
+        case RS485_POST:
+        {
+            if(((ui32Now - psInstance->ui32Rs485Time) <
+                psInstance->sRs485.ui32PostDelay) ||
+               !USBHSAtomicCAS(&psInstance->ui32Rs485State, RS485_POST,
+                               RS485_RELEASE))
+            {
+                return(false);
+            }
 
-    return 0;
+            USBHS_DRIVER_CALL(psInstance, SetControlLineState,
+                              (psInstance, psInstance->sRs485.ui32Control));
+
+            //
+            // The turnaround counts from the last packet, across the drain.
+            //
+            psStats->ui32Turnaround += USBHSClockGet() -
+                                       psInstance->ui32Rs485Time;
+            if(psStats->ui32Turnaround > psStats->ui32TurnaroundMax)
+            {
+                psStats->ui32TurnaroundMax = psStats->ui32Turnaround;
+            }
+
+            //
+            // A writer that came during the switch waits for the next one.
+            //
+            psInstance->ui32Rs485State = RS485_IDLE;
+            USBHSMemoryBarrier();
+            if(psInstance->ui32TxBusy)
+            {
+                psInstance->ui32Rs485Queued = USBHSClockGet();
+                USBHSAtomicCAS(&psInstance->ui32Rs485State, RS485_IDLE,
+                               RS485_ASSERT);
+            }
+
+            return(true);
+        }
+        default:
+        {
+            return(false);
+        }
+    }
 }
+#endif
 
 //*****************************************************************************
 //
-//! This function is used to release an instance of the CDC driver.
-//!
-//! \param pvInstance is an instance pointer that needs to be released.
+//! This function performs the main loop work of the serial host library.
 //!
-//! This function will free up any resources in use by the CDC driver instance
-//! that is passed in.  The \e pvInstance pointer should be a valid value that
-//! was returned from a call to USBCDCOpen().
+//! The application calls this function from its main loop next to
+//! USBHCDMain().  Each call sends at most one request so that enumeration of
+//! other devices is not held up.  With USBHS_RS485 set the RS-485 direction
+//! of the devices is switched first, as any delay adds to the bus
+//! turnaround.  Pipes that stalled or failed are cleared and restarted next,
+//! with the delay between tries growing from USBHS_RECOVERY_DELAY frames
+//! until USBHS_RECOVERY_RETRIES tries failed.  Then queued setup requests
+//! are sent, and devices take turns so that they all become ready at about
+//! the same time.  Last, with USBHS_QUEUE_POLL set, devices are asked how
+//! much data they have queued.
 //!
 //! \return None.
 //
 //*****************************************************************************
-void
-SerialDriverClose(void *pvInstance)
+void USBHostSerialProcess(void)
 {
-    tSerialInstance *psInst;
+#if USBHS_DEFERRED_INIT || USBHS_RECOVERY_RETRIES || USBHS_QUEUE_POLL ||   \
+    USBHS_RS485
+    uint32_t ui32Count;
+    tSerialInstance *psInstance;
+#endif
+
+#if USBHS_RS485
+    for(ui32Count = 0; ui32Count < g_ui8NumInstances; ui32Count++)
+    {
+        psInstance = g_psInstances + ui32Count;
 
-    //
-    // Get our instance pointer.
-    //
-    psInst = (tSerialInstance *)pvInstance;
+        if(psInstance->bConnected && USBHSerialRs485Step(psInstance))
+        {
+            return;
+        }
+    }
+#endif
 
-    //
-    // Reset the device pointer.
-    //
-    psInst->psDevice = 0;
-    psInst->bConnected = false;
+#if USBHS_RECOVERY_RETRIES
+    for(ui32Count = 0; ui32Count < g_ui8NumInstances; ui32Count++)
+    {
+        psInstance = g_psInstances + ui32Count;
 
-    //
-    // Free the Interrupt IN pipe.
-    //
-    if(psInst->ui32IntInPipe != 0)
+        if(psInstance->bConnected && USBHSerialRecoverStep(psInstance))
+        {
+            return;
+        }
+    }
+#endif
+
+#if USBHS_DEFERRED_INIT
+
+    for(ui32Count = 0; ui32Count < g_ui8NumInstances; ui32Count++)
+    {
+        if(g_ui8NextSetup >= g_ui8NumInstances)
+        {
+            g_ui8NextSetup = 0;
+        }
+        psInstance = g_psInstances + g_ui8NextSetup++;
+
+        if(psInstance->bConnected && USBHSerialSetupStep(psInstance))
+        {
+            return;
+        }
+    }
+#endif
+
+#if USBHS_QUEUE_POLL
+    for(ui32Count = 0; ui32Count < g_ui8NumInstances; ui32Count++)
     {
-        USBHCDPipeFree(psInst->ui32IntInPipe);
+        psInstance = g_psInstances + ui32Count;
+
+        if(psInstance->bConnected && USBHSerialQueueStep(psInstance))
+        {
+            return;
+        }
     }
+#endif
+}
 
+//*****************************************************************************
+//
+// Queues a buffer or segment list, see USBHSerialTxLoad(), and starts the
+// bulk OUT pipe if it is idle.
+//
+//*****************************************************************************
+static uint32_t
+USBHSerialTxSubmit(tSerialInstance *psInstance, void *pvData,
+                   uint32_t ui32Value)
+{
+#if USBHS_TX_QUEUE_DEPTH == 0
     //
-    // Free the Bulk IN pipe.
+    // Only one buffer can be in flight, take ownership of the idle pipe.
     //
-    if(psInst->ui32BulkInPipe != 0)
+    if(!USBHSAtomicCAS(&psInstance->ui32TxBusy, 0, 1))
     {
-        USBHCDPipeFree(psInst->ui32BulkInPipe);
+        return(1);
     }
 
+    USBHSerialTxLoad(psInstance, pvData, ui32Value);
+    if(!USBHS_RS485_HOLD(psInstance))
+    {
+        USBHSerialTxStart(psInstance);
+    }
+#else
     //
-    // Free the Bulk OUT pipe.
+    // Queue the buffer.
     //
-    if(psInst->ui32BulkOutPipe != 0)
+    if(!USBHSQueuePush(&psInstance->sTxQueue, pvData, ui32Value))
     {
-        USBHCDPipeFree(psInst->ui32BulkOutPipe);
+        return(1);
     }
 
     //
-    // If the callback exists, call it with a DISCONNECTED event.
+    // If the bulk OUT pipe is idle, take ownership and schedule the next OUT
+    // Pipe transaction.  Otherwise the owner picks the buffer up.
     //
-    if(psInst->pfnCallback != 0)
+    if(USBHSAtomicCAS(&psInstance->ui32TxBusy, 0, 1) &&
+       !USBHS_RS485_HOLD(psInstance))
     {
-        psInst->pfnCallback(psInst, USB_EVENT_DISCONNECTED,
-                            0, 0);
+        USBHSerialTxStart(psInstance);
     }
+#endif
+
+    return(0);
 }
 
 //*****************************************************************************
 //
-//! This function is used to initialize serial driver layer.
+//! This function queues data to be sent on the bulk OUT endpoint.
 //!
-//! \param pfnCallback is callback function used to handle USB_EVENT_CONNECTED
+//! \param psSerialInstance is the value that was returned from the call to
+//! USBHCDCOpen().
+//! \param pui8Data is the memory buffer storing the data.
+//! \param ui32Size is how many bytes of data from \e pui8Buffer should be
+//! written to the endpoint.
 //!
-//! \return None.
+//! This function will not block.  The buffer is added to the transmit
+//! submission queue of the instance and is sent packet by packet from the
+//! transfer complete interrupt, a buffer of 0 bytes as a zero length packet.
+//! The function may be called concurrently by several tasks and from
+//! interrupt handlers without disabling interrupts.  The buffer must stay
+//! valid until the instance callback receives \b USB_EVENT_TX_COMPLETE with
+//! \e ui32MsgParam set to its size and \e pvMsgData pointing to it.  Sizes
+//! of 2 GB or more are refused.
+//!
+//! \return Returns 0 if the buffer was queued or non-zero if the size was
+//! refused or the queue was full.
 //
 //*****************************************************************************
-uint32_t USBHostSerialInit(tUSBCallback pfnCallback)
+uint32_t USBHostSerialScheduleWrite(tSerialInstance *psSerialInstance, uint8_t *pui8Data,
+                                    uint32_t ui32Size)
 {
     //
-    // Register the host class drivers.
+    // The top bit of the size marks a segment list in the queue.
     //
-    USBHCDRegisterDrivers(0, g_ppHostClassDrivers, g_ui32NumHostClassDrivers);
-
-    g_pfnGlobalAppCB = pfnCallback;
+    if(ui32Size & USBHS_TX_VECTOR)
+    {
+        return(1);
+    }
 
-    return 0;
+    return(USBHSerialTxSubmit(psSerialInstance, pui8Data, ui32Size));
 }
 
 //*****************************************************************************
 //
-//! This function is used to initialize serial device instance.
+//! This function queues data held in several buffers to be sent on the bulk
+//! OUT endpoint.
 //!
 //! \param psSerialInstance is an instance pointer, received by global callback
 //! function.
-//! \param pfnCallback is callback function for an instance.
-//! \param pvRxBuffer is a pointer to receive buffer provided by application.
+//! \param psVec is the list of segments, sent in order.
+//! \param ui32Count is the number of segments.
 //!
-//! Application should call this function from global callback then received
-//! USB_EVENT_CONNECTED event.
+//! The segments, for example a protocol header, its payload and a CRC, are
+//! sent as one piece without being copied together first.  Packets are sent
+//! straight from the segments, and where a packet would end a segment early
+//! its bytes are packed with those of the next segments so that every packet
+//! but the last is full; see USBHS_TX_GATHER.  The function behaves like
+//! USBHostSerialScheduleWrite() and shares its queue.  The segment list and
+//! the data must stay valid until the instance callback receives
+//! \b USB_EVENT_TX_COMPLETE with \e pvMsgData pointing to the list and
+//! \e ui32MsgParam set to the total size.  A list without segments, or whose
+//! segments are all empty, is refused.
 //!
-//! \return None.
+//! \return Returns 0 if the segments were queued or non-zero if the list was
+//! refused or the queue was full.
 //
 //*****************************************************************************
-uint32_t USBHostSerialSetupInstance(tSerialInstance *psSerialInstance,
-                                           tUSBCallback pfnCallback, void *pvRxBuffer)
-{
-    psSerialInstance->pfnCallback = pfnCallback;
-    psSerialInstance->pvInBuffer = pvRxBuffer;
-
-    return 0;
-}
-
-uint32_t USBHostSerialInitNewDevice(tSerialInstance *psSerialInstance)
+uint32_t
+USBHostSerialWriteV(tSerialInstance *psSerialInstance,
+                    const tUSBHSIoVec *psVec, uint32_t ui32Count)
 {
-    return g_psDrivers[psSerialInstance->ui8Driver].pfnInit(psSerialInstance);
-}
+    uint32_t ui32Index;
 
-uint32_t USBHostSerialSetLineConfig(tSerialInstance *psSerialInstance, uint32_t ui32Baud, uint32_t ui32Coding)
-{
-    return g_psDrivers[psSerialInstance->ui8Driver].pfnSetBaud(psSerialInstance, ui32Baud) &&
-           g_psDrivers[psSerialInstance->ui8Driver].pfnSetCoding(psSerialInstance, ui32Coding);
-}
+    if((ui32Count == 0) || (ui32Count & USBHS_TX_VECTOR))
+    {
+        return(1);
+    }
 
-uint32_t USBHostSerialGetBaud(tSerialInstance *psSerialInstance)
-{
-    return g_psDrivers[psSerialInstance->ui8Driver].pfnGetBaud(psSerialInstance);
-}
+    //
+    // An empty list would never start a packet nor complete.
+    //
+    for(ui32Index = 0; ui32Index < ui32Count; ui32Index++)
+    {
+        if(psVec[ui32Index].ui32Size != 0)
+        {
+            break;
+        }
+    }
 
-uint32_t USBHostSerialGetCoding(tSerialInstance *psSerialInstance)
-{
-    return g_psDrivers[psSerialInstance->ui8Driver].pfnGetCoding(psSerialInstance);
-}
+    if(ui32Index == ui32Count)
+    {
+        return(1);
+    }
 
-uint32_t USBHostSerialSetControlLineState(tSerialInstance *psSerialInstance, uint32_t ui32Control)
-{
-    return g_psDrivers[psSerialInstance->ui8Driver].pfnSetControlLineState(psSerialInstance, ui32Control);
+    return(USBHSerialTxSubmit(psSerialInstance, (void *)psVec,
+                              ui32Count | USBHS_TX_VECTOR));
 }
 
-uint32_t USBHostSerialGetControlLineState(tSerialInstance *psSerialInstance)
+uint16_t USBHostSerialReadDataCount(tSerialInstance *psSerialInstance)
 {
-    return g_psDrivers[psSerialInstance->ui8Driver].pfnGetControlLineState(psSerialInstance);
+    return(psSerialInstance->ui16PipeSizeIn);
 }
 
-uint32_t USBHostSerialBreakSet(tSerialInstance *psSerialInstance)
+#if USBHS_RX_TIMESTAMP
+//*****************************************************************************
+//
+//! This function returns when the data in the receive buffer arrived.
+//!
+//! \param psSerialInstance is the instance that received the data.
+//! \param psTimestamp receives the arrival time.
+//!
+//! The time is taken in the USB interrupt as soon as the packet is reported,
+//! before it is copied to the receive buffer, both as application clock ticks
+//! (see USBHostSerialSetClock()) and as the USB frame number.  Like
+//! USBHostSerialReadDataCount() it describes the packet reported by the last
+//! \b USB_EVENT_RX_AVAILABLE and should be read from that callback.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void USBHostSerialReadTimestamp(tSerialInstance *psSerialInstance,
+                                tUSBHSTimestamp *psTimestamp)
 {
-    return g_psDrivers[psSerialInstance->ui8Driver].pfnBreakSet(psSerialInstance);
+    psTimestamp->ui32Time = psSerialInstance->ui32RxTime;
+    psTimestamp->ui16Frame = psSerialInstance->ui16RxFrame;
 }
+#endif
 
-uint32_t USBHostSerialBreakClear(tSerialInstance *psSerialInstance)
+//*****************************************************************************
+//
+//! This function returns the pipe error counters of an instance.
+//!
+//! \param psSerialInstance is the instance to read.
+//! \param psErrors receives the counters.
+//!
+//! The counters start at 0 when the device is connected.  Without recovery,
+//! USBHS_RECOVERY_RETRIES set to 0, all counters are 0.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void USBHostSerialGetErrors(tSerialInstance *psSerialInstance,
+                            tUSBHSPipeErrors *psErrors)
 {
-    return g_psDrivers[psSerialInstance->ui8Driver].pfnBreakClear(psSerialInstance);
+#if USBHS_RECOVERY_RETRIES
+    *psErrors = psSerialInstance->sErrors;
+#else
+    psErrors->ui32Stalls = 0;
+    psErrors->ui32Errors = 0;
+    psErrors->ui32Recoveries = 0;
+    psErrors->ui32Failures = 0;
+#endif
 }
 
 //*****************************************************************************
 //
-//! This function schedules the bulk OUT endpoint to send data.
+//! This function sets up RS-485 direction control for an instance.
 //!
-//! \param psSerialInstance is the value that was returned from the call to
-//! USBHCDCOpen().
-//! \param pui8Data is the memory buffer storing the data.
-//! \param ui32Size is how many bytes of data from \e pui8Buffer should be
-//! written to the endpoint.
+//! \param psSerialInstance is an instance pointer, received by global callback
+//! function.
+//! \param psRs485 is the direction control, or 0 to turn it off.
+//!
+//! With direction control the transceiver driver enable, wired to RTS or DTR
+//! of the adapter, is switched on before the first queued byte is sent and
+//! off as soon as the device has sent the last one, so the application no
+//! longer has to guess when the line is free.  Data queued with
+//! USBHostSerialScheduleWrite() while the line is receiving waits until
+//! USBHostSerialProcess() has switched it and \e ui32PreDelay has passed.
+//! After the last packet USBHostSerialProcess() polls the device until its
+//! transmit buffer is empty, for drivers that can tell, waits
+//! \e ui32PostDelay to cover the last character and switches back.  Writes
+//! arriving meanwhile continue the transmission without switching.  Set
+//! the delays with the clock registered with USBHostSerialSetClock(); without
+//! a clock they are not applied.
 //!
-//! This function will not block for sending but will load the USB FIFO with
-//! the provided data.  The amount of data loaded will be limited to what will
-//! fit in the FIFO for provided Pipe which in this case is the CDC Bulk Out
-//! pipe.
+//! The library must be built with USBHS_RS485 set.  Call the function from
+//! the main loop, for example from the \b USB_EVENT_CONNECTED handler; the
+//! control lines are set to \e ui32Control right away.
 //!
-//! \return None
+//! \return Returns 0 on success or non-zero if the instance is sending or
+//! direction control is not built in.
 //
 //*****************************************************************************
-void USBHostSerialScheduleWrite(tSerialInstance *psSerialInstance, uint8_t *pui8Data,
-                                 uint32_t ui32Size)
+uint32_t USBHostSerialSetRs485(tSerialInstance *psSerialInstance,
+                               const tUSBHSRs485 *psRs485)
 {
+#if USBHS_RS485
+    tUSBHSRs485Stats *psStats;
+
     //
-    // Schedule the next OUT Pipe transaction.
+    // Only change the direction control while nothing is being sent.
     //
-    USBHCDPipeSchedule(psSerialInstance->ui32BulkOutPipe, pui8Data, ui32Size);
-}
+    if(!USBHSAtomicCAS(&psSerialInstance->ui32Rs485State, RS485_IDLE,
+                       RS485_OFF) &&
+       ((psSerialInstance->ui32Rs485State != RS485_OFF) ||
+        psSerialInstance->ui32TxBusy))
+    {
+        return(1);
+    }
 
-uint16_t USBHostSerialReadDataCount(tSerialInstance *psSerialInstance)
-{
-    return(psSerialInstance->ui16PipeSizeIn);
-}
+    if(psRs485 == 0)
+    {
+        return(0);
+    }
 
+    psSerialInstance->sRs485 = *psRs485;
 
+    psStats = &psSerialInstance->sRs485Stats;
+    psStats->ui32Transmissions = 0;
+    psStats->ui32Assert = 0;
+    psStats->ui32Turnaround = 0;
+    psStats->ui32TurnaroundMax = 0;
 
+    USBHS_DRIVER_CALL(psSerialInstance, SetControlLineState,
+                      (psSerialInstance, psRs485->ui32Control));
 
+    USBHSMemoryBarrier();
+    psSerialInstance->ui32Rs485State = RS485_IDLE;
 
+    return(0);
+#else
+    return(1);
+#endif
+}
+
+//*****************************************************************************
+//
+//! This function returns the RS-485 direction statistics of an instance.
+//!
+//! \param psSerialInstance is the instance to read.
+//! \param psStats receives the statistics.
+//!
+//! The statistics restart with each USBHostSerialSetRs485() call.  The
+//! turnaround is the time from the completion of the last packet until the
+//! request switching the transceiver back has completed, and shows how much
+//! the post-delay can be reduced.  Without USBHS_RS485 all values are 0.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void USBHostSerialGetRs485Stats(tSerialInstance *psSerialInstance,
+                                tUSBHSRs485Stats *psStats)
+{
+#if USBHS_RS485
+    *psStats = psSerialInstance->sRs485Stats;
+#else
+    psStats->ui32Transmissions = 0;
+    psStats->ui32Assert = 0;
+    psStats->ui32Turnaround = 0;
+    psStats->ui32TurnaroundMax = 0;
+#endif
+}
@@ -43,18 +43,568 @@ extern "C"
 //
 //*****************************************************************************
 
+//*****************************************************************************
+//
+//! Maximum number of serial devices connected at the same time.
+//
+//*****************************************************************************
+#ifndef USBHS_MAX_INSTANCES
+#define USBHS_MAX_INSTANCES     10
+#endif
+
+//*****************************************************************************
+//
+//! Number of buffers that can be waiting in the transmit submission queue of
+//! each instance.  Must be a power of two, or 0 to remove the queue.  Without
+//! the queue a single buffer can be in flight and USBHostSerialScheduleWrite()
+//! fails until it has completed.
+//
+//*****************************************************************************
+#ifndef USBHS_TX_QUEUE_DEPTH
+#define USBHS_TX_QUEUE_DEPTH    8
+#endif
+
+//*****************************************************************************
+//
+//! Largest bulk packet the library receives.  A full speed host needs the
+//! default of 64; set it to 512 for high speed devices on a ULPI host.
+//! Receive buffers of USB_TRANSFER_SIZE bytes follow it, and devices with a
+//! larger endpoint are not opened.
+//
+//*****************************************************************************
+#ifndef USBHS_MAX_PACKET
+#define USBHS_MAX_PACKET        64
+#endif
+
+//*****************************************************************************
+//
+//! Set USBHS_TX_GATHER to 0 to remove the packet buffer each instance uses to
+//! pack the segments passed to USBHostSerialWriteV() into full packets.  The
+//! buffer takes USBHS_MAX_PACKET bytes in each of the USBHS_MAX_INSTANCES
+//! instances, even when segment lists are never sent.  Without it the
+//! segments are sent one after the other, each ending in a short packet.
+//
+//*****************************************************************************
+#ifndef USBHS_TX_GATHER
+#define USBHS_TX_GATHER         1
+#endif
+
+//*****************************************************************************
+//
+//! Set USBHS_SCRATCH_BUFFER to 0 to remove the shared receive buffer used for
+//! instances without an application buffer.  Data received by such instances
+//! is then dropped without being copied.
+//
+//*****************************************************************************
+#ifndef USBHS_SCRATCH_BUFFER
+#define USBHS_SCRATCH_BUFFER    1
+#endif
+
+//*****************************************************************************
+//
+//! Set USBHS_POOL_BLOCKS to the number of packet sized blocks shared by all
+//! instances, see USBHostSerialPoolAlloc().  Instances without an application
+//! receive buffer then receive into blocks taken from the pool instead of the
+//! scratch buffer, each holding at most USBHS_POOL_QUOTA blocks at a time.
+//! The default of 0 leaves the pool out.
+//
+//*****************************************************************************
+#ifndef USBHS_POOL_BLOCKS
+#define USBHS_POOL_BLOCKS       0
+#endif
+
+#ifndef USBHS_POOL_QUOTA
+#define USBHS_POOL_QUOTA        4
+#endif
+
+//*****************************************************************************
+//
+//! Set USBHS_INT_IN_PIPE to 0 to leave the interrupt IN endpoint of the
+//! devices unused.  This saves a pipe and its FIFO space per device.
+//
+//*****************************************************************************
+#ifndef USBHS_INT_IN_PIPE
+#define USBHS_INT_IN_PIPE       1
+#endif
+
+//*****************************************************************************
+//
+//! Size of the buffer each instance receives interrupt IN notifications
+//! into.  The CDC SERIAL_STATE notification takes 10 bytes; longer ones are
+//! cut short.
+//
+//*****************************************************************************
+#ifndef USBHS_NOTIFY_SIZE
+#define USBHS_NOTIFY_SIZE       16
+#endif
+
+//*****************************************************************************
+//
+//! Number of devices whose configuration is remembered across reconnects, or
+//! 0 to disable the configuration store.
+//
+//*****************************************************************************
+#ifndef USBHS_CONFIG_STORE
+#define USBHS_CONFIG_STORE      4
+#endif
+
+//*****************************************************************************
+//
+//! Set USBHS_DEFERRED_INIT to 0 to remove USBHostSerialSetupDeferred() and
+//! send the stored configuration of reconnected devices while they are
+//! opened.
+//
+//*****************************************************************************
+#ifndef USBHS_DEFERRED_INIT
+#define USBHS_DEFERRED_INIT     1
+#endif
+
+//*****************************************************************************
+//
+//! Set USBHS_RX_TIMESTAMP to 0 to stop recording when received packets
+//! arrived.
+//
+//*****************************************************************************
+#ifndef USBHS_RX_TIMESTAMP
+#define USBHS_RX_TIMESTAMP      1
+#endif
+
+//*****************************************************************************
+//
+//! Set USBHS_IN_BUDGET to the number of bulk IN pipes that may be armed in
+//! one USB frame to share the bus between the instances by their weights,
+//! see USBHostSerialSetWeight().  Instances that received nothing for
+//! USBHS_IN_IDLE_FRAMES frames are then polled only every
+//! USBHS_IN_IDLE_INTERVAL frames.  With the default of 0 every pipe is armed
+//! at the polling interval of its driver.
+//
+//*****************************************************************************
+#ifndef USBHS_IN_BUDGET
+#define USBHS_IN_BUDGET         0
+#endif
+
+#ifndef USBHS_IN_IDLE_FRAMES
+#define USBHS_IN_IDLE_FRAMES    16
+#endif
+
+#ifndef USBHS_IN_IDLE_INTERVAL
+#define USBHS_IN_IDLE_INTERVAL  8
+#endif
+
+//*****************************************************************************
+//
+//! Number of packet buffers in a bridge between two instances, see
+//! USBHostSerialBridge().  Set to 0 to remove bridging.
+//
+//*****************************************************************************
+#ifndef USBHS_BRIDGE_BUFFERS
+#define USBHS_BRIDGE_BUFFERS    4
+#endif
+
+//*****************************************************************************
+//
+//! Number of times USBHostSerialProcess() tries to recover a stalled or
+//! failing pipe of a device before giving up, and the delay before the first
+//! try in USB frames.  The delay doubles with every further try.  Set
+//! USBHS_RECOVERY_RETRIES to 0 to remove recovery.
+//
+//*****************************************************************************
+#ifndef USBHS_RECOVERY_RETRIES
+#define USBHS_RECOVERY_RETRIES  5
+#endif
+
+#ifndef USBHS_RECOVERY_DELAY
+#define USBHS_RECOVERY_DELAY    4
+#endif
+
+//*****************************************************************************
+//
+//! Set USBHS_EVENT_QUEUE_DEPTH to a power of two to call the instance
+//! callbacks for received and sent data from USBHostSerialProcessEvents()
+//! instead of the USB interrupt.  The pipe callbacks then only queue a small
+//! event record.  With the default of 0 the callbacks run in the interrupt.
+//
+//*****************************************************************************
+#ifndef USBHS_EVENT_QUEUE_DEPTH
+#define USBHS_EVENT_QUEUE_DEPTH 0
+#endif
+
+//*****************************************************************************
+//
+//! USBHS_EVENT_TX_RESERVE records of the event queue are kept for
+//! \b USB_EVENT_TX_COMPLETE, which hands a transmit buffer back to the
+//! application.  Other events are lost once no more records are free, so a
+//! full queue drops received data before it drops a completion.
+//
+//*****************************************************************************
+#ifndef USBHS_EVENT_TX_RESERVE
+#define USBHS_EVENT_TX_RESERVE  (USBHS_EVENT_QUEUE_DEPTH / 4)
+#endif
+
+//*****************************************************************************
+//
+//! Set USBHS_QUEUE_POLL to ask devices every that many USB frames how much
+//! received data they hold, for drivers that can tell, such as the CP210x.
+//! When data is waiting the bulk IN pipe is read back to back until it has
+//! been received, instead of one packet per polling interval.  With the
+//! default of 0 devices are not asked.
+//
+//*****************************************************************************
+#ifndef USBHS_QUEUE_POLL
+#define USBHS_QUEUE_POLL        0
+#endif
+
+//*****************************************************************************
+//
+//! Set USBHS_RS485 to 1 to let USBHostSerialSetRs485() switch the driver
+//! enable of an RS-485 transceiver with RTS or DTR around each transmission.
+//! The default of 0 leaves it out.
+//
+//*****************************************************************************
+#ifndef USBHS_RS485
+#define USBHS_RS485             0
+#endif
+
+//*****************************************************************************
+//
+//! Set USBHS_RX_REARM to 0 to leave the bulk IN pipe idle after a packet until
+//! the next poll.  With the default of 1 the pipe is armed again as soon as
+//! a packet with data was read, before the application callback runs, so
+//! the device can keep sending.  A second receive buffer, see
+//! USBHostSerialSetupDoubleBuffer(), lets this work with DMA and with the
+//! event queue as well.
+//
+//*****************************************************************************
+#ifndef USBHS_RX_REARM
+#define USBHS_RX_REARM          1
+#endif
+
+//*****************************************************************************
+//
+//! Define USBHS_DMA to move bulk data with the uDMA controller instead of
+//! copying it through the endpoint FIFOs.  Transmit buffers are then sent in
+//! transfers of up to USBHS_DMA_MAX_TRANSFER bytes, which must be a multiple
+//! of the bulk packet size, and received packets are written straight into
+//! the receive buffer of the instance.  Buffers must be in SRAM and the
+//! application must enable the uDMA controller and set its control table
+//! before USBHCDInit() is called.
+//
+//*****************************************************************************
+#ifndef USBHS_DMA_MAX_TRANSFER
+#define USBHS_DMA_MAX_TRANSFER  1024
+#endif
+
+//*****************************************************************************
+//
+//! Bulk IN scheduling statistics of an instance, returned by
+//! USBHostSerialGetShare().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Number of times the bulk IN pipe was armed.
+    //
+    uint32_t ui32Armed;
+
+    //
+    //! Number of polls held back by the frame budget or by the weights.
+    //
+    uint32_t ui32Deferred;
+
+    //
+    //! Number of packets and bytes received.
+    //
+    uint32_t ui32Packets;
+    uint32_t ui32Bytes;
+
+    //
+    //! Share of all bulk IN pipes armed, in units of 1/1000.
+    //
+    uint32_t ui32Share;
+} tUSBHSInShare;
+
+//*****************************************************************************
+//
+//! Pipe error counters of an instance, returned by USBHostSerialGetErrors().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Number of stalls and other transfer errors reported on the pipes.
+    //
+    uint32_t ui32Stalls;
+    uint32_t ui32Errors;
+
+    //
+    //! Number of times halted pipes were cleared and restarted.
+    //
+    uint32_t ui32Recoveries;
+
+    //
+    //! Number of times recovery was given up.
+    //
+    uint32_t ui32Failures;
+} tUSBHSPipeErrors;
+
+//*****************************************************************************
+//
+//! RS-485 direction control of an instance, passed to
+//! USBHostSerialSetRs485().  Delays are in ticks of the clock registered
+//! with USBHostSerialSetClock().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Control lines while receiving, a combination of \b USBHS_CONTROL_DTR
+    //! and \b USBHS_CONTROL_RTS.
+    //
+    uint32_t ui32Control;
+
+    //
+    //! Control lines that are inverted while sending.
+    //
+    uint32_t ui32Drive;
+
+    //
+    //! Time from switching to sending until the first packet is sent.
+    //
+    uint32_t ui32PreDelay;
+
+    //
+    //! Time from the device having sent the last byte until switching back
+    //! to receiving.
+    //
+    uint32_t ui32PostDelay;
+} tUSBHSRs485;
+
+//*****************************************************************************
+//
+//! RS-485 direction statistics of an instance, returned by
+//! USBHostSerialGetRs485Stats().  Times are in clock ticks.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Number of times the transceiver was switched to sending.
+    //
+    uint32_t ui32Transmissions;
+
+    //
+    //! Time from the first buffer being queued until its first packet was
+    //! sent, for the last transmission.
+    //
+    uint32_t ui32Assert;
+
+    //
+    //! Time from the last packet being sent until the transceiver was back
+    //! to receiving, for the last transmission and the longest.
+    //
+    uint32_t ui32Turnaround;
+    uint32_t ui32TurnaroundMax;
+} tUSBHSRs485Stats;
+
+//*****************************************************************************
+//
+//! Baud rates a device supports, returned by USBHostSerialGetBaudRange().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Lowest and highest baud rate.
+    //
+    uint32_t ui32Min;
+    uint32_t ui32Max;
+
+    //
+    //! A combination of the USBHS_BAUD_ flags.
+    //
+    uint32_t ui32Flags;
+} tUSBHSBaudRange;
+
+//*****************************************************************************
+//
+//! Set in tUSBHSBaudRange::ui32Flags if the driver knows the rates the
+//! device produces.  Otherwise rates are passed to the device unchecked and
+//! reported as exact.
+//
+//*****************************************************************************
+#define USBHS_BAUD_COMPUTED     0x00000001
+
+//*****************************************************************************
+//
+//! Interrupt time and event queue statistics, returned by
+//! USBHostSerialGetEventStats().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Longest time spent in a pipe callback of the library, including the
+    //! application callbacks it called, in application clock ticks.
+    //
+    uint32_t ui32IsrTimeMax;
+
+    //
+    //! Most events waiting in the event queue at the same time.
+    //
+    uint32_t ui32EventsPeak;
+
+    //
+    //! Number of events lost because the event queue was full.  When it is
+    //! not 0 a \b USB_EVENT_TX_COMPLETE may have been lost as well, and the
+    //! buffer it reported is never handed back.
+    //
+    uint32_t ui32EventsLost;
+} tUSBHSEventStats;
+
+//*****************************************************************************
+//
+//! Buffer pool statistics, returned by USBHostSerialGetPoolStats().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Number of blocks in the pool, USBHS_POOL_BLOCKS, and the number that
+    //! are free.
+    //
+    uint32_t ui32Blocks;
+    uint32_t ui32Free;
+
+    //
+    //! Fewest blocks that were free at the same time.
+    //
+    uint32_t ui32FreeMin;
+
+    //
+    //! Number of times a block was refused because the pool was empty or
+    //! because the instance held its quota.
+    //
+    uint32_t ui32Empty;
+    uint32_t ui32OverQuota;
+} tUSBHSPoolStats;
+
+//*****************************************************************************
+//
+//! One segment of the data passed to USBHostSerialWriteV().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Start of the segment.
+    //
+    const void *pvData;
+
+    //
+    //! Number of bytes in the segment.
+    //
+    uint32_t ui32Size;
+} tUSBHSIoVec;
+
+//*****************************************************************************
+//
+//! A single entry of a lock-free submission queue.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // Slot sequence number used to hand the entry between producers and the
+    // consumer.
+    //
+    volatile uint32_t ui32Sequence;
+
+    //
+    // Entry payload.
+    //
+    void *pvData;
+    uint32_t ui32Value;
+} tUSBHSQueueEntry;
+
+//*****************************************************************************
+//
+//! A lock-free multi-producer, single-consumer submission queue.
+//
+//*****************************************************************************
+typedef struct
+{
+    tUSBHSQueueEntry *psEntries;
+    uint32_t ui32Mask;
+    volatile uint32_t ui32Head;
+    volatile uint32_t ui32Tail;
+} tUSBHSQueue;
+
+#if USBHS_BRIDGE_BUFFERS
+//*****************************************************************************
+//
+//! Forwarding state of a bridge, defined below.
+//
+//*****************************************************************************
+typedef struct tUSBHSBridge tUSBHSBridge;
+#endif
+
+//*****************************************************************************
+//
+//! Device setup passed to USBHostSerialSetupDeferred().  Only the items
+//! selected in ui32Items are sent.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Combination of the USBHS_SETUP_ values.
+    //
+    uint32_t ui32Items;
+
+    //
+    //! Values for USBHostSerialSetLineConfig().
+    //
+    uint32_t ui32Baud;
+    uint32_t ui32Coding;
+
+    //
+    //! Value for USBHostSerialSetFlow().
+    //
+    uint32_t ui32Flow;
+
+    //
+    //! Value for USBHostSerialSetControlLineState().
+    //
+    uint32_t ui32Control;
+} tUSBHSLineSetup;
+
+#define USBHS_SETUP_INIT        0x00000001
+#define USBHS_SETUP_LINE        0x00000002
+#define USBHS_SETUP_CONTROL     0x00000004
+#define USBHS_SETUP_FLOW        0x00000008
+
 //*****************************************************************************
 //
 //! This is the structure that holds all of the data for a given instance of
 //! a serial device.
+//!
+//! The fields used by the pipe callbacks in interrupt context come first and
+//! the configuration that is only used when a device is opened or set up
+//! follows.  Within each part the fields are ordered by size so that the
+//! compiler does not need to insert padding.
 //
 //*****************************************************************************
 typedef struct
 {
     //
-    // Save the device instance.
+    // Pipes of the device, used to find the instance from a pipe callback.
     //
-    tUSBHostDevice *psDevice;
+    uint32_t ui32BulkInPipe;
+    uint32_t ui32BulkOutPipe;
+#if USBHS_INT_IN_PIPE
+    uint32_t ui32IntInPipe;
+#endif
 
     //
     // Used to save the callback.
@@ -67,38 +617,361 @@ typedef struct
     void *pvCBData;
 
     //
-    // Used to remember what type of device was registered.
+    // Receive buffer provided by the application.
     //
-    uint8_t ui8Driver;
+    void *pvInBuffer;
 
-    bool bConnected;
+#if USBHS_RX_REARM
+    //
+    // Second receive buffer, swapped with pvInBuffer after every packet that
+    // is passed to the application.
+    //
+    void *pvInBufferAlt;
+#endif
 
+#if USBHS_POOL_BLOCKS
     //
-    // Bulk IN pipe.
+    // Pool block the bulk IN pipe receives into, the number of blocks held
+    // by the instance and the application, and the number of blocks refused.
     //
-    uint32_t ui32BulkInPipe;
-    uint16_t ui16PipeSizeIn;
-    tUSBCallback pfnInCallback;
-    void *pvInBuffer;
+    uint8_t *pui8PoolRx;
+    volatile uint32_t ui32PoolUsed;
+    uint32_t ui32PoolDenied;
+#endif
 
+#if USBHS_RX_TIMESTAMP
     //
-    // Bulk OUT pipe.
+    // Application clock when the last packet was read.
     //
-    uint32_t ui32BulkOutPipe;
+    uint32_t ui32RxTime;
+#endif
+
+#if USBHS_IN_BUDGET
+    //
+    // Bulk IN scheduler pass, advanced by the stride of the weight every
+    // time the pipe is armed, and the statistics.  ui32Share is only filled
+    // in by USBHostSerialGetShare().
+    //
+    uint32_t ui32InPass;
+    tUSBHSInShare sInShare;
+#endif
+
+#if USBHS_BRIDGE_BUFFERS
+    //
+    // Bridge forwarding the data received by this instance, or 0.  Kept
+    // while the other side still sends bridge buffers after the bridge was
+    // removed or this device disconnected.
+    //
+    tUSBHSBridge *psBridge;
+#endif
+
+    //
+    // Transmit state.  ui32TxBusy is owned by whichever context currently
+    // feeds the bulk OUT pipe.  pvTxBuffer is the buffer or segment list
+    // being sent, ui32TxSize its size and ui32TxRemaining the bytes not sent
+    // yet.  pui8TxData is the next byte of the current segment, which holds
+    // ui32TxSegment more, and psTxVec the segment after it.  bTxZlp is set
+    // while an empty buffer waits to be sent as a zero length packet.
+    //
+    volatile uint32_t ui32TxBusy;
+    void *pvTxBuffer;
+    uint8_t *pui8TxData;
+    const tUSBHSIoVec *psTxVec;
+    uint32_t ui32TxRemaining;
+    uint32_t ui32TxSegment;
+    uint32_t ui32TxSize;
+    bool bTxZlp;
+
+    //
+    // Set by USBHostSerialPurge() for the owner of the bulk OUT pipe to drop
+    // the data not yet sent.
+    //
+    volatile bool bTxPurge;
+
+#if USBHS_TX_QUEUE_DEPTH > 0
+    //
+    // Transmit submission queue.
+    //
+    tUSBHSQueue sTxQueue;
+    tUSBHSQueueEntry psTxEntries[USBHS_TX_QUEUE_DEPTH];
+#endif
+
+#if USBHS_TX_GATHER
+    //
+    // Packet packed from the ends of short segments.
+    //
+    uint8_t pui8TxPacket[USBHS_MAX_PACKET];
+#endif
+
+    //
+    // Save the device instance.
+    //
+    tUSBHostDevice *psDevice;
+
+#if USBHS_RECOVERY_RETRIES
+    //
+    // Pipes waiting to be recovered, a combination of the USBHS_HALT_
+    // values set by the pipe callbacks, and the error counters.
+    //
+    volatile uint32_t ui32Halted;
+    tUSBHSPipeErrors sErrors;
+
+    //
+    // Last bulk OUT transfer, sent again after a stall.
+    //
+    uint8_t *pui8TxLast;
+#endif
+
+#if USBHS_QUEUE_POLL
+    //
+    // Bytes the device reported queued, less those received since.
+    //
+    uint32_t ui32DeviceQueue;
+#endif
+
+#if USBHS_RS485
+    //
+    // RS-485 direction control, the direction state, the time it last
+    // changed, the time the first buffer was queued and the statistics.
+    //
+    tUSBHSRs485 sRs485;
+    volatile uint32_t ui32Rs485State;
+    volatile uint32_t ui32Rs485Time;
+    uint32_t ui32Rs485Queued;
+    tUSBHSRs485Stats sRs485Stats;
+#endif
+
+#if USBHS_CONFIG_STORE
+    //
+    // Hash of the serial number string, used to find the stored
+    // configuration of the device.
+    //
+    uint32_t ui32SerialHash;
+#endif
+
+#if USBHS_DEFERRED_INIT
+    //
+    // Setup steps still to be sent by USBHostSerialProcess().
+    //
+    tUSBHSLineSetup sPending;
+#endif
+
+    //
+    // Size of the last received packet and the bulk OUT packet size.
+    //
+    uint16_t ui16PipeSizeIn;
     uint16_t ui16PipeSizeOut;
-    tUSBCallback pfnOutCallback;
-    void *pvOutBuffer;
 
     //
-    // Interrupt IN pipe.
+    // Bulk IN packet size of the device and the size of the application
+    // receive buffers.
     //
-    uint32_t ui32IntInPipe;
-    uint16_t ui16PipeSizeIntIn;
-    tUSBCallback pfnIntInCallback;
-    void *pvIntInBuffer;
+    uint16_t ui16PacketSizeIn;
+    uint16_t ui16InBufferSize;
+
+#if USBHS_RX_TIMESTAMP
+    //
+    // USB frame number when the last packet was read.
+    //
+    uint16_t ui16RxFrame;
+#endif
+
+#if USBHS_RECOVERY_RETRIES
+    //
+    // Size of the last bulk OUT transfer, the frame of the next recovery
+    // try and the number of tries so far.
+    //
+    uint16_t ui16TxLast;
+    uint16_t ui16RetryFrame;
+    uint8_t ui8Retries;
+#endif
+
+#if USBHS_QUEUE_POLL
+    //
+    // Frame the device queue was last read, and whether the driver cannot
+    // read it.
+    //
+    uint16_t ui16QueueFrame;
+    bool bQueueUnknown;
+#endif
+
+#if USBHS_EVENT_QUEUE_DEPTH
+    //
+    // Receive events queued by the interrupt and handled by
+    // USBHostSerialProcessEvents().  A receive buffer is not used again
+    // until its event has been handled, nor the notification buffer.
+    //
+    volatile uint8_t ui8RxQueued;
+    volatile uint8_t ui8RxHandled;
+#if USBHS_INT_IN_PIPE
+    volatile bool bNotifyQueued;
+#endif
+#endif
+
+#if USBHS_IN_BUDGET
+    //
+    // Frames the last data was received and the pipe was last armed, the
+    // scheduler weight and whether the pipe is armed.
+    //
+    uint16_t ui16InLastData;
+    uint16_t ui16InLastArm;
+    uint8_t ui8InWeight;
+    bool bInArmed;
+#endif
+
+#if USBHS_POOL_BLOCKS
+    //
+    // Most blocks the instance may hold, 0 to receive without the pool.
+    //
+    uint8_t ui8PoolQuota;
+#endif
+
+    bool bConnected;
+
+    //
+    // Used to remember what type of device was registered.
+    //
+    uint8_t ui8Driver;
+
+    //
+    // Device variant found by the driver, such as the CP210x part number.
+    //
+    uint8_t ui8Variant;
+
+    //
+    // Endpoint addresses of the pipes, used to label captured traffic.
+    //
+    uint8_t ui8BulkInEndpoint;
+    uint8_t ui8BulkOutEndpoint;
+#if USBHS_INT_IN_PIPE
+    uint8_t ui8IntInEndpoint;
+
+    //
+    // Last notification received on the interrupt IN pipe.
+    //
+    uint8_t pui8Notify[USBHS_NOTIFY_SIZE];
+#endif
 } tSerialInstance;
 
-#define USB_TRANSFER_SIZE       64
+#define USB_TRANSFER_SIZE       USBHS_MAX_PACKET
+
+#if USBHS_BRIDGE_BUFFERS
+//*****************************************************************************
+//
+//! A bridge forwarding the data received by one instance to another, set up
+//! with USBHostSerialBridge().  The memory is provided by the application;
+//! only the counters may be read by it.
+//
+//*****************************************************************************
+struct tUSBHSBridge
+{
+    //
+    //! Number of packets and bytes forwarded.
+    //
+    uint32_t ui32Packets;
+    uint32_t ui32Bytes;
+
+    //
+    //! Number of polls of the receiving device held back because all
+    //! buffers were waiting to be sent.
+    //
+    uint32_t ui32Held;
+
+    //
+    // Instance the data is sent to.
+    //
+    tSerialInstance *psSink;
+
+    //
+    // Free running counts of buffers filled, handed to the sink and sent.
+    //
+    volatile uint32_t ui32Filled;
+    volatile uint32_t ui32Sent;
+    volatile uint32_t ui32Done;
+
+    //
+    // Set while the bridge forwards new data, and while the bulk IN pipe is
+    // armed to receive into the next buffer.
+    //
+    volatile bool bActive;
+    bool bArmed;
+
+    //
+    // Packet buffers and the size of the packet in each.
+    //
+    uint16_t pui16Size[USBHS_BRIDGE_BUFFERS];
+    uint8_t pui8Data[USBHS_BRIDGE_BUFFERS][USB_TRANSFER_SIZE];
+};
+#endif
+
+//*****************************************************************************
+//
+//! RAM used by the library, computed when the library is built.  The values
+//! are available in g_sUSBHSMemoryReport and the image, so they can be read
+//! from the map file or a debugger without running the code.  Buffers handed
+//! to the library by the application are not included.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Size of one tSerialInstance.
+    //
+    uint32_t ui32InstanceSize;
+
+    //
+    //! Number of instances, USBHS_MAX_INSTANCES.
+    //
+    uint32_t ui32Instances;
+
+    //
+    //! Size of the shared receive scratch buffer.
+    //
+    uint32_t ui32ScratchSize;
+
+    //
+    //! Total static RAM used by the library.
+    //
+    uint32_t ui32StaticSize;
+
+    //
+    //! Bytes of ui32InstanceSize taken by the transmit queue
+    //! (USBHS_TX_QUEUE_DEPTH), the gather packet buffer (USBHS_TX_GATHER) and
+    //! the interrupt IN notification buffer (USBHS_NOTIFY_SIZE), 0 for the
+    //! options that are disabled.
+    //
+    uint32_t ui32TxQueueSize;
+    uint32_t ui32TxGatherSize;
+    uint32_t ui32NotifySize;
+} tUSBHSMemoryReport;
+
+extern const tUSBHSMemoryReport g_sUSBHSMemoryReport;
+
+//*****************************************************************************
+//
+//! Prototype of the application time source registered with
+//! USBHostSerialSetClock().
+//
+//*****************************************************************************
+typedef uint32_t (* tUSBHSClock)(void);
+
+//*****************************************************************************
+//
+//! Arrival time of received data, returned by USBHostSerialReadTimestamp().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Application clock ticks, see USBHostSerialSetClock().
+    //
+    uint32_t ui32Time;
+
+    //
+    //! USB frame number, counting start of frames modulo 2048.
+    //
+    uint16_t ui16Frame;
+} tUSBHSTimestamp;
 
 //*****************************************************************************
 //
@@ -137,6 +1010,63 @@ typedef struct
 #define USBHS_CONTROL_DTR       0x00000010
 #define USBHS_CONTROL_RTS       0x00000020
 
+//*****************************************************************************
+//
+//! ui32MsgParam of USB_EVENT_CONNECTED when the stored configuration of the
+//! device has been applied again.
+//
+//*****************************************************************************
+
+#define USBHS_CONNECTED_RESTORED    0x00000001
+
+//*****************************************************************************
+//
+//! Instance events specific to the serial host library.
+//
+//*****************************************************************************
+
+//
+//! All steps queued with USBHostSerialSetupDeferred() have been sent.
+//
+#define USBHS_EVENT_READY       (USB_CLASS_EVENT_BASE + 0)
+
+//
+//! Halted pipes have been cleared and restarted.  \e ui32MsgParam holds the
+//! USBHS_HALT_ values of the pipes.
+//
+#define USBHS_EVENT_RECOVERED   (USB_CLASS_EVENT_BASE + 1)
+
+//
+//! Recovery of the pipes in \e ui32MsgParam was given up.  The pipes stay
+//! halted until the device is connected again.
+//
+#define USBHS_EVENT_PIPE_FAILED (USB_CLASS_EVENT_BASE + 2)
+
+//
+//! A notification was received on the interrupt IN endpoint, such as the
+//! CDC SERIAL_STATE.  \e pvMsgData points to it and \e ui32MsgParam holds
+//! its size.  The data stays valid until the callback returns.
+//
+#define USBHS_EVENT_NOTIFY      (USB_CLASS_EVENT_BASE + 3)
+
+//*****************************************************************************
+//
+//! Pipes reported with \b USBHS_EVENT_RECOVERED and
+//! \b USBHS_EVENT_PIPE_FAILED.
+//
+//*****************************************************************************
+#define USBHS_HALT_IN           0x00000001
+#define USBHS_HALT_OUT          0x00000002
+#define USBHS_HALT_INT          0x00000004
+
+//*****************************************************************************
+//
+//! Returned by the GetRxQueue driver function if the device cannot report
+//! how much received data it holds.
+//
+//*****************************************************************************
+#define USBHS_QUEUE_UNKNOWN     0xFFFFFFFF
+
 //*****************************************************************************
 //
 //! Constants for flow control values
@@ -166,25 +1096,75 @@ typedef struct
 //
 //*****************************************************************************
 extern uint32_t USBHostSerialInit(tUSBCallback pfnCallback);
+extern void USBHostSerialSetClock(tUSBHSClock pfnClock);
 
 extern uint32_t USBHostSerialSetupInstance(tSerialInstance *psSerialInstance,
                                            tUSBCallback pfnCallback, void *pvRxBuffer);
+extern uint32_t USBHostSerialSetupDoubleBuffer(tSerialInstance *psSerialInstance,
+                                               void *pvRxBuffer,
+                                               uint32_t ui32Size);
+extern uint32_t USBHostSerialGetPacketSize(tSerialInstance *psSerialInstance);
+extern uint32_t USBHostSerialSetRxBufferSize(tSerialInstance *psSerialInstance,
+                                             uint32_t ui32Size);
 
-extern void USBHostSerialScheduleWrite(tSerialInstance *psSerialInstance, uint8_t *pui8Data,
-                                 uint32_t ui32Size);
+extern uint32_t USBHostSerialScheduleWrite(tSerialInstance *psSerialInstance, uint8_t *pui8Data,
+                                           uint32_t ui32Size);
+extern uint32_t USBHostSerialWriteV(tSerialInstance *psSerialInstance,
+                                    const tUSBHSIoVec *psVec,
+                                    uint32_t ui32Count);
 
 extern uint16_t USBHostSerialReadDataCount(tSerialInstance *psSerialInstance);
+extern void USBHostSerialReadTimestamp(tSerialInstance *psSerialInstance,
+                                       tUSBHSTimestamp *psTimestamp);
 
 extern uint32_t USBHostSerialInitNewDevice(tSerialInstance *psSerialInstance);
 
 extern uint32_t USBHostSerialSetLineConfig(tSerialInstance *psSerialInstance, uint32_t ui32Baud, uint32_t ui32Coding);
 extern uint32_t USBHostSerialGetBaud(tSerialInstance *psSerialInstance);
+extern uint32_t USBHostSerialGetBaudActual(tSerialInstance *psSerialInstance,
+                                           uint32_t ui32Baud,
+                                           int32_t *pi32Error);
+extern void USBHostSerialGetBaudRange(tSerialInstance *psSerialInstance,
+                                      tUSBHSBaudRange *psRange);
 extern uint32_t USBHostSerialGetCoding(tSerialInstance *psSerialInstance);
 extern uint32_t USBHostSerialSetControlLineState(tSerialInstance *psSerialInstance, uint32_t ui32Control);
 extern uint32_t USBHostSerialGetControlLineState(tSerialInstance *psSerialInstance);
 extern uint32_t USBHostSerialSetFlow(tSerialInstance *psSerialInstance, uint32_t ui32Flow);
 extern uint32_t USBHostSerialBreakSet(tSerialInstance *psSerialInstance);
 extern uint32_t USBHostSerialBreakClear(tSerialInstance *psSerialInstance);
+extern uint32_t USBHostSerialPurge(tSerialInstance *psSerialInstance,
+                                   bool bRx, bool bTx);
+extern uint32_t USBHostSerialSetRs485(tSerialInstance *psSerialInstance,
+                                      const tUSBHSRs485 *psRs485);
+extern void USBHostSerialGetRs485Stats(tSerialInstance *psSerialInstance,
+                                       tUSBHSRs485Stats *psStats);
+extern void USBHostSerialConfigClear(void);
+extern void USBHostSerialSetupDeferred(tSerialInstance *psSerialInstance,
+                                       const tUSBHSLineSetup *psSetup);
+extern void USBHostSerialProcess(void);
+extern void USBHostSerialSetWeight(tSerialInstance *psSerialInstance,
+                                   uint8_t ui8Weight);
+extern void USBHostSerialGetShare(tSerialInstance *psSerialInstance,
+                                  tUSBHSInShare *psShare);
+extern void USBHostSerialShareClear(void);
+extern void USBHostSerialGetErrors(tSerialInstance *psSerialInstance,
+                                   tUSBHSPipeErrors *psErrors);
+extern uint32_t USBHostSerialProcessEvents(void);
+extern void USBHostSerialGetEventStats(tUSBHSEventStats *psStats,
+                                       bool bClear);
+extern void *USBHostSerialPoolAlloc(tSerialInstance *psSerialInstance);
+extern void USBHostSerialPoolFree(void *pvBlock);
+extern void USBHostSerialPoolSetQuota(tSerialInstance *psSerialInstance,
+                                      uint32_t ui32Blocks);
+extern uint32_t USBHostSerialPoolGetUsage(tSerialInstance *psSerialInstance,
+                                          uint32_t *pui32Denied);
+extern void USBHostSerialGetPoolStats(tUSBHSPoolStats *psStats, bool bClear);
+#if USBHS_BRIDGE_BUFFERS
+extern uint32_t USBHostSerialBridge(tSerialInstance *psSource,
+                                    tSerialInstance *psSink,
+                                    tUSBHSBridge *psBridge);
+extern bool USBHostSerialUnbridge(tSerialInstance *psSource);
+#endif
 
 
 //*****************************************************************************
@@ -0,0 +1,471 @@
+//*****************************************************************************
+//
+// usbhserial.hpp - Header-only C++17 interface to the serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#ifndef USBHSERIAL_HPP_
+#define USBHSERIAL_HPP_
+
+#if __cplusplus < 201703L
+#error "usbhserial.hpp requires C++17"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialdriver.h"
+#include "usbhserialcdc.h"
+#include "usbhserialcp210x.h"
+
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#if defined(__cpp_lib_span)
+#include <span>
+#endif
+
+//*****************************************************************************
+//
+//! \addtogroup usblib_host_class
+//! @{
+//
+//*****************************************************************************
+
+namespace usbhs
+{
+
+//*****************************************************************************
+//
+//! A view of contiguous bytes.  This is std::span when the standard library
+//! has it, and a minimal replacement with the same interface otherwise.
+//
+//*****************************************************************************
+#if defined(__cpp_lib_span)
+template<typename T>
+using span = std::span<T>;
+#else
+template<typename T>
+class span
+{
+public:
+    constexpr span() noexcept : m_pData(nullptr), m_uSize(0) {}
+    constexpr span(T *pData, std::size_t uSize) noexcept :
+        m_pData(pData), m_uSize(uSize) {}
+    template<std::size_t N>
+    constexpr span(T (&pArray)[N]) noexcept : m_pData(pArray), m_uSize(N) {}
+    template<typename U>
+    constexpr span(const span<U> &sOther) noexcept :
+        m_pData(sOther.data()), m_uSize(sOther.size()) {}
+
+    constexpr T *data() const noexcept { return(m_pData); }
+    constexpr std::size_t size() const noexcept { return(m_uSize); }
+    constexpr bool empty() const noexcept { return(m_uSize == 0); }
+    constexpr T *begin() const noexcept { return(m_pData); }
+    constexpr T *end() const noexcept { return(m_pData + m_uSize); }
+    constexpr T &operator[](std::size_t uIdx) const noexcept
+    {
+        return(m_pData[uIdx]);
+    }
+    constexpr span subspan(std::size_t uOffset) const noexcept
+    {
+        return(span(m_pData + uOffset, m_uSize - uOffset));
+    }
+
+private:
+    T *m_pData;
+    std::size_t m_uSize;
+};
+#endif
+
+//*****************************************************************************
+//
+//! Driver tables for the devices the library supports.  List the ones the
+//! application needs with USBHS_DRIVERS().
+//
+//*****************************************************************************
+inline constexpr tUSBSerialDriver CdcDriver = DECLARE_USB_SERIAL_CDC_DRIVER;
+inline constexpr tUSBSerialDriver Cp210xDriver =
+    DECLARE_USB_SERIAL_CP210X_DRIVER;
+
+//*****************************************************************************
+//
+// Counts the drivers given to USBHS_DRIVERS().
+//
+//*****************************************************************************
+template<typename... Drivers>
+constexpr std::size_t
+DriverCount(const Drivers &...) noexcept
+{
+    return(sizeof...(Drivers));
+}
+
+//*****************************************************************************
+//
+//! Line coding fields, see USBHostSerialSetLineConfig().
+//
+//*****************************************************************************
+enum class DataBits : uint32_t
+{
+    Five = USBHS_CONF_DATA_5,
+    Six = USBHS_CONF_DATA_6,
+    Seven = USBHS_CONF_DATA_7,
+    Eight = USBHS_CONF_DATA_8
+};
+
+enum class Parity : uint32_t
+{
+    None = USBHS_CONF_PAR_NONE,
+    Even = USBHS_CONF_PAR_EVEN,
+    Odd = USBHS_CONF_PAR_ODD,
+    Mark = USBHS_CONF_PAR_MARK,
+    Space = USBHS_CONF_PAR_SPACE
+};
+
+enum class StopBits : uint32_t
+{
+    One = USBHS_CONF_STOP_1,
+    OneHalf = USBHS_CONF_STOP_1_5,
+    Two = USBHS_CONF_STOP_2
+};
+
+//*****************************************************************************
+//
+//! Modem control lines, see USBHostSerialSetControlLineState().
+//
+//*****************************************************************************
+enum class Control : uint32_t
+{
+    None = 0,
+    Cts = USBHS_CONTROL_CTS,
+    Dsr = USBHS_CONTROL_DSR,
+    Ri = USBHS_CONTROL_RI,
+    Dcd = USBHS_CONTROL_DCD,
+    Dtr = USBHS_CONTROL_DTR,
+    Rts = USBHS_CONTROL_RTS
+};
+
+constexpr Control
+operator|(Control eA, Control eB) noexcept
+{
+    return(static_cast<Control>(static_cast<uint32_t>(eA) |
+                                static_cast<uint32_t>(eB)));
+}
+
+constexpr Control
+operator&(Control eA, Control eB) noexcept
+{
+    return(static_cast<Control>(static_cast<uint32_t>(eA) &
+                                static_cast<uint32_t>(eB)));
+}
+
+constexpr bool
+Any(Control eControl) noexcept
+{
+    return(eControl != Control::None);
+}
+
+//*****************************************************************************
+//
+//! Baud rate and line coding, built at compile time:
+//!
+//! \verbatim
+//! constexpr auto sConfig = usbhs::LineConfig(115200).Parity(usbhs::Parity::Even);
+//! \endverbatim
+//!
+//! The default is 8 data bits, no parity and one stop bit.
+//
+//*****************************************************************************
+class LineConfig
+{
+public:
+    constexpr explicit LineConfig(uint32_t ui32Baud) noexcept :
+        m_ui32Baud(ui32Baud),
+        m_ui32Coding(USBHS_CONF_DATA_8 | USBHS_CONF_PAR_NONE |
+                     USBHS_CONF_STOP_1) {}
+
+    constexpr LineConfig(uint32_t ui32Baud, uint32_t ui32Coding) noexcept :
+        m_ui32Baud(ui32Baud), m_ui32Coding(ui32Coding) {}
+
+    constexpr LineConfig Baud(uint32_t ui32Baud) const noexcept
+    {
+        return(LineConfig(ui32Baud, m_ui32Coding));
+    }
+
+    constexpr LineConfig Data(DataBits eData) const noexcept
+    {
+        return(With(USBHS_CONF_DATA_M, static_cast<uint32_t>(eData)));
+    }
+
+    constexpr LineConfig Parity(usbhs::Parity eParity) const noexcept
+    {
+        return(With(USBHS_CONF_PAR_M, static_cast<uint32_t>(eParity)));
+    }
+
+    constexpr LineConfig Stop(StopBits eStop) const noexcept
+    {
+        return(With(USBHS_CONF_STOP_M, static_cast<uint32_t>(eStop)));
+    }
+
+    constexpr uint32_t Baud() const noexcept { return(m_ui32Baud); }
+    constexpr uint32_t Coding() const noexcept { return(m_ui32Coding); }
+
+    constexpr bool operator==(const LineConfig &sOther) const noexcept
+    {
+        return((m_ui32Baud == sOther.m_ui32Baud) &&
+               (m_ui32Coding == sOther.m_ui32Coding));
+    }
+
+    constexpr bool operator!=(const LineConfig &sOther) const noexcept
+    {
+        return(!(*this == sOther));
+    }
+
+private:
+    constexpr LineConfig With(uint32_t ui32Mask, uint32_t ui32Value) const
+        noexcept
+    {
+        return(LineConfig(m_ui32Baud, (m_ui32Coding & ~ui32Mask) | ui32Value));
+    }
+
+    uint32_t m_ui32Baud;
+    uint32_t m_ui32Coding;
+};
+
+//*****************************************************************************
+//
+//! A connected serial device.  Construct the port in the
+//! \b USB_EVENT_CONNECTED handler of the global callback, for example into a
+//! static std::optional, and destroy it after \b USB_EVENT_DISCONNECTED.
+//! The port takes over the instance callback and its pvCBData field and
+//! gives them back when it is destroyed.
+//!
+//! The events are passed to the handler, with the port, through calls that
+//! are resolved at compile time:
+//!
+//! - OnReceive(Port &, span<const uint8_t>) for \b USB_EVENT_RX_AVAILABLE,
+//!   with the data in the receive buffer.  It stays valid until the call
+//!   returns.
+//! - OnSent(Port &, span<const uint8_t>) for \b USB_EVENT_TX_COMPLETE, with
+//!   the buffer passed to Write().  With USBHostSerialPurge() it holds the
+//!   bytes actually sent.
+//! - OnEvent(Port &, uint32_t ui32Event, uint32_t ui32MsgParam) for all other
+//!   events.  For \b USBHS_EVENT_NOTIFY from the interrupt IN pipe
+//!   \e ui32MsgParam is the size of the notification.
+//!
+//! The handler is called in the USB interrupt, or from
+//! USBHostSerialProcessEvents() when the library is built with the event
+//! queue.  Nothing is allocated and every member function is an inline call
+//! of the C function it names.
+//
+//*****************************************************************************
+template<typename Handler>
+class Port
+{
+public:
+    //
+    //! Attaches a port to an instance with one or two receive buffers, see
+    //! USBHostSerialSetRxBufferSize() and USBHostSerialSetupDoubleBuffer().
+    //
+    Port(tSerialInstance *psInstance, Handler &sHandler, span<uint8_t> sRx,
+         span<uint8_t> sRxAlt = span<uint8_t>()) noexcept :
+        m_psInstance(psInstance), m_psHandler(&sHandler)
+    {
+        m_psInstance->pvCBData = this;
+        USBHostSerialSetupInstance(m_psInstance, Callback, sRx.data());
+        USBHostSerialSetRxBufferSize(m_psInstance,
+                                     static_cast<uint32_t>(sRx.size()));
+        if(!sRxAlt.empty())
+        {
+            USBHostSerialSetupDoubleBuffer(
+                m_psInstance, sRxAlt.data(),
+                static_cast<uint32_t>(sRxAlt.size()));
+        }
+    }
+
+    //
+    //! Detaches the port, unless the instance was already given to another
+    //! device.
+    //
+    ~Port()
+    {
+        if(m_psInstance->pvCBData == this)
+        {
+            m_psInstance->pfnCallback = 0;
+            m_psInstance->pvCBData = 0;
+        }
+    }
+
+    Port(const Port &) = delete;
+    Port &operator=(const Port &) = delete;
+
+    //
+    //! Queues a buffer to send, see USBHostSerialScheduleWrite().  The data is
+    //! not copied and must stay valid until OnSent() reports it.
+    //
+    uint32_t Write(span<const uint8_t> sData) noexcept
+    {
+        return(USBHostSerialScheduleWrite(
+                   m_psInstance, const_cast<uint8_t *>(sData.data()),
+                   static_cast<uint32_t>(sData.size())));
+    }
+
+    uint32_t SetLineConfig(const LineConfig &sConfig) noexcept
+    {
+        return(USBHostSerialSetLineConfig(m_psInstance, sConfig.Baud(),
+                                          sConfig.Coding()));
+    }
+
+    LineConfig GetLineConfig() const noexcept
+    {
+        return(LineConfig(USBHostSerialGetBaud(m_psInstance),
+                          USBHostSerialGetCoding(m_psInstance)));
+    }
+
+    //
+    //! Returns the rate the device produces for a requested one, see
+    //! USBHostSerialGetBaudActual().
+    //
+    uint32_t GetBaudActual(uint32_t ui32Baud, int32_t *pi32Error = 0) const
+        noexcept
+    {
+        return(USBHostSerialGetBaudActual(m_psInstance, ui32Baud, pi32Error));
+    }
+
+    uint32_t SetControl(Control eControl) noexcept
+    {
+        return(USBHostSerialSetControlLineState(
+                   m_psInstance, static_cast<uint32_t>(eControl)));
+    }
+
+    Control GetControl() const noexcept
+    {
+        return(static_cast<Control>(
+                   USBHostSerialGetControlLineState(m_psInstance)));
+    }
+
+    uint32_t SetFlow(uint32_t ui32Flow) noexcept
+    {
+        return(USBHostSerialSetFlow(m_psInstance, ui32Flow));
+    }
+
+    uint32_t Break(bool bOn) noexcept
+    {
+        return(bOn ? USBHostSerialBreakSet(m_psInstance) :
+                     USBHostSerialBreakClear(m_psInstance));
+    }
+
+    uint32_t Purge(bool bRx, bool bTx) noexcept
+    {
+        return(USBHostSerialPurge(m_psInstance, bRx, bTx));
+    }
+
+    tSerialInstance *Instance() const noexcept
+    {
+        return(m_psInstance);
+    }
+
+private:
+    static uint32_t Callback(void *pvCBData, uint32_t ui32Event,
+                             uint32_t ui32MsgParam, void *pvMsgData)
+    {
+        Port *psPort;
+
+        psPort = static_cast<Port *>(
+                     static_cast<tSerialInstance *>(pvCBData)->pvCBData);
+
+        switch(ui32Event)
+        {
+            case USB_EVENT_RX_AVAILABLE:
+            {
+                psPort->m_psHandler->OnReceive(*psPort,
+                    span<const uint8_t>(static_cast<uint8_t *>(pvMsgData),
+                                        ui32MsgParam));
+                break;
+            }
+            case USB_EVENT_TX_COMPLETE:
+            {
+                psPort->m_psHandler->OnSent(*psPort,
+                    span<const uint8_t>(static_cast<uint8_t *>(pvMsgData),
+                                        ui32MsgParam));
+                break;
+            }
+            default:
+            {
+                psPort->m_psHandler->OnEvent(*psPort, ui32Event,
+                                             ui32MsgParam);
+                break;
+            }
+        }
+
+        return(0);
+    }
+
+    tSerialInstance *m_psInstance;
+    Handler *m_psHandler;
+};
+
+} // namespace usbhs
+
+//*****************************************************************************
+//
+//! Defines the driver table of the application from the drivers given, at
+//! compile time and without the g_psDrivers and g_ui8NumDrivers definitions
+//! written out by hand.  Use it once, at namespace scope:
+//!
+//! \verbatim
+//! USBHS_DRIVERS(usbhs::CdcDriver, usbhs::Cp210xDriver);
+//! \endverbatim
+//!
+//! When the library is built with USBHS_STATIC_DRIVERS it uses its own table
+//! and the list is only checked.
+//
+//*****************************************************************************
+#ifdef USBHS_STATIC_DRIVERS
+#define USBHS_DRIVERS(...)                                                   \
+    static_assert((usbhs::DriverCount(__VA_ARGS__) >= 1) &&                  \
+                  (usbhs::DriverCount(__VA_ARGS__) <= 255),                  \
+                  "USBHS_DRIVERS takes 1 to 255 drivers")
+#else
+#define USBHS_DRIVERS(...)                                                   \
+    extern "C"                                                               \
+    {                                                                        \
+    tUSBSerialDriver g_psDrivers[] = { __VA_ARGS__ };                        \
+    uint8_t g_ui8NumDrivers = usbhs::DriverCount(__VA_ARGS__);               \
+    }                                                                        \
+    static_assert((usbhs::DriverCount(__VA_ARGS__) >= 1) &&                  \
+                  (usbhs::DriverCount(__VA_ARGS__) <= 255),                  \
+                  "USBHS_DRIVERS takes 1 to 255 drivers")
+#endif
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
+
+#endif /* USBHSERIAL_HPP_ */
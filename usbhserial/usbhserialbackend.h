@@ -0,0 +1,166 @@
+//*****************************************************************************
+//
+// usbhserialbackend.h - Host controller backends of the serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#ifndef USBHSERIALBACKEND_H_
+#define USBHSERIALBACKEND_H_
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+//! \addtogroup usblib_host_class
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+//! Host controller operations used by the library.  By default the library
+//! calls usblib directly.  When it is built with USBHS_BACKEND_TABLE defined,
+//! every operation goes through the backend registered with
+//! USBHostSerialSetBackend(), so the drivers and the data path also run on a
+//! workstation: the usblib backend is built with USBHS_BACKEND_USBLIB, the
+//! Linux usbfs backend on Linux and the simulated backend everywhere.
+//!
+//! The operations follow the usblib functions of the same name.  Pipe types
+//! are the \b USBHCD_PIPE_ values and pipes are non-zero handles.  The
+//! backend calls the pipe callback from a single context with
+//! \b USB_EVENT_RX_AVAILABLE when an IN transfer completed,
+//! \b USB_EVENT_TX_COMPLETE when an OUT transfer completed,
+//! \b USB_EVENT_SCHEDULER for an idle IN pipe once per polling interval,
+//! and \b USB_EVENT_STALL or \b USB_EVENT_ERROR when a transfer failed.  A
+//! device is announced with USBHostSerialBackendConnect() and removed with
+//! USBHostSerialBackendDisconnect().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Called once by USBHostSerialInit().
+    //
+    void (* pfnInit)(void);
+
+    //
+    //! Allocates a pipe of a type for a device, returns 0 if there is none.
+    //
+    uint32_t (* pfnPipeAlloc)(uint32_t ui32Type, tUSBHostDevice *psDevice,
+                              uint32_t ui32Size,
+                              tHCDPipeCallback pfnCallback);
+
+    //
+    //! Sets the maximum packet size, polling interval in frames and endpoint
+    //! number of a pipe.
+    //
+    void (* pfnPipeConfig)(uint32_t ui32Pipe, uint32_t ui32MaxPacket,
+                           uint32_t ui32Interval, uint32_t ui32Endpoint);
+
+    //
+    //! Frees a pipe.  A transfer in progress is dropped.
+    //
+    void (* pfnPipeFree)(uint32_t ui32Pipe);
+
+    //
+    //! Starts a transfer.  For an IN pipe pui8Data is 0 unless the data is to
+    //! be received straight into it, as with USBHS_DMA.
+    //
+    void (* pfnPipeSchedule)(uint32_t ui32Pipe, uint8_t *pui8Data,
+                             uint32_t ui32Size);
+
+    //
+    //! Returns the size of the packet received on an IN pipe and copies it.
+    //
+    uint32_t (* pfnPipeSizeGet)(uint32_t ui32Pipe);
+    void (* pfnPipeRead)(uint32_t ui32Pipe, uint8_t *pui8Data,
+                         uint32_t ui32Size);
+
+    //
+    //! Returns the size of a transfer received into the buffer given to
+    //! pfnPipeSchedule.
+    //
+    uint32_t (* pfnPipeTransferSizeGet)(uint32_t ui32Pipe);
+
+    //
+    //! Performs a control transfer on endpoint 0, returns the number of bytes
+    //! of the data stage.
+    //
+    uint32_t (* pfnControlTransfer)(tUSBHostDevice *psDevice,
+                                    tUSBRequest *psSetupPacket,
+                                    uint8_t *pui8Data, uint32_t ui32Size);
+
+    //
+    //! Clears a feature of the endpoint of a pipe, which resets its toggle.
+    //
+    void (* pfnClearFeature)(tUSBHostDevice *psDevice, uint32_t ui32Pipe,
+                             uint32_t ui32Feature);
+
+    //
+    //! Returns the current frame number.
+    //
+    uint32_t (* pfnFrameGet)(void);
+} tUSBHSBackend;
+
+//*****************************************************************************
+//
+//! Backends provided with the library.
+//
+//*****************************************************************************
+extern const tUSBHSBackend g_sUSBHSBackendUsblib;
+extern const tUSBHSBackend g_sUSBHSBackendLinux;
+extern const tUSBHSBackend g_sUSBHSBackendSim;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void USBHostSerialSetBackend(const tUSBHSBackend *psBackend);
+extern void *USBHostSerialBackendConnect(tUSBHostDevice *psDevice);
+extern void USBHostSerialBackendDisconnect(void *pvInstance);
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USBHSERIALBACKEND_H_ */
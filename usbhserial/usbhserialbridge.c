@@ -0,0 +1,317 @@
+//*****************************************************************************
+//
+// usbhserialbridge.c - Forwarding of the data received by one serial device
+//                      to another.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialpriv.h"
+
+#if USBHS_BRIDGE_BUFFERS
+
+//*****************************************************************************
+//
+// A bridge owns a ring of packet buffers.  The bulk IN pipe of the source is
+// armed only while a buffer is free, the packet is received straight into
+// that buffer and the buffer is queued on the sink with
+// USBHostSerialScheduleWrite().  The buffers complete on the sink in the
+// order they were queued, so a buffer is free again when the sink reports it
+// sent.  All of this runs in the USB interrupt.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Queues the filled buffers on the sink until its queue is full.
+//
+//*****************************************************************************
+static void
+BridgeFlush(tUSBHSBridge *psBridge)
+{
+    uint32_t ui32Idx;
+
+    while(psBridge->ui32Sent != psBridge->ui32Filled)
+    {
+        ui32Idx = psBridge->ui32Sent % USBHS_BRIDGE_BUFFERS;
+
+        if(USBHostSerialScheduleWrite(psBridge->psSink,
+                                      psBridge->pui8Data[ui32Idx],
+                                      psBridge->pui16Size[ui32Idx]) != 0)
+        {
+            return;
+        }
+
+        psBridge->ui32Sent++;
+    }
+}
+
+//*****************************************************************************
+//
+// Detaches a removed bridge from its source once all its buffers were sent.
+//
+//*****************************************************************************
+static void
+BridgeRelease(tSerialInstance *psSource)
+{
+    tUSBHSBridge *psBridge;
+
+    psBridge = psSource->psBridge;
+
+    if(!psBridge->bActive && !psBridge->bArmed &&
+       (psBridge->ui32Done == psBridge->ui32Filled))
+    {
+        psSource->psBridge = 0;
+    }
+}
+
+//*****************************************************************************
+//
+// Called for a USB_EVENT_SCHEDULER poll of the bulk IN pipe of an instance.
+// Reserves a buffer of an active bridge and returns false if there is none,
+// in which case the pipe is not armed.
+//
+//*****************************************************************************
+bool
+USBHSBridgeArm(tSerialInstance *psInstance)
+{
+    tUSBHSBridge *psBridge;
+
+    psBridge = psInstance->psBridge;
+    if(psBridge == 0)
+    {
+        return(true);
+    }
+
+    psBridge->bArmed = false;
+
+    if(!psBridge->bActive)
+    {
+        BridgeRelease(psInstance);
+        return(true);
+    }
+
+    if((psBridge->ui32Filled - psBridge->ui32Done) >= USBHS_BRIDGE_BUFFERS)
+    {
+        psBridge->ui32Held++;
+        return(false);
+    }
+
+    psBridge->bArmed = true;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Called when the bulk IN pipe of an instance completed.  Returns true if
+// the packet was received into a bridge buffer and has been forwarded.
+//
+//*****************************************************************************
+bool
+USBHSBridgeReceived(tSerialInstance *psInstance, uint32_t ui32Size)
+{
+    tUSBHSBridge *psBridge;
+
+    if((psInstance == 0) || (psInstance->psBridge == 0) ||
+       !psInstance->psBridge->bArmed)
+    {
+        return(false);
+    }
+
+    psBridge = psInstance->psBridge;
+    psBridge->bArmed = false;
+
+    if(ui32Size != 0)
+    {
+        psBridge->pui16Size[psBridge->ui32Filled % USBHS_BRIDGE_BUFFERS] =
+            ui32Size;
+        psBridge->ui32Filled++;
+        psBridge->ui32Packets++;
+        psBridge->ui32Bytes += ui32Size;
+
+        BridgeFlush(psBridge);
+    }
+
+    BridgeRelease(psInstance);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Called when an instance has sent a buffer.  Frees the buffer if it belongs
+// to a bridge into this instance and queues waiting bridge buffers.
+// Returns true if the buffer belonged to a bridge.
+//
+//*****************************************************************************
+bool
+USBHSBridgeTxDone(tSerialInstance *psInstance, uint8_t *pui8Data)
+{
+    tUSBHSBridge *psBridge;
+    uint32_t ui32Idx;
+    bool bBridge;
+
+    bBridge = false;
+
+    for(ui32Idx = 0; ui32Idx < g_ui8NumInstances; ui32Idx++)
+    {
+        psBridge = g_psInstances[ui32Idx].psBridge;
+        if((psBridge == 0) || (psBridge->psSink != psInstance))
+        {
+            continue;
+        }
+
+        if(!bBridge && (psBridge->ui32Done != psBridge->ui32Sent) &&
+           (pui8Data == psBridge->pui8Data[psBridge->ui32Done %
+                                           USBHS_BRIDGE_BUFFERS]))
+        {
+            psBridge->ui32Done++;
+            bBridge = true;
+        }
+
+        BridgeFlush(psBridge);
+        BridgeRelease(g_psInstances + ui32Idx);
+    }
+
+    return(bBridge);
+}
+
+//*****************************************************************************
+//
+// Called when a device disconnects.  Bridges into it are dropped together
+// with its transmit queue, its own bridge stops forwarding and is released
+// once the other device has sent what was received.
+//
+//*****************************************************************************
+void
+USBHSBridgeClose(tSerialInstance *psInstance)
+{
+    tUSBHSBridge *psBridge;
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < g_ui8NumInstances; ui32Idx++)
+    {
+        psBridge = g_psInstances[ui32Idx].psBridge;
+        if(psBridge && (psBridge->psSink == psInstance))
+        {
+            psBridge->bActive = false;
+            psBridge->bArmed = false;
+            g_psInstances[ui32Idx].psBridge = 0;
+        }
+    }
+
+    psBridge = psInstance->psBridge;
+    if(psBridge)
+    {
+        psBridge->bActive = false;
+        psBridge->bArmed = false;
+        BridgeRelease(psInstance);
+    }
+}
+
+//*****************************************************************************
+//
+//! Forwards everything received by one instance to another.
+//!
+//! \param psSource is the instance whose received data is forwarded.
+//! \param psSink is the instance the data is sent to.
+//! \param psBridge is the bridge memory, provided by the application.
+//!
+//! Packets received by \e psSource are read straight into the buffers of the
+//! bridge and queued on \e psSink without copying and without involving the
+//! application; \e psSource no longer receives \b USB_EVENT_RX_AVAILABLE and
+//! \e psSink does not receive \b USB_EVENT_TX_COMPLETE for them.  When all
+//! USBHS_BRIDGE_BUFFERS buffers wait to be sent the bulk IN pipe of
+//! \e psSource is not armed, so the device buffers the data and its own flow
+//! control holds the sender back.  The application may still send its own
+//! data to \e psSink.  For both directions set up a second bridge with the
+//! instances swapped.
+//!
+//! A bridge into a device that disconnects is removed.
+//!
+//! \return Returns 0 if the bridge was set up or non-zero if \e psSource
+//! already forwards to a bridge.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialBridge(tSerialInstance *psSource, tSerialInstance *psSink,
+                    tUSBHSBridge *psBridge)
+{
+    if((psSource == psSink) || (psSource->psBridge != 0))
+    {
+        return(1);
+    }
+
+    psBridge->ui32Packets = 0;
+    psBridge->ui32Bytes = 0;
+    psBridge->ui32Held = 0;
+    psBridge->psSink = psSink;
+    psBridge->ui32Filled = 0;
+    psBridge->ui32Sent = 0;
+    psBridge->ui32Done = 0;
+    psBridge->bArmed = false;
+    psBridge->bActive = true;
+
+    //
+    // Make the bridge visible to the interrupt only once it is complete.
+    //
+    USBHSMemoryBarrier();
+    psSource->psBridge = psBridge;
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+//! Stops forwarding the data received by an instance.
+//!
+//! \param psSource is the instance passed to USBHostSerialBridge().
+//!
+//! Data received from now on is passed to the application again.  Packets
+//! already received are still sent to the other device, and the bridge
+//! memory is in use until that is done.  Call the function again until it
+//! returns true before the memory is reused.
+//!
+//! \return Returns true if the bridge memory is no longer used.
+//
+//*****************************************************************************
+bool
+USBHostSerialUnbridge(tSerialInstance *psSource)
+{
+    tUSBHSBridge *psBridge;
+
+    psBridge = psSource->psBridge;
+    if(psBridge == 0)
+    {
+        return(true);
+    }
+
+    psBridge->bActive = false;
+
+    return(false);
+}
+
+#endif
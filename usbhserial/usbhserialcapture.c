@@ -0,0 +1,707 @@
+//*****************************************************************************
+//
+// usbhserialcapture.c - Traffic capture and replay for the serial host
+//                       library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialdriver.h"
+#include "usbhserialcapture.h"
+#include "usbhserialpriv.h"
+
+#ifdef USBHS_CAPTURE
+
+//*****************************************************************************
+//
+// The capture log.  Records are appended with a compare-and-swap on the
+// write offset so the interrupt handler and tasks can record concurrently.
+// The type byte of a record is written last; a zero type marks a record that
+// was still being filled when the capture stopped.
+//
+//*****************************************************************************
+static uint8_t *g_pui8CaptureBuffer;
+static uint32_t g_ui32CaptureSize;
+static volatile uint32_t g_ui32CaptureOffset;
+static volatile uint32_t g_ui32CaptureDropped;
+static uint32_t g_ui32CaptureEvents;
+static volatile bool g_bCapture = false;
+
+//*****************************************************************************
+//
+// Replay state read by the pipe access helpers in usbhserial.c.
+//
+//*****************************************************************************
+volatile bool g_bUSBHSReplay = false;
+const uint8_t *g_pui8USBHSReplayData;
+uint32_t g_ui32USBHSReplaySize;
+
+//*****************************************************************************
+//
+// Pipe handles given to instances created by a replay.  They never reach
+// usblib.
+//
+//*****************************************************************************
+#define REPLAY_PIPE(ui32Idx, ui32Pipe)                                       \
+                                (0xFF000000 | ((ui32Idx) << 2) | (ui32Pipe))
+
+//*****************************************************************************
+//
+// Size of a record including its padded payload.
+//
+//*****************************************************************************
+#define RECORD_SIZE(ui32Payload)                                             \
+                                (sizeof(tUSBHSCaptureRecord) +               \
+                                 (((ui32Payload) + 3) & ~3))
+
+//*****************************************************************************
+//
+// Layout of the usbmon binary header used by the pcap export
+// (LINKTYPE_USB_LINUX).
+//
+//*****************************************************************************
+#define PCAP_LINKTYPE_USB_LINUX 189
+#define USBMON_HDR_SIZE         48
+#define USBMON_XFER_INTR        1
+#define USBMON_XFER_CONTROL     2
+#define USBMON_XFER_BULK        3
+
+//*****************************************************************************
+//
+// Adds a record to the capture log.
+//
+// \param ui32Type is the record type.
+// \param psInstance is the instance the record belongs to.
+// \param ui32Param is the type specific parameter.  For pipe and control
+// records the endpoint and device address are filled in here.
+// \param pvData, ui32Size, pvData2 and ui32Size2 describe up to two pieces
+// of payload which are stored back to back.
+//
+// Connect records get the driver index and the endpoint addresses of the
+// instance as their payload so a replay can rebuild the instance.
+//
+//*****************************************************************************
+void
+USBHSCaptureRecord(uint32_t ui32Type, tSerialInstance *psInstance,
+                   uint32_t ui32Param, const void *pvData, uint32_t ui32Size,
+                   const void *pvData2, uint32_t ui32Size2)
+{
+    tUSBHSCaptureRecord *psRecord;
+    uint32_t ui32Offset, ui32Len, ui32Dropped;
+    uint8_t pui8Connect[4];
+    uint8_t ui8Endpoint;
+
+    if(!g_bCapture || ((g_ui32CaptureEvents & USBHS_CAP_MASK(ui32Type)) == 0))
+    {
+        return;
+    }
+
+    if(pvData == 0)
+    {
+        ui32Size = 0;
+    }
+    if(pvData2 == 0)
+    {
+        ui32Size2 = 0;
+    }
+
+    if((ui32Type == USBHS_CAP_CONNECT) && psInstance)
+    {
+        pui8Connect[0] = psInstance->ui8Driver;
+        pui8Connect[1] = psInstance->ui8BulkInEndpoint;
+        pui8Connect[2] = psInstance->ui8BulkOutEndpoint;
+#if USBHS_INT_IN_PIPE
+        pui8Connect[3] = psInstance->ui8IntInEndpoint;
+#else
+        pui8Connect[3] = 0;
+#endif
+        pvData = pui8Connect;
+        ui32Size = sizeof(pui8Connect);
+    }
+
+    //
+    // The payload size field is 16 bits wide.
+    //
+    if(ui32Size > 0xFFFF)
+    {
+        ui32Size = 0xFFFF;
+    }
+    if(ui32Size + ui32Size2 > 0xFFFF)
+    {
+        ui32Size2 = 0xFFFF - ui32Size;
+    }
+
+    //
+    // Reserve space in the log.
+    //
+    ui32Len = RECORD_SIZE(ui32Size + ui32Size2);
+    do
+    {
+        ui32Offset = g_ui32CaptureOffset;
+        if(ui32Offset + ui32Len > g_ui32CaptureSize)
+        {
+            do
+            {
+                ui32Dropped = g_ui32CaptureDropped;
+            }
+            while(!USBHSAtomicCAS(&g_ui32CaptureDropped, ui32Dropped,
+                                  ui32Dropped + 1));
+            return;
+        }
+    }
+    while(!USBHSAtomicCAS(&g_ui32CaptureOffset, ui32Offset,
+                          ui32Offset + ui32Len));
+
+    psRecord = (tUSBHSCaptureRecord *)(g_pui8CaptureBuffer + ui32Offset);
+
+    //
+    // Label pipe and control traffic with the endpoint and device address.
+    //
+    switch(ui32Type)
+    {
+        case USBHS_CAP_RX:
+        case USBHS_CAP_SCHEDULER:
+        case USBHS_CAP_TX:
+        case USBHS_CAP_TX_COMPLETE:
+        case USBHS_CAP_INT_RX:
+        case USBHS_CAP_CONTROL:
+        {
+            ui8Endpoint = 0;
+            if(psInstance)
+            {
+                if((ui32Type == USBHS_CAP_RX) ||
+                   (ui32Type == USBHS_CAP_SCHEDULER))
+                {
+                    ui8Endpoint = psInstance->ui8BulkInEndpoint;
+                }
+                else if((ui32Type == USBHS_CAP_TX) ||
+                        (ui32Type == USBHS_CAP_TX_COMPLETE))
+                {
+                    ui8Endpoint = psInstance->ui8BulkOutEndpoint;
+                }
+#if USBHS_INT_IN_PIPE
+                else if(ui32Type == USBHS_CAP_INT_RX)
+                {
+                    ui8Endpoint = psInstance->ui8IntInEndpoint;
+                }
+#endif
+            }
+            ui32Param = ui8Endpoint;
+            if(psInstance && psInstance->psDevice)
+            {
+                ui32Param |= (psInstance->psDevice->ui32Address & 0xFF) << 8;
+            }
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+
+    psRecord->ui8Instance = psInstance ? (uint8_t)(psInstance - g_psInstances) :
+                                         0xFF;
+    psRecord->ui16Size = (uint16_t)(ui32Size + ui32Size2);
+    psRecord->ui32Time = USBHSClockGet();
+    psRecord->ui32Param = ui32Param;
+    if(ui32Size)
+    {
+        memcpy(psRecord + 1, pvData, ui32Size);
+    }
+    if(ui32Size2)
+    {
+        memcpy((uint8_t *)(psRecord + 1) + ui32Size, pvData2, ui32Size2);
+    }
+
+    //
+    // Publish the record.
+    //
+    USBHSMemoryBarrier();
+    psRecord->ui8Type = (uint8_t)ui32Type;
+}
+
+//*****************************************************************************
+//
+// Records a driver operation requested through the public API.
+//
+//*****************************************************************************
+void
+USBHSCaptureOp(tSerialInstance *psInstance, uint32_t ui32Op,
+               uint32_t ui32Arg0, uint32_t ui32Arg1)
+{
+    uint32_t pui32Args[2];
+
+    pui32Args[0] = ui32Arg0;
+    pui32Args[1] = ui32Arg1;
+
+    USBHSCaptureRecord(USBHS_CAP_OP, psInstance, ui32Op, pui32Args,
+                       sizeof(pui32Args), 0, 0);
+}
+
+//*****************************************************************************
+//
+//! Starts recording library traffic.
+//!
+//! \param pui8Buffer is the log buffer, which must be word aligned.
+//! \param ui32Size is the size of the log buffer in bytes.
+//! \param ui32Events selects the recorded record types, either
+//! \b USBHS_CAP_ALL or a combination of USBHS_CAP_MASK() values.
+//!
+//! Every pipe event, payload and control transfer seen by the library as well
+//! as the driver operations requested by the application are appended to the
+//! buffer until it is full.  Records that do not fit are counted by
+//! USBHostSerialCaptureDropped().  Timestamps are taken from the clock
+//! registered with USBHostSerialSetClock().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialCaptureStart(uint8_t *pui8Buffer, uint32_t ui32Size,
+                          uint32_t ui32Events)
+{
+    g_bCapture = false;
+
+    memset(pui8Buffer, 0, ui32Size);
+    g_pui8CaptureBuffer = pui8Buffer;
+    g_ui32CaptureSize = ui32Size;
+    g_ui32CaptureOffset = 0;
+    g_ui32CaptureDropped = 0;
+    g_ui32CaptureEvents = ui32Events;
+
+    USBHSMemoryBarrier();
+    g_bCapture = true;
+}
+
+//*****************************************************************************
+//
+//! Stops recording library traffic.
+//!
+//! \return Returns the number of bytes of the log buffer in use.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialCaptureStop(void)
+{
+    g_bCapture = false;
+
+    return(g_ui32CaptureOffset);
+}
+
+//*****************************************************************************
+//
+//! Returns the number of records that did not fit in the log buffer.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialCaptureDropped(void)
+{
+    return(g_ui32CaptureDropped);
+}
+
+//*****************************************************************************
+//
+// Stores a little endian value in an export buffer.
+//
+//*****************************************************************************
+static void
+CapturePut16(uint8_t *pui8Buffer, uint32_t ui32Value)
+{
+    pui8Buffer[0] = (uint8_t)ui32Value;
+    pui8Buffer[1] = (uint8_t)(ui32Value >> 8);
+}
+
+static void
+CapturePut32(uint8_t *pui8Buffer, uint32_t ui32Value)
+{
+    CapturePut16(pui8Buffer, ui32Value);
+    CapturePut16(pui8Buffer + 2, ui32Value >> 16);
+}
+
+//*****************************************************************************
+//
+//! Converts a capture log to pcap format.
+//!
+//! \param pui8Log is the log recorded by USBHostSerialCaptureStart().
+//! \param ui32Size is the size returned by USBHostSerialCaptureStop().
+//! \param ui32TicksPerSecond is the rate of the clock used for the capture,
+//! or 0 if the clock counts microseconds.
+//! \param pfnWrite is called with consecutive pieces of the pcap file.
+//! \param pvWriteData is passed to \e pfnWrite.
+//!
+//! Pipe and control records are written as Linux usbmon packets
+//! (LINKTYPE_USB_LINUX) so the file can be opened with Wireshark or
+//! tcpdump.  Connect, disconnect and driver operation records have no usbmon
+//! equivalent and are skipped.
+//!
+//! \return Returns the number of packets written.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialCaptureExportPcap(const uint8_t *pui8Log, uint32_t ui32Size,
+                               uint32_t ui32TicksPerSecond,
+                               tUSBHSCaptureWrite pfnWrite, void *pvWriteData)
+{
+    const tUSBHSCaptureRecord *psRecord;
+    const uint8_t *pui8Payload;
+    uint8_t pui8Header[16 + USBMON_HDR_SIZE];
+    uint32_t ui32Offset, ui32Packets, ui32Data, ui32Sec, ui32USec;
+    uint8_t ui8Event, ui8Xfer, ui8Endpoint;
+    bool bSetup;
+
+    //
+    // pcap global header.
+    //
+    CapturePut32(pui8Header, 0xA1B2C3D4);
+    CapturePut16(pui8Header + 4, 2);
+    CapturePut16(pui8Header + 6, 4);
+    CapturePut32(pui8Header + 8, 0);
+    CapturePut32(pui8Header + 12, 0);
+    CapturePut32(pui8Header + 16, 0xFFFF);
+    CapturePut32(pui8Header + 20, PCAP_LINKTYPE_USB_LINUX);
+    pfnWrite(pvWriteData, pui8Header, 24);
+
+    ui32Packets = 0;
+
+    for(ui32Offset = 0;
+        ui32Offset + sizeof(tUSBHSCaptureRecord) <= ui32Size;
+        ui32Offset += RECORD_SIZE(psRecord->ui16Size))
+    {
+        psRecord = (const tUSBHSCaptureRecord *)(pui8Log + ui32Offset);
+        pui8Payload = (const uint8_t *)(psRecord + 1);
+        ui32Data = psRecord->ui16Size;
+        ui8Endpoint = (uint8_t)psRecord->ui32Param;
+        bSetup = false;
+
+        if(psRecord->ui8Type == 0)
+        {
+            break;
+        }
+
+        switch(psRecord->ui8Type)
+        {
+            case USBHS_CAP_RX:
+            {
+                ui8Event = 'C';
+                ui8Xfer = USBMON_XFER_BULK;
+                break;
+            }
+            case USBHS_CAP_TX:
+            case USBHS_CAP_SCHEDULER:
+            {
+                ui8Event = 'S';
+                ui8Xfer = USBMON_XFER_BULK;
+                break;
+            }
+            case USBHS_CAP_TX_COMPLETE:
+            {
+                ui8Event = 'C';
+                ui8Xfer = USBMON_XFER_BULK;
+                break;
+            }
+            case USBHS_CAP_INT_RX:
+            {
+                ui8Event = 'C';
+                ui8Xfer = USBMON_XFER_INTR;
+                break;
+            }
+            case USBHS_CAP_CONTROL:
+            {
+                ui8Event = 'S';
+                ui8Xfer = USBMON_XFER_CONTROL;
+                bSetup = true;
+                ui8Endpoint = pui8Payload[0] & USB_RTYPE_DIR_IN;
+                pui8Payload += sizeof(tUSBRequest);
+                ui32Data -= sizeof(tUSBRequest);
+                break;
+            }
+            default:
+            {
+                continue;
+            }
+        }
+
+        //
+        // Convert the timestamp.
+        //
+        if(ui32TicksPerSecond)
+        {
+            ui32Sec = psRecord->ui32Time / ui32TicksPerSecond;
+            ui32USec = (uint32_t)(((uint64_t)(psRecord->ui32Time %
+                                              ui32TicksPerSecond) *
+                                   1000000) / ui32TicksPerSecond);
+        }
+        else
+        {
+            ui32Sec = psRecord->ui32Time / 1000000;
+            ui32USec = psRecord->ui32Time % 1000000;
+        }
+
+        //
+        // pcap record header.
+        //
+        CapturePut32(pui8Header, ui32Sec);
+        CapturePut32(pui8Header + 4, ui32USec);
+        CapturePut32(pui8Header + 8, USBMON_HDR_SIZE + ui32Data);
+        CapturePut32(pui8Header + 12, USBMON_HDR_SIZE + ui32Data);
+
+        //
+        // usbmon header.
+        //
+        memset(pui8Header + 16, 0, USBMON_HDR_SIZE);
+        CapturePut32(pui8Header + 16, ui32Packets);
+        pui8Header[16 + 8] = ui8Event;
+        pui8Header[16 + 9] = ui8Xfer;
+        pui8Header[16 + 10] = ui8Endpoint;
+        pui8Header[16 + 11] = (uint8_t)(psRecord->ui32Param >> 8);
+        CapturePut16(pui8Header + 16 + 12, 1);
+        pui8Header[16 + 14] = bSetup ? 0 : '-';
+        pui8Header[16 + 15] = ui32Data ? 0 : '<';
+        CapturePut32(pui8Header + 16 + 16, ui32Sec);
+        CapturePut32(pui8Header + 16 + 24, ui32USec);
+        CapturePut32(pui8Header + 16 + 28,
+                     (ui8Event == 'S') ? (uint32_t)-115 : 0);
+        CapturePut32(pui8Header + 16 + 32, ui32Data);
+        CapturePut32(pui8Header + 16 + 36, ui32Data);
+        if(bSetup)
+        {
+            memcpy(pui8Header + 16 + 40, pui8Payload - sizeof(tUSBRequest),
+                   sizeof(tUSBRequest));
+        }
+
+        pfnWrite(pvWriteData, pui8Header, sizeof(pui8Header));
+        if(ui32Data)
+        {
+            pfnWrite(pvWriteData, pui8Payload, ui32Data);
+        }
+
+        ui32Packets++;
+    }
+
+    return(ui32Packets);
+}
+
+//*****************************************************************************
+//
+//! Replays a capture log through the library.
+//!
+//! \param pui8Log is the log recorded by USBHostSerialCaptureStart().
+//! \param ui32Size is the size returned by USBHostSerialCaptureStop().
+//! \param ui32Speed is the replay speed.  0 replays the log back to back, 1
+//! keeps the original timing and larger values accelerate it by that factor.
+//! \param pfnDelay is called to wait between records, it may be 0 when
+//! \e ui32Speed is 0.
+//!
+//! Connect records recreate the instance and report \b USB_EVENT_CONNECTED to
+//! the global callback, bulk and interrupt IN records are fed to the pipe
+//! callbacks as received data, transmit completions and scheduler ticks are
+//! delivered as they were seen and driver operations are issued through the
+//! public API.  No pipe or control request reaches usblib while the replay
+//! runs, so the replay also works in a host build without a USB controller.
+//!
+//! \return Returns the number of records replayed.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialReplay(const uint8_t *pui8Log, uint32_t ui32Size,
+                    uint32_t ui32Speed, tUSBHSReplayDelay pfnDelay)
+{
+    const tUSBHSCaptureRecord *psRecord;
+    const uint8_t *pui8Payload;
+    const uint32_t *pui32Args;
+    tSerialInstance *psInstance;
+    uint32_t ui32Offset, ui32Records, ui32Last, ui32Idx;
+
+    ui32Records = 0;
+    ui32Last = 0;
+    g_bUSBHSReplay = true;
+
+    for(ui32Offset = 0;
+        ui32Offset + sizeof(tUSBHSCaptureRecord) <= ui32Size;
+        ui32Offset += RECORD_SIZE(psRecord->ui16Size))
+    {
+        psRecord = (const tUSBHSCaptureRecord *)(pui8Log + ui32Offset);
+        pui8Payload = (const uint8_t *)(psRecord + 1);
+        pui32Args = (const uint32_t *)pui8Payload;
+        ui32Idx = psRecord->ui8Instance;
+
+        if(psRecord->ui8Type == 0)
+        {
+            break;
+        }
+
+        //
+        // Reproduce the spacing between records.
+        //
+        if(ui32Speed && pfnDelay && ui32Records)
+        {
+            pfnDelay((psRecord->ui32Time - ui32Last) / ui32Speed);
+        }
+        ui32Last = psRecord->ui32Time;
+        ui32Records++;
+
+        if(ui32Idx >= USBHS_MAX_INSTANCES)
+        {
+            continue;
+        }
+        psInstance = g_psInstances + ui32Idx;
+
+        switch(psRecord->ui8Type)
+        {
+            case USBHS_CAP_CONNECT:
+            {
+                USBHSerialInstanceReset(psInstance);
+                psInstance->psDevice = 0;
+                psInstance->ui8Driver = pui8Payload[0];
+                psInstance->ui8BulkInEndpoint = pui8Payload[1];
+                psInstance->ui8BulkOutEndpoint = pui8Payload[2];
+                psInstance->ui32BulkInPipe = REPLAY_PIPE(ui32Idx, 0);
+                psInstance->ui32BulkOutPipe = REPLAY_PIPE(ui32Idx, 1);
+#if USBHS_INT_IN_PIPE
+                psInstance->ui8IntInEndpoint = pui8Payload[3];
+                psInstance->ui32IntInPipe = REPLAY_PIPE(ui32Idx, 2);
+#endif
+                psInstance->bConnected = true;
+
+                if(g_ui8NumInstances <= ui32Idx)
+                {
+                    g_ui8NumInstances = ui32Idx + 1;
+                }
+
+                if(g_pfnGlobalAppCB != 0)
+                {
+                    g_pfnGlobalAppCB(psInstance, USB_EVENT_CONNECTED, 0, 0);
+                }
+                break;
+            }
+            case USBHS_CAP_DISCONNECT:
+            {
+                psInstance->bConnected = false;
+                if(psInstance->pfnCallback != 0)
+                {
+                    psInstance->pfnCallback(psInstance, USB_EVENT_DISCONNECTED,
+                                            0, 0);
+                }
+                break;
+            }
+            case USBHS_CAP_RX:
+            case USBHS_CAP_INT_RX:
+            {
+                g_pui8USBHSReplayData = pui8Payload;
+                g_ui32USBHSReplaySize = psRecord->ui16Size;
+
+                if(psRecord->ui8Type == USBHS_CAP_RX)
+                {
+                    USBHSerialCallback(psInstance->ui32BulkInPipe,
+                                       USB_EVENT_RX_AVAILABLE);
+                }
+#if USBHS_INT_IN_PIPE
+                else
+                {
+                    USBHSerialIntINCallback(psInstance->ui32IntInPipe,
+                                            USB_EVENT_RX_AVAILABLE);
+                }
+#endif
+                break;
+            }
+            case USBHS_CAP_TX_COMPLETE:
+            {
+                USBHSerialCallback(psInstance->ui32BulkOutPipe,
+                                   USB_EVENT_TX_COMPLETE);
+                break;
+            }
+            case USBHS_CAP_SCHEDULER:
+            {
+                USBHSerialCallback(psInstance->ui32BulkInPipe,
+                                   USB_EVENT_SCHEDULER);
+                break;
+            }
+            case USBHS_CAP_OP:
+            {
+                switch(psRecord->ui32Param)
+                {
+                    case USBHS_CAP_OP_INIT:
+                    {
+                        USBHostSerialInitNewDevice(psInstance);
+                        break;
+                    }
+                    case USBHS_CAP_OP_SET_LINE_CONFIG:
+                    {
+                        USBHostSerialSetLineConfig(psInstance, pui32Args[0],
+                                                   pui32Args[1]);
+                        break;
+                    }
+                    case USBHS_CAP_OP_SET_CONTROL:
+                    {
+                        USBHostSerialSetControlLineState(psInstance,
+                                                         pui32Args[0]);
+                        break;
+                    }
+                    case USBHS_CAP_OP_SET_FLOW:
+                    {
+                        USBHostSerialSetFlow(psInstance, pui32Args[0]);
+                        break;
+                    }
+                    case USBHS_CAP_OP_BREAK_SET:
+                    {
+                        USBHostSerialBreakSet(psInstance);
+                        break;
+                    }
+                    case USBHS_CAP_OP_BREAK_CLEAR:
+                    {
+                        USBHostSerialBreakClear(psInstance);
+                        break;
+                    }
+                    case USBHS_CAP_OP_PURGE:
+                    {
+                        USBHostSerialPurge(psInstance, pui32Args[0] != 0,
+                                           pui32Args[1] != 0);
+                        break;
+                    }
+                    default:
+                    {
+                        break;
+                    }
+                }
+                break;
+            }
+            default:
+            {
+                //
+                // Transmitted packets and control transfers are produced by
+                // the library itself while the replay runs.
+                //
+                break;
+            }
+        }
+    }
+
+    g_bUSBHSReplay = false;
+
+    return(ui32Records);
+}
+
+#endif
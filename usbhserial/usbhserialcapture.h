@@ -0,0 +1,170 @@
+//*****************************************************************************
+//
+// usbhserialcapture.h - Traffic capture and replay for the serial host
+//                       library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#ifndef USBHSERIALCAPTURE_H_
+#define USBHSERIALCAPTURE_H_
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+//! \addtogroup usblib_host_class
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+//! Header of every record in a capture log.  The header is followed by
+//! \e ui16Size bytes of payload, padded to a multiple of four bytes.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Record type, one of the \b USBHS_CAP_ values.
+    //
+    uint8_t ui8Type;
+
+    //
+    //! Index of the serial instance the record belongs to.
+    //
+    uint8_t ui8Instance;
+
+    //
+    //! Size of the payload following the header.
+    //
+    uint16_t ui16Size;
+
+    //
+    //! Application clock ticks when the record was taken.
+    //
+    uint32_t ui32Time;
+
+    //
+    //! Type specific parameter.  For pipe records this holds the endpoint
+    //! address in bits 0-7 and the device address in bits 8-15.
+    //
+    uint32_t ui32Param;
+} tUSBHSCaptureRecord;
+
+//*****************************************************************************
+//
+//! Record types.
+//
+//*****************************************************************************
+#define USBHS_CAP_CONNECT       1   // Param is VID | (PID << 16)
+#define USBHS_CAP_DISCONNECT    2
+#define USBHS_CAP_RX            3   // Payload is bulk IN data
+#define USBHS_CAP_TX            4   // Payload is bulk OUT data
+#define USBHS_CAP_TX_COMPLETE   5
+#define USBHS_CAP_SCHEDULER     6
+#define USBHS_CAP_INT_RX        7   // Payload is interrupt IN data
+#define USBHS_CAP_CONTROL       8   // Payload is setup packet + data stage
+#define USBHS_CAP_OP            9   // Param is USBHS_CAP_OP_*, payload args
+
+//*****************************************************************************
+//
+//! Driver operations recorded with \b USBHS_CAP_OP.
+//
+//*****************************************************************************
+#define USBHS_CAP_OP_INIT               0
+#define USBHS_CAP_OP_SET_LINE_CONFIG    1
+#define USBHS_CAP_OP_SET_CONTROL        2
+#define USBHS_CAP_OP_SET_FLOW           3
+#define USBHS_CAP_OP_BREAK_SET          4
+#define USBHS_CAP_OP_BREAK_CLEAR        5
+#define USBHS_CAP_OP_PURGE              6
+
+//*****************************************************************************
+//
+//! Masks for the \e ui32Events parameter of USBHostSerialCaptureStart().
+//
+//*****************************************************************************
+#define USBHS_CAP_MASK(ui32Type)        (1 << (ui32Type))
+#define USBHS_CAP_ALL                   0xFFFFFFFF
+
+//*****************************************************************************
+//
+//! Prototype of the output function used by
+//! USBHostSerialCaptureExportPcap().
+//
+//*****************************************************************************
+typedef void (* tUSBHSCaptureWrite)(void *pvWriteData,
+                                    const uint8_t *pui8Data,
+                                    uint32_t ui32Size);
+
+//*****************************************************************************
+//
+//! Prototype of the delay function used by USBHostSerialReplay().  The
+//! delay is given in application clock ticks.
+//
+//*****************************************************************************
+typedef void (* tUSBHSReplayDelay)(uint32_t ui32Ticks);
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void USBHostSerialCaptureStart(uint8_t *pui8Buffer, uint32_t ui32Size,
+                                      uint32_t ui32Events);
+extern uint32_t USBHostSerialCaptureStop(void);
+extern uint32_t USBHostSerialCaptureDropped(void);
+extern uint32_t USBHostSerialCaptureExportPcap(const uint8_t *pui8Log,
+                                               uint32_t ui32Size,
+                                               uint32_t ui32TicksPerSecond,
+                                               tUSBHSCaptureWrite pfnWrite,
+                                               void *pvWriteData);
+extern uint32_t USBHostSerialReplay(const uint8_t *pui8Log, uint32_t ui32Size,
+                                    uint32_t ui32Speed,
+                                    tUSBHSReplayDelay pfnDelay);
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USBHSERIALCAPTURE_H_ */
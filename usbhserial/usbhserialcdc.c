@@ -34,6 +34,7 @@
 #include "usblib/host/usbhostpriv.h"
 #include "usbhserial.h"
 #include "usbhserialdriver.h"
+#include "usbhserialpriv.h"
 #include "usbhserialcdc.h"
 
 #define USBREQ_GET_LINE_CODING  0x21
@@ -76,9 +77,8 @@ uint32_t USBHSerialCDCGetBaudCoding(tSerialInstance *psSerialInstance, uint8_t *
     //
     // Put the setup packet in the buffer.
     //
-    ui32Bytes = (USBHCDControlTransfer(0, &sSetupPacket,
-                                       psSerialInstance->psDevice,
-                                       pui8Buffer, 0x07, MAX_PACKET_SIZE_EP0));
+    ui32Bytes = (USBHSControlTransfer(psSerialInstance, &sSetupPacket,
+                                      pui8Buffer, 0x07));
 
     return ui32Bytes;
 }
@@ -119,8 +119,7 @@ uint32_t USBHSerialCDCSetBaud(tSerialInstance *psSerialInstance, uint32_t ui32Ba
     // This request includes an OUT transaction and an IN transaction.
     // The OUT transaction is the line coding structure of length 7 bytes.
     //
-    USBHCDControlTransfer(0, &sSetupPacket, psSerialInstance->psDevice,
-                          pui8Buffer, 0x07, MAX_PACKET_SIZE_EP0);
+    USBHSControlTransfer(psSerialInstance, &sSetupPacket, pui8Buffer, 0x07);
 
     return (0);
 
@@ -173,8 +172,7 @@ uint32_t USBHSerialCDCSetCoding(tSerialInstance *psSerialInstance, uint32_t ui32
     // This request includes an OUT transaction and an IN transaction.
     // The OUT transaction is the line coding structure of length 7 bytes.
     //
-    USBHCDControlTransfer(0, &sSetupPacket, psSerialInstance->psDevice,
-                          pui8Buffer, 0x07, MAX_PACKET_SIZE_EP0);
+    USBHSControlTransfer(psSerialInstance, &sSetupPacket, pui8Buffer, 0x07);
 
     return (0);
 }
@@ -193,7 +191,6 @@ uint32_t USBHSerialCDCGetCoding(tSerialInstance *psSerialInstance)
 
 uint32_t USBHSerialCDCSetControlLineState(tSerialInstance *psSerialInstance, uint32_t ui32Control)
 {
-    // TODO: full control
     tUSBRequest sSetupPacket;
 
     //
@@ -206,13 +203,14 @@ uint32_t USBHSerialCDCSetControlLineState(tSerialInstance *psSerialInstance, uin
     // Request a Device Descriptor.
     //
     sSetupPacket.bRequest = USBREQ_SET_CONTROL_LINE_STATE;
-    if(ui32Control & USBHS_CONTROL_RTS)
+    sSetupPacket.wValue = 0x00;
+    if(ui32Control & USBHS_CONTROL_DTR)
     {
-        sSetupPacket.wValue = 0x03; // Activate carrier, DTE present.
+        sSetupPacket.wValue |= 0x01; // DTE present.
     }
-    else
+    if(ui32Control & USBHS_CONTROL_RTS)
     {
-        sSetupPacket.wValue = 0x00; // Deactivate carrier, DTE not present.
+        sSetupPacket.wValue |= 0x02; // Activate carrier.
     }
 
     //
@@ -230,8 +228,7 @@ uint32_t USBHSerialCDCSetControlLineState(tSerialInstance *psSerialInstance, uin
     // This request includes an OUT transaction and an IN transaction.
     // The OUT transaction is the line coding structure of length 7 bytes.
     //
-    USBHCDControlTransfer(0, &sSetupPacket, psSerialInstance->psDevice,
-                                 0, 0, MAX_PACKET_SIZE_EP0);
+    USBHSControlTransfer(psSerialInstance, &sSetupPacket, 0, 0);
 
     return (0);
 
@@ -262,3 +259,70 @@ uint32_t USBHSerialCDCBreakClear(tSerialInstance *psSerialInstance)
     return 0;
 }
 
+uint32_t USBHSerialCDCSetLineConfig(tSerialInstance *psSerialInstance, uint32_t ui32Baud, uint32_t ui32Coding)
+{
+    uint8_t pui8Buffer[7];
+    tUSBRequest sSetupPacket;
+
+    //
+    // Both halves of the line coding are known, so it is written with a
+    // single request and no read back.
+    //
+    pui8Buffer[0] = (uint8_t)ui32Baud;
+    pui8Buffer[1] = (uint8_t)(ui32Baud >> 8);
+    pui8Buffer[2] = (uint8_t)(ui32Baud >> 16);
+    pui8Buffer[3] = (uint8_t)(ui32Baud >> 24);
+    pui8Buffer[4] = (ui32Coding & USBHS_CONF_STOP_M);
+    pui8Buffer[5] = ((ui32Coding & USBHS_CONF_PAR_M) >> 4);
+    pui8Buffer[6] = ((ui32Coding & USBHS_CONF_DATA_M) >> 8);
+
+    sSetupPacket.bmRequestType = USB_RTYPE_DIR_OUT | USB_RTYPE_CLASS |
+                                 USB_RTYPE_INTERFACE;
+    sSetupPacket.bRequest = USBREQ_SET_LINE_CODING;
+    sSetupPacket.wValue = 0;
+    sSetupPacket.wIndex = 0;
+    sSetupPacket.wLength = 0x07;
+
+    USBHSControlTransfer(psSerialInstance, &sSetupPacket, pui8Buffer, 0x07);
+
+    return (0);
+}
+
+uint32_t USBHSerialCDCGetRxQueue(tSerialInstance *psSerialInstance)
+{
+    //
+    // The CDC class has no request for the amount of buffered data.
+    //
+    return (USBHS_QUEUE_UNKNOWN);
+}
+
+uint32_t USBHSerialCDCGetTxQueue(tSerialInstance *psSerialInstance)
+{
+    //
+    // The CDC class has no request for the amount of data still to be sent.
+    //
+    return (USBHS_QUEUE_UNKNOWN);
+}
+
+uint32_t USBHSerialCDCPurge(tSerialInstance *psSerialInstance, bool bRx, bool bTx)
+{
+    //
+    // The CDC class has no request to discard buffered data.
+    //
+    return (1);
+}
+
+uint32_t USBHSerialCDCGetBaudActual(tSerialInstance *psSerialInstance, uint32_t ui32Baud, tUSBHSBaudRange *psRange)
+{
+    //
+    // The CDC class does not tell which rates the device produces.
+    //
+    if(psRange)
+    {
+        psRange->ui32Min = 1;
+        psRange->ui32Max = 0xFFFFFFFF;
+        psRange->ui32Flags = 0;
+    }
+
+    return (ui32Baud);
+}
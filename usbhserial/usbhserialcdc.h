@@ -43,13 +43,21 @@ extern "C"
 //
 //*****************************************************************************
 
-#define DECLARE_USB_SERIAL_CDC_DRIVER                               \
-{                                                                   \
+//*****************************************************************************
+//
+//! Device matching fields of the CDC driver.
+//
+//*****************************************************************************
+#define USB_SERIAL_CDC_MATCH                                        \
     USB_CLASS_CDC,                                                  \
     0,                                                              \
     0,                                                              \
     false,                                                          \
-    0,                                                              \
+    0
+
+#define DECLARE_USB_SERIAL_CDC_DRIVER                               \
+{                                                                   \
+    USB_SERIAL_CDC_MATCH,                                           \
     USBHSerialCDCInit,                                              \
     USBHSerialCDCSetBaud,                                           \
     USBHSerialCDCGetBaud,                                           \
@@ -59,7 +67,12 @@ extern "C"
     USBHSerialCDCGetControlLineState,                               \
     USBHSerialCDCSetFlow,                                           \
     USBHSerialCDCBreakSet,                                          \
-    USBHSerialCDCBreakClear                                         \
+    USBHSerialCDCBreakClear,                                        \
+    USBHSerialCDCSetLineConfig,                                     \
+    USBHSerialCDCGetRxQueue,                                        \
+    USBHSerialCDCPurge,                                             \
+    USBHSerialCDCGetTxQueue,                                        \
+    USBHSerialCDCGetBaudActual                                      \
 }
 
 extern uint32_t USBHSerialCDCInit(tSerialInstance *psSerialInstance);
@@ -70,6 +83,11 @@ extern uint32_t USBHSerialCDCGetCoding(tSerialInstance *psSerialInstance);
 extern uint32_t USBHSerialCDCSetControlLineState(tSerialInstance *psSerialInstance, uint32_t ui32Control);
 extern uint32_t USBHSerialCDCGetControlLineState(tSerialInstance *psSerialInstance);
 extern uint32_t USBHSerialCDCSetFlow(tSerialInstance *psSerialInstance, uint32_t ui32Flow);
+extern uint32_t USBHSerialCDCSetLineConfig(tSerialInstance *psSerialInstance, uint32_t ui32Baud, uint32_t ui32Coding);
+extern uint32_t USBHSerialCDCGetRxQueue(tSerialInstance *psSerialInstance);
+extern uint32_t USBHSerialCDCPurge(tSerialInstance *psSerialInstance, bool bRx, bool bTx);
+extern uint32_t USBHSerialCDCGetTxQueue(tSerialInstance *psSerialInstance);
+extern uint32_t USBHSerialCDCGetBaudActual(tSerialInstance *psSerialInstance, uint32_t ui32Baud, tUSBHSBaudRange *psRange);
 extern uint32_t USBHSerialCDCBreakSet(tSerialInstance *psSerialInstance);
 extern uint32_t USBHSerialCDCBreakClear(tSerialInstance *psSerialInstance);
 
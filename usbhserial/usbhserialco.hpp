@@ -0,0 +1,756 @@
+//*****************************************************************************
+//
+// usbhserialco.hpp - C++20 coroutine interface to the serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#ifndef USBHSERIALCO_HPP_
+#define USBHSERIALCO_HPP_
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include "usbhserial.hpp"
+
+//*****************************************************************************
+//
+// Coroutines are resumed by the executor, in the thread that calls
+// USBHostSerialProcessEvents(), so the instance callbacks must run there as
+// well and not in the USB interrupt.
+//
+//*****************************************************************************
+#if !USBHS_EVENT_QUEUE_DEPTH
+#error "usbhserialco.hpp requires the library built with USBHS_EVENT_QUEUE_DEPTH"
+#endif
+
+//*****************************************************************************
+//
+//! Size and number of the coroutine frames of usbhs::co::Task.  A frame
+//! holds the local variables of a coroutine that live across an await; the
+//! compiler reports its size through a failed allocation, see
+//! usbhs::co::FramePool::Failed().
+//
+//*****************************************************************************
+#ifndef USBHS_CO_FRAME_SIZE
+#define USBHS_CO_FRAME_SIZE     256
+#endif
+
+#ifndef USBHS_CO_FRAMES
+#define USBHS_CO_FRAMES         16
+#endif
+
+//*****************************************************************************
+//
+//! \addtogroup usblib_host_class
+//! @{
+//
+//*****************************************************************************
+
+namespace usbhs::co
+{
+
+//*****************************************************************************
+//
+//! A pool of fixed size blocks for coroutine frames.  Blocks that were never
+//! used are taken in order and freed blocks are kept in a list, so the pool
+//! needs no constructor and is ready before any static initialization.  It
+//! is used from the executor thread only.
+//
+//*****************************************************************************
+template<std::size_t BlockSize, std::size_t Blocks>
+class FramePool
+{
+    static_assert((BlockSize % alignof(std::max_align_t)) == 0,
+                  "frame size must be a multiple of the maximum alignment");
+    static_assert(BlockSize >= sizeof(void *), "frame size too small");
+
+public:
+    void *Allocate(std::size_t uSize) noexcept
+    {
+        void *pvBlock;
+
+        if(uSize > BlockSize)
+        {
+            m_uFailed++;
+            return(nullptr);
+        }
+
+        if(m_pvFree != nullptr)
+        {
+            pvBlock = m_pvFree;
+            m_pvFree = *static_cast<void **>(pvBlock);
+        }
+        else if(m_uNext < Blocks)
+        {
+            pvBlock = m_ppui8Block[m_uNext++];
+        }
+        else
+        {
+            m_uFailed++;
+            return(nullptr);
+        }
+
+        if(++m_uUsed > m_uPeak)
+        {
+            m_uPeak = m_uUsed;
+        }
+
+        return(pvBlock);
+    }
+
+    void Free(void *pvBlock) noexcept
+    {
+        *static_cast<void **>(pvBlock) = m_pvFree;
+        m_pvFree = pvBlock;
+        m_uUsed--;
+    }
+
+    //
+    //! Frames in use, the most that were in use at the same time, and the
+    //! number of coroutines that could not be started.
+    //
+    std::size_t Used() const noexcept { return(m_uUsed); }
+    std::size_t Peak() const noexcept { return(m_uPeak); }
+    std::size_t Failed() const noexcept { return(m_uFailed); }
+
+private:
+    alignas(std::max_align_t) unsigned char m_ppui8Block[Blocks][BlockSize];
+    void *m_pvFree;
+    std::size_t m_uNext;
+    std::size_t m_uUsed;
+    std::size_t m_uPeak;
+    std::size_t m_uFailed;
+};
+
+//*****************************************************************************
+//
+//! The frames of all usbhs::co::Task coroutines.
+//
+//*****************************************************************************
+inline FramePool<USBHS_CO_FRAME_SIZE, USBHS_CO_FRAMES> g_sFramePool;
+
+//*****************************************************************************
+//
+//! A coroutine started with Executor::Spawn().  It runs detached and frees
+//! its frame when it returns.  If the frame pool is empty the task is empty
+//! and Spawn() fails.
+//
+//*****************************************************************************
+class Task
+{
+public:
+    struct promise_type
+    {
+        static void *operator new(std::size_t uSize) noexcept
+        {
+            return(g_sFramePool.Allocate(uSize));
+        }
+
+        static void operator delete(void *pvFrame) noexcept
+        {
+            g_sFramePool.Free(pvFrame);
+        }
+
+        static Task get_return_object_on_allocation_failure() noexcept
+        {
+            return(Task());
+        }
+
+        Task get_return_object() noexcept
+        {
+            return(Task(std::coroutine_handle<promise_type>::from_promise(
+                            *this)));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+    Task() noexcept : m_sHandle(nullptr) {}
+
+    Task(Task &&sOther) noexcept : m_sHandle(sOther.m_sHandle)
+    {
+        sOther.m_sHandle = nullptr;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    ~Task()
+    {
+        if(m_sHandle)
+        {
+            m_sHandle.destroy();
+        }
+    }
+
+    //
+    //! Hands the coroutine over to the caller.
+    //
+    std::coroutine_handle<> Release() noexcept
+    {
+        std::coroutine_handle<> sHandle;
+
+        sHandle = m_sHandle;
+        m_sHandle = nullptr;
+
+        return(sHandle);
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> sHandle) noexcept :
+        m_sHandle(sHandle) {}
+
+    std::coroutine_handle<promise_type> m_sHandle;
+};
+
+//*****************************************************************************
+//
+//! Runs coroutines that are ready.  Operations that complete resume their
+//! coroutine through the executor, never from the callback that completed
+//! them, so a coroutine always runs from Run().  Call it from the main loop
+//! after USBHostSerialProcessEvents().
+//!
+//! The ready queue holds USBHS_CO_FRAMES coroutines, the most that can
+//! exist, since a Task is queued at most once at a time.
+//
+//*****************************************************************************
+class Executor
+{
+public:
+    //
+    //! Starts a task.  Returns false if its frame could not be allocated.
+    //
+    bool Spawn(Task sTask) noexcept
+    {
+        std::coroutine_handle<> sHandle;
+
+        sHandle = sTask.Release();
+        if(!sHandle)
+        {
+            return(false);
+        }
+
+        Schedule(sHandle);
+
+        return(true);
+    }
+
+    void Schedule(std::coroutine_handle<> sHandle) noexcept
+    {
+        m_psReady[m_uTail % USBHS_CO_FRAMES] = sHandle;
+        m_uTail++;
+    }
+
+    //
+    //! Resumes the coroutines that were ready when it was called and those
+    //! they made ready.  Returns the number of coroutines resumed.
+    //
+    std::size_t Run() noexcept
+    {
+        std::size_t uCount;
+
+        uCount = 0;
+
+        while(m_uHead != m_uTail)
+        {
+            std::coroutine_handle<> sHandle;
+
+            sHandle = m_psReady[m_uHead % USBHS_CO_FRAMES];
+            m_uHead++;
+            sHandle.resume();
+            uCount++;
+        }
+
+        return(uCount);
+    }
+
+    bool Idle() const noexcept
+    {
+        return(m_uHead == m_uTail);
+    }
+
+private:
+    std::coroutine_handle<> m_psReady[USBHS_CO_FRAMES];
+    std::size_t m_uHead = 0;
+    std::size_t m_uTail = 0;
+};
+
+//*****************************************************************************
+//
+//! Event reported by Stream::WaitStatusChange().
+//
+//*****************************************************************************
+struct Status
+{
+    uint32_t ui32Event;
+    uint32_t ui32MsgParam;
+};
+
+//*****************************************************************************
+//
+//! A serial device seen as a byte stream with awaitable operations.  The
+//! stream is the handler of its port.  Received bytes go straight into the
+//! buffer of the reader waiting for them; bytes that arrive while no one
+//! reads are kept in a ring of RxSize bytes, and counted in Overruns() when
+//! it is full.  Writes are not copied.  After the device disconnected all
+//! waiting operations complete with what they have, and new ones complete
+//! at once.
+//
+//*****************************************************************************
+template<std::size_t RxSize>
+class Stream
+{
+public:
+    explicit Stream(Executor &sExecutor) noexcept :
+        m_psExecutor(&sExecutor) {}
+
+    Stream(const Stream &) = delete;
+    Stream &operator=(const Stream &) = delete;
+
+    //
+    //! Attaches the stream to a connected instance, with receive buffers as
+    //! for usbhs::Port.  Call it from the \b USB_EVENT_CONNECTED handler.
+    //
+    void Open(tSerialInstance *psInstance, span<uint8_t> sRx,
+              span<uint8_t> sRxAlt = span<uint8_t>()) noexcept
+    {
+        m_oPort.reset();
+        m_uRxHead = 0;
+        m_uRxTail = 0;
+        m_bClosed = false;
+        m_oPort.emplace(psInstance, *this, sRx, sRxAlt);
+    }
+
+    //
+    //! Detaches the stream from its instance.  Readers, waits for events and
+    //! writes not handed to the library yet complete at once.  Writes the
+    //! library holds are purged and complete with their transmit completion,
+    //! after which the stream lets go of the port and GetPort() returns
+    //! nullptr.  Call it from a coroutine or the main loop, not from a port
+    //! callback, as it sends the purge request.
+    //
+    void Close() noexcept
+    {
+        m_bClosed = true;
+        WakeIdle();
+
+        if(!m_oPort || (m_psWriters == nullptr))
+        {
+            m_oPort.reset();
+            return;
+        }
+
+        m_oPort->Purge(false, true);
+    }
+
+    bool Closed() const noexcept { return(m_bClosed); }
+    uint32_t Overruns() const noexcept { return(m_ui32Overruns); }
+    Port<Stream> *GetPort() noexcept
+    {
+        return(m_oPort ? &*m_oPort : nullptr);
+    }
+
+private:
+    //
+    // A read waiting for data.  Readers are served in the order they came.
+    //
+    struct ReadOp
+    {
+        Stream *psStream;
+        span<uint8_t> sDst;
+        std::size_t uCount;
+        int32_t i32Delim;
+        std::coroutine_handle<> sHandle;
+        ReadOp *psNext;
+
+        bool Done() const noexcept
+        {
+            return((uCount == sDst.size()) ||
+                   ((i32Delim >= 0) && (uCount != 0) &&
+                    (sDst[uCount - 1] == static_cast<uint8_t>(i32Delim))));
+        }
+
+        //
+        // Takes bytes until the read is done, returns the number taken.
+        //
+        std::size_t Feed(const uint8_t *pui8Data, std::size_t uSize) noexcept
+        {
+            std::size_t uTaken;
+
+            for(uTaken = 0; (uTaken < uSize) && !Done(); uTaken++)
+            {
+                sDst[uCount++] = pui8Data[uTaken];
+            }
+
+            return(uTaken);
+        }
+
+        bool await_ready() noexcept
+        {
+            return(psStream->ReadStart(this));
+        }
+
+        void await_suspend(std::coroutine_handle<> sCaller) noexcept
+        {
+            sHandle = sCaller;
+            psStream->Append(psStream->m_psReaders, this);
+        }
+
+        std::size_t await_resume() const noexcept { return(uCount); }
+    };
+
+    //
+    // A write waiting to be queued or sent.
+    //
+    struct WriteOp
+    {
+        Stream *psStream;
+        span<const uint8_t> sData;
+        std::size_t uSent;
+        bool bQueued;
+        std::coroutine_handle<> sHandle;
+        WriteOp *psNext;
+
+        bool await_ready() const noexcept
+        {
+            return(psStream->m_bClosed || sData.empty());
+        }
+
+        void await_suspend(std::coroutine_handle<> sCaller) noexcept
+        {
+            sHandle = sCaller;
+            psStream->Append(psStream->m_psWriters, this);
+            psStream->WriteQueue();
+        }
+
+        std::size_t await_resume() const noexcept { return(uSent); }
+    };
+
+    //
+    // A wait for an event other than data.
+    //
+    struct StatusOp
+    {
+        Stream *psStream;
+        Status sStatus;
+        std::coroutine_handle<> sHandle;
+        StatusOp *psNext;
+
+        bool await_ready() noexcept
+        {
+            if(psStream->m_bClosed)
+            {
+                sStatus.ui32Event = USB_EVENT_DISCONNECTED;
+                return(true);
+            }
+
+            return(false);
+        }
+
+        void await_suspend(std::coroutine_handle<> sCaller) noexcept
+        {
+            sHandle = sCaller;
+            psStream->Append(psStream->m_psStatus, this);
+        }
+
+        Status await_resume() const noexcept { return(sStatus); }
+    };
+
+public:
+    //
+    //! Reads exactly sDst.size() bytes.  Returns the number of bytes read,
+    //! which is less only if the device disconnected.
+    //
+    ReadOp Read(span<uint8_t> sDst) noexcept
+    {
+        return(ReadOp{this, sDst, 0, -1, nullptr, nullptr});
+    }
+
+    //
+    //! Reads up to and including ui8Delim, or until sDst is full.  Returns
+    //! the number of bytes read.
+    //
+    ReadOp ReadUntil(span<uint8_t> sDst, uint8_t ui8Delim) noexcept
+    {
+        return(ReadOp{this, sDst, 0, ui8Delim, nullptr, nullptr});
+    }
+
+    //
+    //! Sends a buffer and waits until it was sent.  The data must stay
+    //! valid until then.  Returns the number of bytes sent, which is less
+    //! after USBHostSerialPurge() and 0 if the device disconnected.
+    //
+    WriteOp Write(span<const uint8_t> sData) noexcept
+    {
+        return(WriteOp{this, sData, 0, false, nullptr, nullptr});
+    }
+
+    //
+    //! Waits for the next event that is not data: a notification on the
+    //! interrupt IN pipe, pipe recovery or the disconnection of the device.
+    //
+    StatusOp WaitStatusChange() noexcept
+    {
+        return(StatusOp{this, {0, 0}, nullptr, nullptr});
+    }
+
+    //
+    // Port handler interface.
+    //
+    void OnReceive(Port<Stream> &, span<const uint8_t> sData) noexcept
+    {
+        const uint8_t *pui8Data;
+        std::size_t uSize, uTaken;
+
+        pui8Data = sData.data();
+        uSize = sData.size();
+
+        //
+        // Serve the waiting readers first, straight from the packet.
+        //
+        while((uSize != 0) && (m_psReaders != nullptr))
+        {
+            uTaken = m_psReaders->Feed(pui8Data, uSize);
+            pui8Data += uTaken;
+            uSize -= uTaken;
+
+            if(m_psReaders->Done())
+            {
+                Wake(m_psReaders);
+            }
+        }
+
+        for(; uSize != 0; uSize--, pui8Data++)
+        {
+            if((m_uRxTail - m_uRxHead) == RxSize)
+            {
+                m_ui32Overruns += uSize;
+                break;
+            }
+
+            m_pui8Rx[m_uRxTail++ % RxSize] = *pui8Data;
+        }
+    }
+
+    void OnSent(Port<Stream> &, span<const uint8_t> sData) noexcept
+    {
+        WriteOp **ppsOp;
+
+        //
+        // Buffers complete in the order they were queued.
+        //
+        for(ppsOp = &m_psWriters; *ppsOp != nullptr;
+            ppsOp = &(*ppsOp)->psNext)
+        {
+            if((*ppsOp)->bQueued &&
+               ((*ppsOp)->sData.data() == sData.data()))
+            {
+                (*ppsOp)->uSent = sData.size();
+                Wake(*ppsOp);
+                break;
+            }
+        }
+
+        //
+        // A closing stream lets go of the port once the library gave back
+        // the last buffer.  Port::Callback() does not use the port after
+        // this returns.
+        //
+        if(m_bClosed)
+        {
+            if(m_psWriters == nullptr)
+            {
+                m_oPort.reset();
+            }
+            return;
+        }
+
+        WriteQueue();
+    }
+
+    void OnEvent(Port<Stream> &, uint32_t ui32Event,
+                 uint32_t ui32MsgParam) noexcept
+    {
+        while(m_psStatus != nullptr)
+        {
+            m_psStatus->sStatus.ui32Event = ui32Event;
+            m_psStatus->sStatus.ui32MsgParam = ui32MsgParam;
+            Wake(m_psStatus);
+        }
+
+        if(ui32Event == USB_EVENT_DISCONNECTED)
+        {
+            //
+            // A stream that was closing needs the port no longer.
+            //
+            bool bClosing = m_bClosed;
+
+            WakeAll();
+            if(bClosing)
+            {
+                m_oPort.reset();
+            }
+        }
+    }
+
+private:
+    template<typename Op>
+    static void Append(Op *&psList, Op *psOp) noexcept
+    {
+        Op **ppsEnd;
+
+        for(ppsEnd = &psList; *ppsEnd != nullptr; ppsEnd = &(*ppsEnd)->psNext)
+        {
+        }
+
+        psOp->psNext = nullptr;
+        *ppsEnd = psOp;
+    }
+
+    //
+    // Removes an operation from the head of its list and resumes its
+    // coroutine from the executor.
+    //
+    template<typename Op>
+    void Wake(Op *&psLink) noexcept
+    {
+        Op *psOp;
+
+        psOp = psLink;
+        psLink = psOp->psNext;
+        m_psExecutor->Schedule(psOp->sHandle);
+    }
+
+    //
+    // Starts a read from the ring.  Returns true if it needs not wait.
+    //
+    bool ReadStart(ReadOp *psOp) noexcept
+    {
+        if(m_psReaders != nullptr)
+        {
+            return(false);
+        }
+
+        while((m_uRxHead != m_uRxTail) && !psOp->Done())
+        {
+            psOp->sDst[psOp->uCount++] = m_pui8Rx[m_uRxHead++ % RxSize];
+        }
+
+        return(psOp->Done() || m_bClosed);
+    }
+
+    //
+    // Queues the writes that are waiting while the library accepts them.
+    //
+    void WriteQueue() noexcept
+    {
+        WriteOp *psOp;
+
+        for(psOp = m_psWriters; psOp != nullptr; psOp = psOp->psNext)
+        {
+            if(psOp->bQueued)
+            {
+                continue;
+            }
+
+            if(!m_oPort || (m_oPort->Write(psOp->sData) != 0))
+            {
+                break;
+            }
+
+            psOp->bQueued = true;
+        }
+    }
+
+    //
+    // Completes the operations that do not wait for the library: readers,
+    // waits for events and writes that were not queued.
+    //
+    void WakeIdle() noexcept
+    {
+        WriteOp **ppsOp;
+
+        while(m_psReaders != nullptr)
+        {
+            Wake(m_psReaders);
+        }
+
+        for(ppsOp = &m_psWriters; *ppsOp != nullptr; )
+        {
+            if((*ppsOp)->bQueued)
+            {
+                ppsOp = &(*ppsOp)->psNext;
+            }
+            else
+            {
+                Wake(*ppsOp);
+            }
+        }
+
+        while(m_psStatus != nullptr)
+        {
+            m_psStatus->sStatus.ui32Event = USB_EVENT_DISCONNECTED;
+            Wake(m_psStatus);
+        }
+    }
+
+    //
+    // Completes every operation once the device disconnected, which also
+    // ends the transfers of the queued writes.
+    //
+    void WakeAll() noexcept
+    {
+        m_bClosed = true;
+        WakeIdle();
+
+        while(m_psWriters != nullptr)
+        {
+            Wake(m_psWriters);
+        }
+    }
+
+    Executor *m_psExecutor;
+    std::optional<Port<Stream>> m_oPort;
+    ReadOp *m_psReaders = nullptr;
+    WriteOp *m_psWriters = nullptr;
+    StatusOp *m_psStatus = nullptr;
+    std::size_t m_uRxHead = 0;
+    std::size_t m_uRxTail = 0;
+    uint32_t m_ui32Overruns = 0;
+    bool m_bClosed = true;
+    uint8_t m_pui8Rx[RxSize];
+};
+
+} // namespace usbhs::co
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
+
+#endif /* USBHSERIALCO_HPP_ */
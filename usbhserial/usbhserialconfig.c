@@ -0,0 +1,292 @@
+//*****************************************************************************
+//
+// usbhserialconfig.c - Per-device configuration store used to restore the
+//                      line setup of a reconnected serial device.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialpriv.h"
+
+#if USBHS_CONFIG_STORE
+
+//*****************************************************************************
+//
+// Every device is identified by its VID, PID and a hash of its serial number
+// string.  Devices without a serial number share one entry per VID/PID.  When
+// the store is full the entry used longest ago is replaced.
+//
+//*****************************************************************************
+tUSBHSConfigEntry g_psUSBHSConfig[USBHS_CONFIG_STORE];
+uint32_t g_ui32USBHSConfigStamp;
+
+//*****************************************************************************
+//
+// Language used to read the serial number string.
+//
+//*****************************************************************************
+#define CONFIG_LANGID           0x0409
+
+//*****************************************************************************
+//
+// Reads the serial number string of a device and returns its FNV-1a hash, or
+// 0 if the device has no serial number.
+//
+//*****************************************************************************
+static uint32_t
+ConfigSerialHash(tSerialInstance *psInstance)
+{
+    tUSBRequest sSetupPacket;
+    uint8_t pui8Buffer[64];
+    uint32_t ui32Size, ui32Idx, ui32Hash;
+
+    if(psInstance->psDevice->sDeviceDescriptor.iSerialNumber == 0)
+    {
+        return(0);
+    }
+
+    sSetupPacket.bmRequestType = USB_RTYPE_DIR_IN | USB_RTYPE_STANDARD |
+                                 USB_RTYPE_DEVICE;
+    sSetupPacket.bRequest = USBREQ_GET_DESCRIPTOR;
+    sSetupPacket.wValue = (USB_DTYPE_STRING << 8) |
+                          psInstance->psDevice->sDeviceDescriptor.iSerialNumber;
+    sSetupPacket.wIndex = CONFIG_LANGID;
+    sSetupPacket.wLength = sizeof(pui8Buffer);
+
+    ui32Size = USBHSControlTransfer(psInstance, &sSetupPacket, pui8Buffer,
+                                    sizeof(pui8Buffer));
+    if((ui32Size < 2) || (pui8Buffer[1] != USB_DTYPE_STRING))
+    {
+        return(0);
+    }
+    if(ui32Size > pui8Buffer[0])
+    {
+        ui32Size = pui8Buffer[0];
+    }
+
+    ui32Hash = 2166136261;
+    for(ui32Idx = 2; ui32Idx < ui32Size; ui32Idx++)
+    {
+        ui32Hash = (ui32Hash ^ pui8Buffer[ui32Idx]) * 16777619;
+    }
+
+    return(ui32Hash);
+}
+
+//*****************************************************************************
+//
+// Finds the entry of the device connected to an instance.  If there is none
+// and bAllocate is true an entry is taken for it.
+//
+//*****************************************************************************
+static tUSBHSConfigEntry *
+ConfigFind(tSerialInstance *psInstance, bool bAllocate)
+{
+    tUSBHSConfigEntry *psEntry, *psOldest;
+    uint16_t ui16VID, ui16PID;
+    uint32_t ui32Idx;
+
+    //
+    // Replayed instances have no device.
+    //
+    if(psInstance->psDevice == 0)
+    {
+        return(0);
+    }
+
+    ui16VID = psInstance->psDevice->sDeviceDescriptor.idVendor;
+    ui16PID = psInstance->psDevice->sDeviceDescriptor.idProduct;
+    psOldest = g_psUSBHSConfig;
+
+    for(ui32Idx = 0; ui32Idx < USBHS_CONFIG_STORE; ui32Idx++)
+    {
+        psEntry = g_psUSBHSConfig + ui32Idx;
+
+        if(psEntry->ui32Valid && (psEntry->ui16VID == ui16VID) &&
+           (psEntry->ui16PID == ui16PID) &&
+           (psEntry->ui32SerialHash == psInstance->ui32SerialHash))
+        {
+            return(psEntry);
+        }
+
+        if((psOldest->ui32Valid != 0) &&
+           ((psEntry->ui32Valid == 0) ||
+            (psEntry->ui32Stamp < psOldest->ui32Stamp)))
+        {
+            psOldest = psEntry;
+        }
+    }
+
+    if(!bAllocate)
+    {
+        return(0);
+    }
+
+    psOldest->ui32SerialHash = psInstance->ui32SerialHash;
+    psOldest->ui16VID = ui16VID;
+    psOldest->ui16PID = ui16PID;
+    psOldest->ui32Valid = 0;
+
+    return(psOldest);
+}
+
+//*****************************************************************************
+//
+// Remembers a configuration item set by the application.
+//
+//*****************************************************************************
+void
+USBHSConfigSave(tSerialInstance *psInstance, uint32_t ui32Item,
+                uint32_t ui32Value0, uint32_t ui32Value1)
+{
+    tUSBHSConfigEntry *psEntry;
+
+    psEntry = ConfigFind(psInstance, true);
+    if(psEntry == 0)
+    {
+        return;
+    }
+
+    switch(ui32Item)
+    {
+        case USBHS_CFG_LINE:
+        {
+            psEntry->ui32Baud = ui32Value0;
+            psEntry->ui32Coding = ui32Value1;
+            break;
+        }
+        case USBHS_CFG_CONTROL:
+        {
+            psEntry->ui32Control = ui32Value0;
+            break;
+        }
+        case USBHS_CFG_FLOW:
+        {
+            psEntry->ui32Flow = ui32Value0;
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+
+    psEntry->ui32Valid |= ui32Item;
+    psEntry->ui32Stamp = ++g_ui32USBHSConfigStamp;
+}
+
+//*****************************************************************************
+//
+// Identifies a newly opened device and applies its stored configuration.
+// Only the items the application set before are sent, and the line coding
+// goes out through the driver's combined request, so a device is usually
+// ready after two to four control transfers.  With deferred setup the steps
+// are queued for USBHostSerialProcess() instead.  Returns true if a stored
+// configuration was found.
+//
+//*****************************************************************************
+bool
+USBHSConfigRestore(tSerialInstance *psInstance)
+{
+    tUSBHSConfigEntry *psEntry;
+#if USBHS_DEFERRED_INIT
+    tUSBHSLineSetup sSetup;
+#else
+    uint32_t ui32Valid;
+#endif
+
+    psInstance->ui32SerialHash = ConfigSerialHash(psInstance);
+
+    psEntry = ConfigFind(psInstance, false);
+    if(psEntry == 0)
+    {
+        return(false);
+    }
+
+#if USBHS_DEFERRED_INIT
+    sSetup.ui32Items = psEntry->ui32Valid;
+    sSetup.ui32Baud = psEntry->ui32Baud;
+    sSetup.ui32Coding = psEntry->ui32Coding;
+    sSetup.ui32Flow = psEntry->ui32Flow;
+    sSetup.ui32Control = psEntry->ui32Control;
+    USBHostSerialSetupDeferred(psInstance, &sSetup);
+#else
+
+    //
+    // Take a copy, the calls below update the entry.
+    //
+    ui32Valid = psEntry->ui32Valid;
+
+    if(ui32Valid & USBHS_CFG_INIT)
+    {
+        USBHostSerialInitNewDevice(psInstance);
+    }
+    if(ui32Valid & USBHS_CFG_LINE)
+    {
+        USBHostSerialSetLineConfig(psInstance, psEntry->ui32Baud,
+                                   psEntry->ui32Coding);
+    }
+    if(ui32Valid & USBHS_CFG_FLOW)
+    {
+        USBHostSerialSetFlow(psInstance, psEntry->ui32Flow);
+    }
+    if(ui32Valid & USBHS_CFG_CONTROL)
+    {
+        USBHostSerialSetControlLineState(psInstance, psEntry->ui32Control);
+    }
+#endif
+
+    return(true);
+}
+
+#endif
+
+//*****************************************************************************
+//
+//! Forgets the stored configuration of all devices.
+//!
+//! The library remembers the line configuration, flow control and control
+//! line state an application sets for each device, identified by VID, PID and
+//! serial number.  When the device is connected again the configuration is
+//! applied, or queued for USBHostSerialProcess() with deferred setup, before
+//! \b USB_EVENT_CONNECTED is sent with \e ui32MsgParam set to
+//! \b USBHS_CONNECTED_RESTORED.  The number of devices remembered is set with
+//! USBHS_CONFIG_STORE.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialConfigClear(void)
+{
+#if USBHS_CONFIG_STORE
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < USBHS_CONFIG_STORE; ui32Idx++)
+    {
+        g_psUSBHSConfig[ui32Idx].ui32Valid = 0;
+    }
+#endif
+}
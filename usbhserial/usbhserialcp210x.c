@@ -34,6 +34,7 @@
 #include "usblib/host/usbhostpriv.h"
 #include "usbhserial.h"
 #include "usbhserialdriver.h"
+#include "usbhserialpriv.h"
 #include "usbhserialcp210x.h"
 
 #define CPCDC_IFC_ENABLE    0x00
@@ -49,6 +50,101 @@
 #define CPCDC_GET_FLOW      0x14
 #define CPCDC_GET_COMM_STATUS   0x10
 #define CPCDC_PURGE         0x12
+#define CPCDC_VENDOR        0xFF
+
+//
+// Vendor specific request reading the part number.
+//
+#define CPCDC_GET_PARTNUM   0x370B
+
+//
+// Part numbers.
+//
+#define CP_PART_CP2101      0x01
+#define CP_PART_CP2102      0x02
+#define CP_PART_CP2103      0x03
+#define CP_PART_CP2104      0x04
+#define CP_PART_CP2105      0x05
+#define CP_PART_CP2108      0x08
+#define CP_PART_CP2102N_28  0x20
+#define CP_PART_CP2102N_24  0x21
+#define CP_PART_CP2102N_20  0x22
+
+//
+// Rates the older parts produce, from application note AN205.  A requested
+// rate up to ui32High gives ui32Rate.
+//
+typedef struct
+{
+    uint32_t ui32Rate;
+    uint32_t ui32High;
+} tCPBaudRate;
+
+static const tCPBaudRate g_psCPBaudTable[] =
+{
+    { 300, 300 }, { 600, 600 }, { 1200, 1200 }, { 1800, 1800 },
+    { 2400, 2400 }, { 4000, 4000 }, { 4800, 4803 }, { 7200, 7207 },
+    { 9600, 9612 }, { 14400, 14428 }, { 16000, 16062 }, { 19200, 19250 },
+    { 28800, 28912 }, { 38400, 38601 }, { 51200, 51558 }, { 56000, 56280 },
+    { 57600, 58053 }, { 64000, 64111 }, { 76800, 77608 },
+    { 115200, 117028 }, { 128000, 129347 }, { 153600, 156868 },
+    { 230400, 237832 }, { 250000, 254234 }, { 256000, 273066 },
+    { 460800, 491520 }, { 500000, 567138 }, { 576000, 670254 },
+    { 921600, 0xFFFFFFFF }
+};
+
+//
+// Line control parity codes from application note AN571, indexed by the
+// USBHS_CONF_PAR_ value shifted down.  The mapping is its own inverse.
+//
+static const uint8_t g_pui8CPParity[] =
+{
+    0,                                  // USBHS_CONF_PAR_NONE, none
+    2,                                  // USBHS_CONF_PAR_EVEN, even
+    1,                                  // USBHS_CONF_PAR_ODD, odd
+    3,                                  // USBHS_CONF_PAR_MARK, mark
+    4                                   // USBHS_CONF_PAR_SPACE, space
+};
+
+//*****************************************************************************
+//
+// Converts USBHS_CONF_ values to the SET_LINE_CTL request value and back.
+// The request holds the data bits in bits 15:8, the AN571 parity code in
+// bits 7:4 and the stop bits, 0 for 1, 1 for 1.5 and 2 for 2, in bits 3:0.
+// Parity values without a code are passed on for the device to reject.
+//
+//*****************************************************************************
+static uint16_t
+USBHSerialCPLineCtl(uint32_t ui32Coding)
+{
+    uint32_t ui32Parity;
+
+    ui32Parity = (ui32Coding & USBHS_CONF_PAR_M) >> 4;
+    if(ui32Parity < sizeof(g_pui8CPParity))
+    {
+        ui32Parity = g_pui8CPParity[ui32Parity];
+    }
+
+    return((uint16_t)((ui32Coding & USBHS_CONF_DATA_M) |
+                      (ui32Parity << 4) |
+                      (ui32Coding & USBHS_CONF_STOP_M)));
+}
+
+static uint32_t
+USBHSerialCPCoding(uint16_t ui16LineCtl)
+{
+    uint32_t ui32Parity;
+
+    ui32Parity = (ui16LineCtl >> 4) & 0x0F;
+    if(ui32Parity < sizeof(g_pui8CPParity))
+    {
+        ui32Parity = g_pui8CPParity[ui32Parity];
+    }
+
+    return(((uint32_t)(ui16LineCtl & 0xFF00) & USBHS_CONF_DATA_M) |
+           ((ui32Parity << 4) & USBHS_CONF_PAR_M) |
+           (ui16LineCtl & USBHS_CONF_STOP_M));
+}
 
 
 uint32_t USBHSerialCPInit(tSerialInstance *psSerialInstance)
@@ -76,12 +172,114 @@ uint32_t USBHSerialCPInit(tSerialInstance *psSerialInstance)
     //
     sSetupPacket.wLength = 0;
 
-    USBHCDControlTransfer(0, &sSetupPacket, psSerialInstance->psDevice,
-                                 0, 0, MAX_PACKET_SIZE_EP0);
+    USBHSControlTransfer(psSerialInstance, &sSetupPacket, 0, 0);
+
+    //
+    // Read the part number, which sets the baud rates the device supports.
+    //
+    sSetupPacket.bmRequestType = USB_RTYPE_DIR_IN | USB_RTYPE_VENDOR |
+                                 USB_RTYPE_INTERFACE;
+    sSetupPacket.bRequest = CPCDC_VENDOR;
+    sSetupPacket.wValue = CPCDC_GET_PARTNUM;
+    sSetupPacket.wIndex = 0;
+    sSetupPacket.wLength = 1;
+
+    if(USBHSControlTransfer(psSerialInstance, &sSetupPacket,
+                            &psSerialInstance->ui8Variant, 1) != 1)
+    {
+        psSerialInstance->ui8Variant = 0;
+    }
 
     return (0);
 }
 
+uint32_t USBHSerialCPGetBaudActual(tSerialInstance *psSerialInstance, uint32_t ui32Baud, tUSBHSBaudRange *psRange)
+{
+    uint32_t ui32Max, ui32Prescale, ui32Div, ui32Idx;
+    bool bComputed;
+
+    switch(psSerialInstance->ui8Variant)
+    {
+        case CP_PART_CP2101:
+        {
+            bComputed = false;
+            ui32Max = 921600;
+            break;
+        }
+        case CP_PART_CP2104:
+        case CP_PART_CP2105:
+        {
+            bComputed = true;
+            ui32Max = 2000000;
+            break;
+        }
+        case CP_PART_CP2108:
+        {
+            bComputed = false;
+            ui32Max = 2000000;
+            break;
+        }
+        case CP_PART_CP2102N_28:
+        case CP_PART_CP2102N_24:
+        case CP_PART_CP2102N_20:
+        {
+            bComputed = true;
+            ui32Max = 3000000;
+            break;
+        }
+        default:
+        {
+            bComputed = false;
+            ui32Max = 1000000;
+            break;
+        }
+    }
+
+    if(psRange)
+    {
+        psRange->ui32Min = 300;
+        psRange->ui32Max = ui32Max;
+        psRange->ui32Flags = bComputed ? USBHS_BAUD_COMPUTED : 0;
+    }
+
+    if(ui32Baud < 300)
+    {
+        ui32Baud = 300;
+    }
+    else if(ui32Baud > ui32Max)
+    {
+        ui32Baud = ui32Max;
+    }
+
+    if(bComputed)
+    {
+        //
+        // The newer parts divide a 48MHz clock, prescaled by 4 for the
+        // lowest rates, by any divider.
+        //
+        ui32Prescale = (ui32Baud <= 365) ? 4 : 1;
+        ui32Div = (48000000 + (ui32Prescale * ui32Baud)) /
+                  (2 * ui32Prescale * ui32Baud);
+
+        return (48000000 / (2 * ui32Prescale * ui32Div));
+    }
+
+    //
+    // The fixed rates of AN205 only cover the rates below 1000000 baud,
+    // higher rates are passed on as requested.
+    //
+    if(ui32Baud >= 1000000)
+    {
+        return (ui32Baud);
+    }
+
+    for(ui32Idx = 0; ui32Baud > g_psCPBaudTable[ui32Idx].ui32High; ui32Idx++)
+    {
+    }
+
+    return (g_psCPBaudTable[ui32Idx].ui32Rate);
+}
+
 uint32_t USBHSerialCPSetBaud(tSerialInstance *psSerialInstance, uint32_t ui32Baud)
 {
     tUSBRequest sSetupPacket;
@@ -113,8 +311,9 @@ uint32_t USBHSerialCPSetBaud(tSerialInstance *psSerialInstance, uint32_t ui32Bau
     // This request includes an OUT transaction and an IN transaction.
     // The OUT transaction is the line coding structure of length 7 bytes.
     //
-    USBHCDControlTransfer(0, &sSetupPacket, psSerialInstance->psDevice,
-                                 (uint8_t *)&ui32Baud, 0x04, MAX_PACKET_SIZE_EP0);
+    ui32Baud = USBHSerialCPGetBaudActual(psSerialInstance, ui32Baud, 0);
+    USBHSControlTransfer(psSerialInstance, &sSetupPacket,
+                         (uint8_t *)&ui32Baud, 0x04);
     return 0;
 }
 
@@ -130,9 +329,17 @@ uint32_t USBHSerialCPGetBaud(tSerialInstance *psSerialInstance)
     sSetupPacket.wIndex = 0;
     sSetupPacket.bRequest = CPCDC_GET_BAUDRATE;
     sSetupPacket.wLength = 4;
-    ui32Bytes = (USBHCDControlTransfer(0, &sSetupPacket,
-                                       psSerialInstance->psDevice,
-                                       (uint8_t *)&ui32Baud, 0x04, MAX_PACKET_SIZE_EP0));
+    ui32Bytes = (USBHSControlTransfer(psSerialInstance, &sSetupPacket,
+                                      (uint8_t *)&ui32Baud, 0x04));
+
+    //
+    // A failed or short reply leaves the rate unknown.
+    //
+    if(ui32Bytes != 4)
+    {
+        return(0);
+    }
+
     return ui32Baud;
 }
 
@@ -161,10 +368,9 @@ uint32_t USBHSerialCPSetCoding(tSerialInstance *psSerialInstance, uint32_t ui32C
     // This is always 7 for this request.
     //
     sSetupPacket.bRequest = CPCDC_SET_LINE_CTL;
-    sSetupPacket.wValue = 0x0800 + (uint16_t)(ui32Coding & (USBHS_CONF_STOP_M + USBHS_CONF_PAR_M + USBHS_CONF_DATA_M));
+    sSetupPacket.wValue = USBHSerialCPLineCtl(ui32Coding);
     sSetupPacket.wLength = 0;
-    USBHCDControlTransfer(0, &sSetupPacket, psSerialInstance->psDevice,
-                                 0, 0, MAX_PACKET_SIZE_EP0);
+    USBHSControlTransfer(psSerialInstance, &sSetupPacket, 0, 0);
 
     return (0);
 
@@ -183,18 +389,47 @@ uint32_t USBHSerialCPGetCoding(tSerialInstance *psSerialInstance)
     sSetupPacket.wIndex = 0;
     sSetupPacket.bRequest = CPCDC_GET_LINE_CTL;
     sSetupPacket.wLength = 2;
-    ui32Bytes = (USBHCDControlTransfer(0, &sSetupPacket,
-                                       psSerialInstance->psDevice,
-                                       (uint8_t *)&ui16Coding, 0x02, MAX_PACKET_SIZE_EP0));
+    ui32Bytes = (USBHSControlTransfer(psSerialInstance, &sSetupPacket,
+                                      (uint8_t *)&ui16Coding, 0x02));
+
+    //
+    // A failed or short reply leaves the coding unknown.
+    //
+    if(ui32Bytes != 2)
+    {
+        return(0);
+    }
 
-    return (uint32_t)ui16Coding;
+    return(USBHSerialCPCoding(ui16Coding));
 
 }
 
 uint32_t USBHSerialCPSetControlLineState(tSerialInstance *psSerialInstance, uint32_t ui32Control)
 {
-    // TODO:
-    return 0;
+    tUSBRequest sSetupPacket;
+
+    sSetupPacket.bmRequestType = USB_RTYPE_DIR_OUT | USB_RTYPE_VENDOR |
+                                 USB_RTYPE_INTERFACE;
+    sSetupPacket.bRequest = CPCDC_SET_MHS;
+
+    //
+    // DTR is bit 0 and RTS bit 1, the upper byte selects the lines to change.
+    //
+    sSetupPacket.wValue = 0x0300;
+    if(ui32Control & USBHS_CONTROL_DTR)
+    {
+        sSetupPacket.wValue |= 0x01;
+    }
+    if(ui32Control & USBHS_CONTROL_RTS)
+    {
+        sSetupPacket.wValue |= 0x02;
+    }
+    sSetupPacket.wIndex = 0;
+    sSetupPacket.wLength = 0;
+
+    USBHSControlTransfer(psSerialInstance, &sSetupPacket, 0, 0);
+
+    return (0);
 }
 
 uint32_t USBHSerialCPGetControlLineState(tSerialInstance *psSerialInstance)
@@ -216,8 +451,7 @@ uint32_t USBHSerialCPSetFlow(tSerialInstance *psSerialInstance, uint32_t ui32Flo
     memset(pui8Bytes, 0, 0x10);
     pui8Bytes[0] = (uint8_t)(ui32Flow & 0xFF);
 
-    USBHCDControlTransfer(0, &sSetupPacket, psSerialInstance->psDevice,
-                                 pui8Bytes, 0x10, MAX_PACKET_SIZE_EP0);
+    USBHSControlTransfer(psSerialInstance, &sSetupPacket, pui8Bytes, 0x10);
 
     return 0;
 
@@ -235,5 +469,72 @@ uint32_t USBHSerialCPBreakClear(tSerialInstance *psSerialInstance)
     return 0;
 }
 
+uint32_t USBHSerialCPSetLineConfig(tSerialInstance *psSerialInstance, uint32_t ui32Baud, uint32_t ui32Coding)
+{
+    //
+    // The baud rate and line control are separate requests on this device.
+    //
+    return (USBHSerialCPSetBaud(psSerialInstance, ui32Baud) |
+            USBHSerialCPSetCoding(psSerialInstance, ui32Coding));
+}
+
+//
+// Reads a byte count from the serial status of the device.  The status holds
+// the error and hold flags followed by the number of bytes in the receive
+// and transmit queues, little endian.  Returns 0 if the request failed.
+//
+static uint32_t USBHSerialCPCommStatus(tSerialInstance *psSerialInstance,
+                                       uint32_t ui32Offset)
+{
+    tUSBRequest sSetupPacket;
+    uint8_t pui8Status[0x13];
+
+    sSetupPacket.bmRequestType = USB_RTYPE_DIR_IN | USB_RTYPE_VENDOR |
+                                 USB_RTYPE_INTERFACE;
+    sSetupPacket.bRequest = CPCDC_GET_COMM_STATUS;
+    sSetupPacket.wValue = 0;
+    sSetupPacket.wIndex = 0;
+    sSetupPacket.wLength = 0x13;
+
+    if(USBHSControlTransfer(psSerialInstance, &sSetupPacket, pui8Status,
+                            0x13) < ui32Offset + 4)
+    {
+        return (0);
+    }
+
+    return ((uint32_t)pui8Status[ui32Offset] |
+            ((uint32_t)pui8Status[ui32Offset + 1] << 8) |
+            ((uint32_t)pui8Status[ui32Offset + 2] << 16) |
+            ((uint32_t)pui8Status[ui32Offset + 3] << 24));
+}
+
+uint32_t USBHSerialCPGetRxQueue(tSerialInstance *psSerialInstance)
+{
+    return (USBHSerialCPCommStatus(psSerialInstance, 8));
+}
 
+uint32_t USBHSerialCPGetTxQueue(tSerialInstance *psSerialInstance)
+{
+    return (USBHSerialCPCommStatus(psSerialInstance, 12));
+}
 
+uint32_t USBHSerialCPPurge(tSerialInstance *psSerialInstance, bool bRx, bool bTx)
+{
+    tUSBRequest sSetupPacket;
+
+    sSetupPacket.bmRequestType = USB_RTYPE_DIR_OUT | USB_RTYPE_VENDOR |
+                                 USB_RTYPE_INTERFACE;
+    sSetupPacket.bRequest = CPCDC_PURGE;
+
+    //
+    // Each queue has two bits, older devices use the lower and newer ones
+    // the upper of them, so set both.
+    //
+    sSetupPacket.wValue = (bTx ? 0x05 : 0) | (bRx ? 0x0A : 0);
+    sSetupPacket.wIndex = 0;
+    sSetupPacket.wLength = 0;
+
+    USBHSControlTransfer(psSerialInstance, &sSetupPacket, 0, 0);
+
+    return (0);
+}
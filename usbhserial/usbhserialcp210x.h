@@ -45,13 +45,21 @@ extern "C"
 
 #define ADSFADFASDF
 
-#define DECLARE_USB_SERIAL_CP210X_DRIVER                            \
-{                                                                   \
+//*****************************************************************************
+//
+//! Device matching fields of the CP210x driver.
+//
+//*****************************************************************************
+#define USB_SERIAL_CP210X_MATCH                                     \
     USB_CLASS_VEND_SPECIFIC,                                        \
     0x10C4,                                                         \
     0xEA60,                                                         \
     true,                                                           \
-    8,                                                              \
+    8
+
+#define DECLARE_USB_SERIAL_CP210X_DRIVER                            \
+{                                                                   \
+    USB_SERIAL_CP210X_MATCH,                                        \
     USBHSerialCPInit,                                               \
     USBHSerialCPSetBaud,                                            \
     USBHSerialCPGetBaud,                                            \
@@ -61,7 +69,12 @@ extern "C"
     USBHSerialCPGetControlLineState,                                \
     USBHSerialCPSetFlow,                                            \
     USBHSerialCPBreakSet,                                           \
-    USBHSerialCPBreakClear                                          \
+    USBHSerialCPBreakClear,                                         \
+    USBHSerialCPSetLineConfig,                                      \
+    USBHSerialCPGetRxQueue,                                         \
+    USBHSerialCPPurge,                                              \
+    USBHSerialCPGetTxQueue,                                         \
+    USBHSerialCPGetBaudActual                                       \
 }
 
 extern uint32_t USBHSerialCPInit(tSerialInstance *psSerialInstance);
@@ -74,6 +87,11 @@ extern uint32_t USBHSerialCPGetControlLineState(tSerialInstance *psSerialInstanc
 extern uint32_t USBHSerialCPSetFlow(tSerialInstance *psSerialInstance, uint32_t ui32Flow);
 extern uint32_t USBHSerialCPBreakSet(tSerialInstance *psSerialInstance);
 extern uint32_t USBHSerialCPBreakClear(tSerialInstance *psSerialInstance);
+extern uint32_t USBHSerialCPSetLineConfig(tSerialInstance *psSerialInstance, uint32_t ui32Baud, uint32_t ui32Coding);
+extern uint32_t USBHSerialCPGetRxQueue(tSerialInstance *psSerialInstance);
+extern uint32_t USBHSerialCPPurge(tSerialInstance *psSerialInstance, bool bRx, bool bTx);
+extern uint32_t USBHSerialCPGetTxQueue(tSerialInstance *psSerialInstance);
+extern uint32_t USBHSerialCPGetBaudActual(tSerialInstance *psSerialInstance, uint32_t ui32Baud, tUSBHSBaudRange *psRange);
 
 //*****************************************************************************
 //
@@ -46,7 +46,9 @@ extern "C"
 //*****************************************************************************
 //
 //! This is the structure that holds all of the data for a given driver of
-//! a serial device.
+//! a serial device.  The operations from pfnSetLineConfig on were added
+//! later and may be 0, so that driver tables written before them keep
+//! working.
 //
 //*****************************************************************************
 typedef struct {
@@ -126,6 +128,38 @@ typedef struct {
     //
     uint32_t (* pfnBreakClear)(tSerialInstance *psSerialInstance);
 
+    //
+    //! Baud and line coding set function pointer, using as few requests as
+    //! the device allows.  If 0, pfnSetBaud and pfnSetCoding are called
+    //
+    uint32_t (* pfnSetLineConfig)(tSerialInstance *psSerialInstance, uint32_t ui32Baud, uint32_t ui32Coding);
+
+    //
+    //! Function returning the number of received bytes waiting in the
+    //! device, or USBHS_QUEUE_UNKNOWN.  If 0, the count is unknown
+    //
+    uint32_t (* pfnGetRxQueue)(tSerialInstance *psSerialInstance);
+
+    //
+    //! Function discarding the data buffered in the device for either
+    //! direction.  If 0, USBHostSerialPurge() purges the host side only and
+    //! reports the device as unable to purge
+    //
+    uint32_t (* pfnPurge)(tSerialInstance *psSerialInstance, bool bRx, bool bTx);
+
+    //
+    //! Function returning the number of bytes the device has still to send,
+    //! or USBHS_QUEUE_UNKNOWN.  If 0, the count is unknown
+    //
+    uint32_t (* pfnGetTxQueue)(tSerialInstance *psSerialInstance);
+
+    //
+    //! Function returning the baud rate the device produces for a requested
+    //! one, and the supported range if psRange is not 0.  If 0, every rate
+    //! is taken to be produced as requested
+    //
+    uint32_t (* pfnGetBaudActual)(tSerialInstance *psSerialInstance, uint32_t ui32Baud, tUSBHSBaudRange *psRange);
+
 } tUSBSerialDriver;
 
 //*****************************************************************************
@@ -0,0 +1,277 @@
+//*****************************************************************************
+//
+// usbhserialevent.c - Deferred instance callbacks and interrupt time
+//                     statistics for the serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialpriv.h"
+
+//*****************************************************************************
+//
+// Longest time spent in a pipe callback.
+//
+//*****************************************************************************
+uint32_t g_ui32USBHSIsrTimeMax;
+
+#if USBHS_EVENT_QUEUE_DEPTH
+
+#if (USBHS_EVENT_QUEUE_DEPTH & (USBHS_EVENT_QUEUE_DEPTH - 1)) != 0
+#error "USBHS_EVENT_QUEUE_DEPTH must be a power of two"
+#endif
+
+#if USBHS_EVENT_TX_RESERVE >= USBHS_EVENT_QUEUE_DEPTH
+#error "USBHS_EVENT_TX_RESERVE must be less than USBHS_EVENT_QUEUE_DEPTH"
+#endif
+
+//*****************************************************************************
+//
+// The event queue.  All pipe callbacks run in the USB interrupt, so there is
+// a single producer, and USBHostSerialProcessEvents() is the single
+// consumer.  Each side only writes its own index, and a record is complete
+// before the head index that publishes it is advanced.
+//
+//*****************************************************************************
+tUSBHSEvent g_psUSBHSEvents[USBHS_EVENT_QUEUE_DEPTH];
+volatile uint32_t g_ui32USBHSEventHead;
+volatile uint32_t g_ui32USBHSEventTail;
+uint32_t g_ui32USBHSEventsPeak;
+uint32_t g_ui32USBHSEventsLost;
+
+//*****************************************************************************
+//
+// Queues an instance callback.  Called from the pipe callbacks.  Only
+// transmit completions may take the last USBHS_EVENT_TX_RESERVE records.
+//
+//*****************************************************************************
+void
+USBHSEventPush(tSerialInstance *psInstance, uint32_t ui32Event,
+               uint32_t ui32MsgParam, void *pvMsgData)
+{
+    tUSBHSEvent *psEvent;
+    uint32_t ui32Used, ui32Limit;
+
+    ui32Limit = USBHS_EVENT_QUEUE_DEPTH;
+    if(ui32Event != USB_EVENT_TX_COMPLETE)
+    {
+        ui32Limit -= USBHS_EVENT_TX_RESERVE;
+    }
+
+    ui32Used = g_ui32USBHSEventHead - g_ui32USBHSEventTail;
+    if(ui32Used >= ui32Limit)
+    {
+        g_ui32USBHSEventsLost++;
+        USBHS_POOL_DROP(ui32Event, pvMsgData);
+        return;
+    }
+
+    psEvent = g_psUSBHSEvents +
+              (g_ui32USBHSEventHead & (USBHS_EVENT_QUEUE_DEPTH - 1));
+    psEvent->psInstance = psInstance;
+    psEvent->pvMsgData = pvMsgData;
+    psEvent->ui32MsgParam = ui32MsgParam;
+    psEvent->ui32Event = ui32Event;
+
+    if(ui32Event == USB_EVENT_RX_AVAILABLE)
+    {
+        psInstance->ui8RxQueued++;
+    }
+#if USBHS_INT_IN_PIPE
+    else if(ui32Event == USBHS_EVENT_NOTIFY)
+    {
+        psInstance->bNotifyQueued = true;
+    }
+#endif
+
+    USBHSMemoryBarrier();
+    g_ui32USBHSEventHead++;
+
+    if(ui32Used + 1 > g_ui32USBHSEventsPeak)
+    {
+        g_ui32USBHSEventsPeak = ui32Used + 1;
+    }
+}
+
+//*****************************************************************************
+//
+// Discards the receive event of an instance that waits in the queue.  Called
+// by USBHostSerialPurge() in the context of the consumer, which owns the
+// records between the tail and the head.  A discarded record keeps its place
+// in the queue without an instance.
+//
+//*****************************************************************************
+void
+USBHSEventPurge(tSerialInstance *psInstance)
+{
+    tUSBHSEvent *psEvent;
+    uint32_t ui32Pos, ui32Head;
+    uint8_t ui8Count;
+
+    ui8Count = 0;
+    ui32Head = g_ui32USBHSEventHead;
+    USBHSMemoryBarrier();
+
+    for(ui32Pos = g_ui32USBHSEventTail; ui32Pos != ui32Head; ui32Pos++)
+    {
+        psEvent = g_psUSBHSEvents + (ui32Pos & (USBHS_EVENT_QUEUE_DEPTH - 1));
+
+        if((psEvent->psInstance == psInstance) &&
+           (psEvent->ui32Event == USB_EVENT_RX_AVAILABLE))
+        {
+            psEvent->psInstance = 0;
+            ui8Count++;
+        }
+    }
+
+    //
+    // The buffers may be used again.
+    //
+    psInstance->ui8RxHandled += ui8Count;
+}
+
+#endif
+
+//*****************************************************************************
+//
+//! Calls the instance callbacks queued by the USB interrupt.
+//!
+//! When the library is built with USBHS_EVENT_QUEUE_DEPTH set, the pipe
+//! callbacks do not call the application for \b USB_EVENT_RX_AVAILABLE,
+//! \b USB_EVENT_TX_COMPLETE and \b USBHS_EVENT_NOTIFY but queue the events,
+//! and this function calls the instance callbacks with the same parameters.
+//! Call it from the main loop or from a single task.  The receive buffer of
+//! an instance keeps its data until the callback returned.  The device is
+//! not polled while all receive buffers of the instance wait for their
+//! callbacks, nor its interrupt IN endpoint while \b USBHS_EVENT_NOTIFY
+//! waits.  Events of devices that disconnected are discarded.
+//!
+//! \return The number of events handled.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialProcessEvents(void)
+{
+#if USBHS_EVENT_QUEUE_DEPTH
+    tUSBHSEvent *psEvent;
+    tSerialInstance *psInstance;
+    uint32_t ui32Count;
+
+    ui32Count = 0;
+
+    while(g_ui32USBHSEventTail != g_ui32USBHSEventHead)
+    {
+        //
+        // Read the record only after seeing it published.
+        //
+        USBHSMemoryBarrier();
+
+        psEvent = g_psUSBHSEvents +
+                  (g_ui32USBHSEventTail & (USBHS_EVENT_QUEUE_DEPTH - 1));
+        psInstance = psEvent->psInstance;
+
+        //
+        // Records of purged receive events have no instance.  Pool blocks
+        // of events that are not delivered go back to the pool.
+        //
+        if(psInstance != 0)
+        {
+            if(psInstance->bConnected && (psInstance->pfnCallback != 0))
+            {
+                psInstance->pfnCallback(psInstance, psEvent->ui32Event,
+                                        psEvent->ui32MsgParam,
+                                        psEvent->pvMsgData);
+            }
+            else
+            {
+                USBHS_POOL_DROP(psEvent->ui32Event, psEvent->pvMsgData);
+            }
+
+            if(psEvent->ui32Event == USB_EVENT_RX_AVAILABLE)
+            {
+                psInstance->ui8RxHandled++;
+            }
+#if USBHS_INT_IN_PIPE
+            else if(psEvent->ui32Event == USBHS_EVENT_NOTIFY)
+            {
+                psInstance->bNotifyQueued = false;
+            }
+#endif
+        }
+        else
+        {
+            USBHS_POOL_DROP(psEvent->ui32Event, psEvent->pvMsgData);
+        }
+
+        //
+        // Hand the record back once it is no longer used.
+        //
+        USBHSMemoryBarrier();
+        g_ui32USBHSEventTail++;
+        ui32Count++;
+    }
+
+    return(ui32Count);
+#else
+    return(0);
+#endif
+}
+
+//*****************************************************************************
+//
+//! Returns the interrupt time and event queue statistics.
+//!
+//! \param psStats receives the statistics.
+//! \param bClear is true to restart the statistics.
+//!
+//! The time spent in the pipe callbacks is measured with the clock registered
+//! with USBHostSerialSetClock() and is 0 without one.  With callbacks called
+//! from the interrupt it includes the time of the application callbacks,
+//! which shows how much a deferred event queue saves.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialGetEventStats(tUSBHSEventStats *psStats, bool bClear)
+{
+    psStats->ui32IsrTimeMax = g_ui32USBHSIsrTimeMax;
+#if USBHS_EVENT_QUEUE_DEPTH
+    psStats->ui32EventsPeak = g_ui32USBHSEventsPeak;
+    psStats->ui32EventsLost = g_ui32USBHSEventsLost;
+#else
+    psStats->ui32EventsPeak = 0;
+    psStats->ui32EventsLost = 0;
+#endif
+
+    if(bClear)
+    {
+        g_ui32USBHSIsrTimeMax = 0;
+#if USBHS_EVENT_QUEUE_DEPTH
+        g_ui32USBHSEventsPeak = 0;
+        g_ui32USBHSEventsLost = 0;
+#endif
+    }
+}
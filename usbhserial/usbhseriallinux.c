@@ -0,0 +1,702 @@
+//*****************************************************************************
+//
+// usbhseriallinux.c - Linux usbfs backend of the serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+//
+// The POSIX functions used below are declared only when asked for.
+//
+#if defined(__linux__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialbackend.h"
+#include "usbhseriallinux.h"
+
+#if defined(USBHS_BACKEND_TABLE) && defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/usbdevice_fs.h>
+
+//*****************************************************************************
+//
+// The Linux backend drives devices through usbfs, /dev/bus/usb/BBB/DDD.  The
+// kernel driver of every interface is detached while the device is open.
+// Bulk and interrupt transfers are asynchronous URBs that are reaped by
+// USBHostSerialLinuxPoll(), which also polls idle IN pipes and calls the
+// pipe callbacks.  Frame numbers are milliseconds of the monotonic clock.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Largest packet received into the buffer of a pipe, the bulk packet size of
+// a high speed device.
+//
+//*****************************************************************************
+#define LINUX_PACKET            512
+
+//*****************************************************************************
+//
+// Pipe states.  A discarded pipe is freed once its URB has been reaped, a
+// failed pipe reports USB_EVENT_ERROR at the next poll.
+//
+//*****************************************************************************
+#define LINUX_FREE              0
+#define LINUX_IDLE              1
+#define LINUX_BUSY              2
+#define LINUX_DISCARDED         3
+#define LINUX_FAILED            4
+
+//*****************************************************************************
+//
+// An open device.
+//
+//*****************************************************************************
+typedef struct
+{
+    bool bOpen;
+    int iFd;
+    uint8_t ui8Interfaces;
+    void *pvInstance;
+    tUSBHostDevice sDevice;
+    uint8_t pui8Desc[USBHS_LINUX_DESC_SIZE];
+} tLinuxDevice;
+
+//*****************************************************************************
+//
+// A pipe.  The URB ends in a flexible array, so it is the last member.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Type;
+    tLinuxDevice *psDev;
+    tHCDPipeCallback pfnCallback;
+    uint32_t ui32Interval;
+    uint32_t ui32Countdown;
+    uint32_t ui32MaxPacket;
+    uint32_t ui32Received;
+    uint8_t *pui8Data;
+    uint8_t ui8Endpoint;
+    uint8_t ui8State;
+    uint8_t pui8Fifo[LINUX_PACKET];
+    struct usbdevfs_urb sURB;
+} tLinuxPipe;
+
+static tLinuxDevice g_psLinuxDevices[USBHS_MAX_INSTANCES];
+static tLinuxPipe g_psLinuxPipes[USBHS_LINUX_PIPES];
+static uint32_t g_ui32LinuxLast;
+
+//*****************************************************************************
+//
+// Returns milliseconds of the monotonic clock.
+//
+//*****************************************************************************
+static uint32_t
+LinuxMs(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+
+    return((uint32_t)sNow.tv_sec * 1000 + (uint32_t)(sNow.tv_nsec / 1000000));
+}
+
+//*****************************************************************************
+//
+// Returns the pipe of a handle, or 0.
+//
+//*****************************************************************************
+static tLinuxPipe *
+LinuxPipe(uint32_t ui32Pipe)
+{
+    if((ui32Pipe == 0) || (ui32Pipe > USBHS_LINUX_PIPES) ||
+       (g_psLinuxPipes[ui32Pipe - 1].ui8State == LINUX_FREE))
+    {
+        return(0);
+    }
+
+    return(g_psLinuxPipes + ui32Pipe - 1);
+}
+
+//*****************************************************************************
+//
+// Returns the open device of a usblib device.
+//
+//*****************************************************************************
+static tLinuxDevice *
+LinuxDevice(tUSBHostDevice *psDevice)
+{
+    return((tLinuxDevice *)((uint8_t *)psDevice -
+                            offsetof(tLinuxDevice, sDevice)));
+}
+
+//*****************************************************************************
+//
+// Backend operations.
+//
+//*****************************************************************************
+static void
+LinuxInit(void)
+{
+    g_ui32LinuxLast = LinuxMs();
+}
+
+static uint32_t
+LinuxPipeAlloc(uint32_t ui32Type, tUSBHostDevice *psDevice, uint32_t ui32Size,
+               tHCDPipeCallback pfnCallback)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < USBHS_LINUX_PIPES; ui32Idx++)
+    {
+        if(g_psLinuxPipes[ui32Idx].ui8State == LINUX_FREE)
+        {
+            memset(g_psLinuxPipes + ui32Idx, 0, sizeof(tLinuxPipe));
+            g_psLinuxPipes[ui32Idx].ui32Type = ui32Type;
+            g_psLinuxPipes[ui32Idx].psDev = LinuxDevice(psDevice);
+            g_psLinuxPipes[ui32Idx].pfnCallback = pfnCallback;
+            g_psLinuxPipes[ui32Idx].ui8State = LINUX_IDLE;
+
+            return(ui32Idx + 1);
+        }
+    }
+
+    return(0);
+}
+
+static void
+LinuxPipeConfig(uint32_t ui32Pipe, uint32_t ui32MaxPacket,
+                uint32_t ui32Interval, uint32_t ui32Endpoint)
+{
+    tLinuxPipe *psPipe;
+
+    psPipe = LinuxPipe(ui32Pipe);
+    if(psPipe)
+    {
+        psPipe->ui32MaxPacket = (ui32MaxPacket < sizeof(psPipe->pui8Fifo)) ?
+                                ui32MaxPacket : sizeof(psPipe->pui8Fifo);
+        psPipe->ui32Interval = ui32Interval;
+        psPipe->ui32Countdown = ui32Interval;
+        psPipe->ui8Endpoint = (uint8_t)ui32Endpoint |
+                              ((psPipe->ui32Type & EP_PIPE_TYPE_IN) ?
+                               USB_EP_DESC_IN : 0);
+    }
+}
+
+static void
+LinuxPipeFree(uint32_t ui32Pipe)
+{
+    tLinuxPipe *psPipe;
+
+    psPipe = LinuxPipe(ui32Pipe);
+    if(psPipe == 0)
+    {
+        return;
+    }
+
+    //
+    // The URB of a busy pipe belongs to the kernel until it is reaped, even
+    // if the discard fails because it has just completed.
+    //
+    if(psPipe->ui8State == LINUX_BUSY)
+    {
+        ioctl(psPipe->psDev->iFd, USBDEVFS_DISCARDURB, &psPipe->sURB);
+        psPipe->ui8State = LINUX_DISCARDED;
+    }
+    else
+    {
+        psPipe->ui8State = LINUX_FREE;
+    }
+}
+
+static void
+LinuxPipeSchedule(uint32_t ui32Pipe, uint8_t *pui8Data, uint32_t ui32Size)
+{
+    tLinuxPipe *psPipe;
+
+    psPipe = LinuxPipe(ui32Pipe);
+    if((psPipe == 0) || (psPipe->ui8State != LINUX_IDLE))
+    {
+        return;
+    }
+
+    memset(&psPipe->sURB, 0, sizeof(psPipe->sURB));
+    psPipe->sURB.type = (psPipe->ui32Type & EP_PIPE_TYPE_INTR) ?
+                        USBDEVFS_URB_TYPE_INTERRUPT : USBDEVFS_URB_TYPE_BULK;
+    psPipe->sURB.endpoint = psPipe->ui8Endpoint;
+    psPipe->sURB.usercontext = psPipe;
+    psPipe->pui8Data = pui8Data;
+
+    //
+    // IN pipes receive into the buffer given to the schedule call, or into
+    // the FIFO to be read out, which like usblib takes a single packet
+    // whatever size was asked for.
+    //
+    if((psPipe->ui32Type & EP_PIPE_TYPE_IN) && (pui8Data == 0))
+    {
+        psPipe->sURB.buffer = psPipe->pui8Fifo;
+        psPipe->sURB.buffer_length = psPipe->ui32MaxPacket;
+    }
+    else
+    {
+        psPipe->sURB.buffer = pui8Data;
+        psPipe->sURB.buffer_length = ui32Size;
+    }
+
+    if(ioctl(psPipe->psDev->iFd, USBDEVFS_SUBMITURB, &psPipe->sURB) < 0)
+    {
+        psPipe->ui8State = LINUX_FAILED;
+    }
+    else
+    {
+        psPipe->ui8State = LINUX_BUSY;
+    }
+}
+
+static uint32_t
+LinuxPipeSizeGet(uint32_t ui32Pipe)
+{
+    tLinuxPipe *psPipe;
+
+    psPipe = LinuxPipe(ui32Pipe);
+
+    return(psPipe ? psPipe->ui32Received : 0);
+}
+
+static void
+LinuxPipeRead(uint32_t ui32Pipe, uint8_t *pui8Data, uint32_t ui32Size)
+{
+    tLinuxPipe *psPipe;
+
+    psPipe = LinuxPipe(ui32Pipe);
+    if(psPipe && pui8Data)
+    {
+        if(ui32Size > psPipe->ui32Received)
+        {
+            ui32Size = psPipe->ui32Received;
+        }
+        memcpy(pui8Data, psPipe->pui8Fifo, ui32Size);
+    }
+}
+
+static uint32_t
+LinuxControlTransfer(tUSBHostDevice *psDevice, tUSBRequest *psSetupPacket,
+                     uint8_t *pui8Data, uint32_t ui32Size)
+{
+    struct usbdevfs_ctrltransfer sCtrl;
+    int iBytes;
+
+    sCtrl.bRequestType = psSetupPacket->bmRequestType;
+    sCtrl.bRequest = psSetupPacket->bRequest;
+    sCtrl.wValue = psSetupPacket->wValue;
+    sCtrl.wIndex = psSetupPacket->wIndex;
+    sCtrl.wLength = (psSetupPacket->wLength < ui32Size) ?
+                    psSetupPacket->wLength : (uint16_t)ui32Size;
+    sCtrl.timeout = 1000;
+    sCtrl.data = pui8Data;
+
+    iBytes = ioctl(LinuxDevice(psDevice)->iFd, USBDEVFS_CONTROL, &sCtrl);
+
+    return((iBytes < 0) ? 0 : (uint32_t)iBytes);
+}
+
+static void
+LinuxClearFeature(tUSBHostDevice *psDevice, uint32_t ui32Pipe,
+                  uint32_t ui32Feature)
+{
+    tLinuxPipe *psPipe;
+    unsigned int uiEndpoint;
+
+    psPipe = LinuxPipe(ui32Pipe);
+    if(psPipe && (ui32Feature == USB_FEATURE_EP_HALT))
+    {
+        uiEndpoint = psPipe->ui8Endpoint;
+        ioctl(LinuxDevice(psDevice)->iFd, USBDEVFS_CLEAR_HALT, &uiEndpoint);
+    }
+}
+
+static uint32_t
+LinuxFrameGet(void)
+{
+    return(LinuxMs());
+}
+
+const tUSBHSBackend g_sUSBHSBackendLinux =
+{
+    LinuxInit,
+    LinuxPipeAlloc,
+    LinuxPipeConfig,
+    LinuxPipeFree,
+    LinuxPipeSchedule,
+    LinuxPipeSizeGet,
+    LinuxPipeRead,
+    LinuxPipeSizeGet,
+    LinuxControlTransfer,
+    LinuxClearFeature,
+    LinuxFrameGet
+};
+
+//*****************************************************************************
+//
+// Releases the interfaces of a device, hands them back to their kernel
+// drivers and closes it.
+//
+//*****************************************************************************
+static void
+LinuxRelease(tLinuxDevice *psDev, uint32_t ui32Claimed)
+{
+    struct usbdevfs_ioctl sCommand;
+    uint32_t ui32Idx;
+    unsigned int uiInterface;
+
+    //
+    // Closing the file kills the URBs still queued, so pipes waiting for a
+    // discarded URB are free as well.
+    //
+    for(ui32Idx = 0; ui32Idx < USBHS_LINUX_PIPES; ui32Idx++)
+    {
+        if(g_psLinuxPipes[ui32Idx].psDev == psDev)
+        {
+            g_psLinuxPipes[ui32Idx].ui8State = LINUX_FREE;
+        }
+    }
+
+    for(uiInterface = 0; uiInterface < ui32Claimed; uiInterface++)
+    {
+        ioctl(psDev->iFd, USBDEVFS_RELEASEINTERFACE, &uiInterface);
+
+        sCommand.ifno = uiInterface;
+        sCommand.ioctl_code = USBDEVFS_CONNECT;
+        sCommand.data = 0;
+        ioctl(psDev->iFd, USBDEVFS_IOCTL, &sCommand);
+    }
+
+    close(psDev->iFd);
+    psDev->bOpen = false;
+    psDev->pvInstance = 0;
+}
+
+//*****************************************************************************
+//
+//! Opens a device through usbfs.
+//!
+//! \param pcPath is the usbfs node of the device, /dev/bus/usb/BBB/DDD.
+//!
+//! The kernel drivers of the interfaces are detached, the interfaces are
+//! claimed and the device is announced to the library, so
+//! \b USB_EVENT_CONNECTED reaches the global callback before the function
+//! returns.  The library must be built with USBHS_BACKEND_TABLE and use
+//! \b g_sUSBHSBackendLinux.
+//!
+//! \return The instance of the device, or 0 if it cannot be opened or is not
+//! supported.
+//
+//*****************************************************************************
+void *
+USBHostSerialLinuxOpen(const char *pcPath)
+{
+    struct usbdevfs_ioctl sCommand;
+    tLinuxDevice *psDev;
+    uint32_t ui32Idx, ui32Size;
+    unsigned int uiInterface;
+    ssize_t iRead;
+
+    for(ui32Idx = 0; ui32Idx < USBHS_MAX_INSTANCES; ui32Idx++)
+    {
+        if(!g_psLinuxDevices[ui32Idx].bOpen)
+        {
+            break;
+        }
+    }
+    if(ui32Idx == USBHS_MAX_INSTANCES)
+    {
+        return(0);
+    }
+    psDev = g_psLinuxDevices + ui32Idx;
+
+    psDev->iFd = open(pcPath, O_RDWR | O_CLOEXEC);
+    if(psDev->iFd < 0)
+    {
+        return(0);
+    }
+    psDev->bOpen = true;
+
+    //
+    // Reading the node returns the device descriptor followed by the
+    // configuration descriptors.
+    //
+    iRead = read(psDev->iFd, psDev->pui8Desc, sizeof(psDev->pui8Desc));
+    if((iRead < (ssize_t)(sizeof(tDeviceDescriptor) + 9)) ||
+       (psDev->pui8Desc[1] != USB_DTYPE_DEVICE))
+    {
+        LinuxRelease(psDev, 0);
+        return(0);
+    }
+
+    memset(&psDev->sDevice, 0, sizeof(psDev->sDevice));
+    memcpy(&psDev->sDevice.sDeviceDescriptor, psDev->pui8Desc,
+           sizeof(tDeviceDescriptor));
+    psDev->sDevice.psConfigDescriptor =
+        (tConfigDescriptor *)(psDev->pui8Desc + sizeof(tDeviceDescriptor));
+    ui32Size = psDev->pui8Desc[sizeof(tDeviceDescriptor) + 2] |
+               ((uint32_t)psDev->pui8Desc[sizeof(tDeviceDescriptor) + 3] << 8);
+    if(ui32Size > (uint32_t)iRead - sizeof(tDeviceDescriptor))
+    {
+        ui32Size = (uint32_t)iRead - sizeof(tDeviceDescriptor);
+    }
+    psDev->sDevice.ui32ConfigDescriptorSize = ui32Size;
+    psDev->sDevice.ui32Address = ui32Idx + 1;
+    psDev->ui8Interfaces = psDev->pui8Desc[sizeof(tDeviceDescriptor) + 4];
+
+    for(uiInterface = 0; uiInterface < psDev->ui8Interfaces; uiInterface++)
+    {
+        //
+        // Detaching fails if no kernel driver is bound, which is fine.
+        //
+        sCommand.ifno = uiInterface;
+        sCommand.ioctl_code = USBDEVFS_DISCONNECT;
+        sCommand.data = 0;
+        ioctl(psDev->iFd, USBDEVFS_IOCTL, &sCommand);
+
+        if(ioctl(psDev->iFd, USBDEVFS_CLAIMINTERFACE, &uiInterface) < 0)
+        {
+            LinuxRelease(psDev, uiInterface);
+            return(0);
+        }
+    }
+
+    psDev->pvInstance = USBHostSerialBackendConnect(&psDev->sDevice);
+    if(psDev->pvInstance == 0)
+    {
+        LinuxRelease(psDev, psDev->ui8Interfaces);
+    }
+
+    return(psDev->pvInstance);
+}
+
+//*****************************************************************************
+//
+//! Closes a device opened with USBHostSerialLinuxOpen().
+//!
+//! \param pvInstance is the instance of the device.
+//!
+//! \b USB_EVENT_DISCONNECTED is sent to the instance callback and the
+//! interfaces are handed back to their kernel drivers.  A device that is
+//! unplugged is closed by USBHostSerialLinuxPoll().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialLinuxClose(void *pvInstance)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < USBHS_MAX_INSTANCES; ui32Idx++)
+    {
+        if(g_psLinuxDevices[ui32Idx].bOpen &&
+           (g_psLinuxDevices[ui32Idx].pvInstance == pvInstance))
+        {
+            USBHostSerialBackendDisconnect(pvInstance);
+            LinuxRelease(g_psLinuxDevices + ui32Idx,
+                         g_psLinuxDevices[ui32Idx].ui8Interfaces);
+            return;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Reports the completion of a reaped URB.  Returns 1 if the pipe callback
+// was called.
+//
+//*****************************************************************************
+static uint32_t
+LinuxComplete(struct usbdevfs_urb *psURB)
+{
+    tLinuxPipe *psPipe;
+    uint32_t ui32Event;
+
+    psPipe = (tLinuxPipe *)psURB->usercontext;
+    if(psPipe->ui8State == LINUX_DISCARDED)
+    {
+        psPipe->ui8State = LINUX_FREE;
+        return(0);
+    }
+
+    psPipe->ui8State = LINUX_IDLE;
+    psPipe->ui32Countdown = psPipe->ui32Interval;
+
+    switch(psURB->status)
+    {
+        case 0:
+        {
+            if(psPipe->ui32Type & EP_PIPE_TYPE_IN)
+            {
+                psPipe->ui32Received = psURB->actual_length;
+                ui32Event = USB_EVENT_RX_AVAILABLE;
+            }
+            else
+            {
+                ui32Event = USB_EVENT_TX_COMPLETE;
+            }
+            break;
+        }
+        case -EPIPE:
+        {
+            ui32Event = USB_EVENT_STALL;
+            break;
+        }
+        case -ENOENT:
+        case -ECONNRESET:
+        {
+            return(0);
+        }
+        default:
+        {
+            ui32Event = USB_EVENT_ERROR;
+            break;
+        }
+    }
+
+    psPipe->pfnCallback((uint32_t)(psPipe - g_psLinuxPipes) + 1, ui32Event);
+
+    return(1);
+}
+
+//*****************************************************************************
+//
+//! Runs the Linux backend.
+//!
+//! \param i32Timeout is the time in milliseconds to wait for a transfer to
+//! complete, 0 to return at once or -1 to wait without limit.
+//!
+//! Completed transfers are reported to the library, idle IN pipes are
+//! polled once their interval has passed and unplugged devices are closed.
+//! The pipe callbacks of the library are called from this function, which
+//! stands in for the USB interrupt; call it in a loop together with
+//! USBHostSerialProcess().
+//!
+//! \return The number of pipe events reported.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialLinuxPoll(int32_t i32Timeout)
+{
+    struct pollfd psFds[USBHS_MAX_INSTANCES];
+    tLinuxDevice *ppsDevs[USBHS_MAX_INSTANCES];
+    struct usbdevfs_urb *psURB;
+    tLinuxPipe *psPipe;
+    uint32_t ui32Idx, ui32Num, ui32Count, ui32Now, ui32Elapsed;
+    bool bGone;
+
+    ui32Num = 0;
+    for(ui32Idx = 0; ui32Idx < USBHS_MAX_INSTANCES; ui32Idx++)
+    {
+        if(g_psLinuxDevices[ui32Idx].bOpen)
+        {
+            psFds[ui32Num].fd = g_psLinuxDevices[ui32Idx].iFd;
+            psFds[ui32Num].events = POLLOUT;
+            psFds[ui32Num].revents = 0;
+            ppsDevs[ui32Num++] = g_psLinuxDevices + ui32Idx;
+        }
+    }
+
+    ui32Count = 0;
+
+    //
+    // usbfs signals completed URBs as writable.
+    //
+    if(poll(psFds, ui32Num, i32Timeout) > 0)
+    {
+        for(ui32Idx = 0; ui32Idx < ui32Num; ui32Idx++)
+        {
+            bGone = (psFds[ui32Idx].revents & (POLLERR | POLLHUP)) != 0;
+
+            while(!bGone &&
+                  (ioctl(ppsDevs[ui32Idx]->iFd, USBDEVFS_REAPURBNDELAY,
+                         &psURB) == 0))
+            {
+                ui32Count += LinuxComplete(psURB);
+            }
+            if(errno == ENODEV)
+            {
+                bGone = true;
+            }
+
+            if(bGone && ppsDevs[ui32Idx]->bOpen)
+            {
+                USBHostSerialLinuxClose(ppsDevs[ui32Idx]->pvInstance);
+            }
+        }
+    }
+
+    //
+    // Report submissions that failed and poll idle IN pipes.
+    //
+    ui32Now = LinuxMs();
+    ui32Elapsed = ui32Now - g_ui32LinuxLast;
+    g_ui32LinuxLast = ui32Now;
+
+    for(ui32Idx = 0; ui32Idx < USBHS_LINUX_PIPES; ui32Idx++)
+    {
+        psPipe = g_psLinuxPipes + ui32Idx;
+
+        if(psPipe->ui8State == LINUX_FAILED)
+        {
+            psPipe->ui8State = LINUX_IDLE;
+            psPipe->pfnCallback(ui32Idx + 1, USB_EVENT_ERROR);
+            ui32Count++;
+        }
+        else if((psPipe->ui8State == LINUX_IDLE) &&
+                (psPipe->ui32Type & EP_PIPE_TYPE_IN) && (ui32Elapsed != 0))
+        {
+            if(psPipe->ui32Countdown > ui32Elapsed)
+            {
+                psPipe->ui32Countdown -= ui32Elapsed;
+                continue;
+            }
+
+            psPipe->ui32Countdown = psPipe->ui32Interval;
+            psPipe->pfnCallback(ui32Idx + 1, USB_EVENT_SCHEDULER);
+            ui32Count++;
+        }
+    }
+
+    return(ui32Count);
+}
+
+#endif
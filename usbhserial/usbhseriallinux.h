@@ -0,0 +1,89 @@
+//*****************************************************************************
+//
+// usbhseriallinux.h - Linux usbfs backend of the serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#ifndef USBHSERIALLINUX_H_
+#define USBHSERIALLINUX_H_
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+//! \addtogroup usblib_host_class
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+//! Number of pipes of the Linux usbfs backend.
+//
+//*****************************************************************************
+#ifndef USBHS_LINUX_PIPES
+#define USBHS_LINUX_PIPES       (3 * USBHS_MAX_INSTANCES)
+#endif
+
+//*****************************************************************************
+//
+//! Size of the buffer holding the descriptors read from a device.
+//
+//*****************************************************************************
+#ifndef USBHS_LINUX_DESC_SIZE
+#define USBHS_LINUX_DESC_SIZE   512
+#endif
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void *USBHostSerialLinuxOpen(const char *pcPath);
+extern void USBHostSerialLinuxClose(void *pvInstance);
+extern uint32_t USBHostSerialLinuxPoll(int32_t i32Timeout);
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USBHSERIALLINUX_H_ */
@@ -0,0 +1,422 @@
+//*****************************************************************************
+//
+// usbhserialpool.c - Shared fixed-block buffer pool of the serial host
+//                    library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialpriv.h"
+
+#if USBHS_POOL_BLOCKS
+
+#if USBHS_POOL_BLOCKS >= 0xFFFF
+#error "USBHS_POOL_BLOCKS must be less than 65535"
+#endif
+
+//*****************************************************************************
+//
+// The free blocks form a stack linked through g_pui16USBHSPoolNext.  The
+// head holds the index of the top block in the lower 16 bits and a tag in
+// the upper 16 bits that changes with every update, so a compare-and-swap
+// fails when the top block was taken and given back in between.  Blocks are
+// taken and given back from the USB interrupt and from tasks alike without
+// disabling interrupts.
+//
+//*****************************************************************************
+#define POOL_END                0xFFFF
+#define POOL_TAG                0x10000
+
+//*****************************************************************************
+//
+// The blocks, kept word aligned for the DMA, the free stack, the instance
+// charged for each block in use and the statistics.
+//
+//*****************************************************************************
+uint32_t g_pui32USBHSPool[USBHS_POOL_BLOCKS][USB_TRANSFER_SIZE / 4];
+uint16_t g_pui16USBHSPoolNext[USBHS_POOL_BLOCKS];
+tSerialInstance *g_ppsUSBHSPoolOwner[USBHS_POOL_BLOCKS];
+volatile uint32_t g_ui32USBHSPoolHead;
+volatile uint32_t g_ui32USBHSPoolFree;
+uint32_t g_ui32USBHSPoolFreeMin;
+uint32_t g_ui32USBHSPoolEmpty;
+uint32_t g_ui32USBHSPoolOverQuota;
+
+//*****************************************************************************
+//
+// Adds to a counter shared between the interrupt and tasks.  A counter that
+// would drop below 0 is left alone and false is returned.
+//
+//*****************************************************************************
+static bool
+PoolCount(volatile uint32_t *pui32Count, int32_t i32Add)
+{
+    uint32_t ui32Count;
+
+    do
+    {
+        ui32Count = *pui32Count;
+        if((i32Add < 0) && (ui32Count < (uint32_t)-i32Add))
+        {
+            return(false);
+        }
+    }
+    while(!USBHSAtomicCAS(pui32Count, ui32Count, ui32Count + i32Add));
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Takes a block off the free stack and charges it to an instance, unless
+// that would leave fewer than ui32Keep blocks of its quota.  Returns the
+// block index or POOL_END if the instance holds its quota or the pool is
+// empty.
+//
+//*****************************************************************************
+static uint32_t
+PoolTake(tSerialInstance *psInstance, uint32_t ui32Keep)
+{
+    uint32_t ui32Head, ui32Idx, ui32Used, ui32Free;
+
+    //
+    // Reserve the place in the quota first, so that an interrupt taking a
+    // block at the same time cannot exceed it.
+    //
+    do
+    {
+        ui32Used = psInstance->ui32PoolUsed;
+        if(ui32Used + ui32Keep >= psInstance->ui8PoolQuota)
+        {
+            psInstance->ui32PoolDenied++;
+            g_ui32USBHSPoolOverQuota++;
+            return(POOL_END);
+        }
+    }
+    while(!USBHSAtomicCAS(&psInstance->ui32PoolUsed, ui32Used,
+                          ui32Used + 1));
+
+    do
+    {
+        ui32Head = g_ui32USBHSPoolHead;
+        ui32Idx = ui32Head & POOL_END;
+        if(ui32Idx == POOL_END)
+        {
+            PoolCount(&psInstance->ui32PoolUsed, -1);
+            psInstance->ui32PoolDenied++;
+            g_ui32USBHSPoolEmpty++;
+            return(POOL_END);
+        }
+    }
+    while(!USBHSAtomicCAS(&g_ui32USBHSPoolHead, ui32Head,
+                          ((ui32Head + POOL_TAG) & ~POOL_END) |
+                          g_pui16USBHSPoolNext[ui32Idx]));
+
+    g_ppsUSBHSPoolOwner[ui32Idx] = psInstance;
+
+    PoolCount(&g_ui32USBHSPoolFree, -1);
+    ui32Free = g_ui32USBHSPoolFree;
+    if(ui32Free < g_ui32USBHSPoolFreeMin)
+    {
+        g_ui32USBHSPoolFreeMin = ui32Free;
+    }
+
+    return(ui32Idx);
+}
+
+//*****************************************************************************
+//
+// Initializes the pool with all blocks free.  Called by USBHostSerialInit().
+//
+//*****************************************************************************
+void
+USBHSPoolInit(void)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < USBHS_POOL_BLOCKS; ui32Idx++)
+    {
+        g_pui16USBHSPoolNext[ui32Idx] = (ui32Idx + 1 < USBHS_POOL_BLOCKS) ?
+                                        (uint16_t)(ui32Idx + 1) : POOL_END;
+        g_ppsUSBHSPoolOwner[ui32Idx] = 0;
+    }
+
+    g_ui32USBHSPoolHead = 0;
+    g_ui32USBHSPoolFree = USBHS_POOL_BLOCKS;
+    g_ui32USBHSPoolFreeMin = USBHS_POOL_BLOCKS;
+    g_ui32USBHSPoolEmpty = 0;
+    g_ui32USBHSPoolOverQuota = 0;
+}
+
+//*****************************************************************************
+//
+// Makes sure an instance that receives into the pool has a block before its
+// bulk IN pipe is armed.  Returns false if no block could be taken, in which
+// case the device is not polled and NAKs until a block is given back.
+// Called from the pipe callbacks.
+//
+//*****************************************************************************
+bool
+USBHSPoolRxArm(tSerialInstance *psInstance)
+{
+    uint32_t ui32Idx;
+
+    if(!USBHS_POOL_RX(psInstance) || (psInstance->pui8PoolRx != 0))
+    {
+        return(true);
+    }
+
+    ui32Idx = PoolTake(psInstance, 0);
+    if(ui32Idx == POOL_END)
+    {
+        return(false);
+    }
+
+    psInstance->pui8PoolRx = (uint8_t *)g_pui32USBHSPool[ui32Idx];
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Gives back the receive block of a device that disconnected.  Blocks still
+// held by the application are no longer charged to the instance, which may
+// be reused for another device before they are freed.
+//
+//*****************************************************************************
+void
+USBHSPoolClose(tSerialInstance *psInstance)
+{
+    uint8_t *pui8Block;
+    uint32_t ui32Idx;
+
+    pui8Block = psInstance->pui8PoolRx;
+    psInstance->pui8PoolRx = 0;
+    USBHostSerialPoolFree(pui8Block);
+
+    for(ui32Idx = 0; ui32Idx < USBHS_POOL_BLOCKS; ui32Idx++)
+    {
+        if(g_ppsUSBHSPoolOwner[ui32Idx] == psInstance)
+        {
+            g_ppsUSBHSPoolOwner[ui32Idx] = 0;
+        }
+    }
+
+    psInstance->ui32PoolUsed = 0;
+}
+
+#endif
+
+//*****************************************************************************
+//
+//! Takes a block from the shared buffer pool.
+//!
+//! \param psSerialInstance is the instance the block is charged to.
+//!
+//! The block holds USB_TRANSFER_SIZE bytes.  Fill it and pass it to
+//! USBHostSerialScheduleWrite(), then free it with USBHostSerialPoolFree()
+//! once \b USB_EVENT_TX_COMPLETE returned it.  The block counts against the
+//! quota of the instance until it is freed; an instance receiving into the
+//! pool keeps one block of its quota for that.  The function may be called from
+//! any task and from interrupt handlers.
+//!
+//! \return Returns the block, or 0 if the pool is empty, the instance holds
+//! its quota or the library was built without a pool.
+//
+//*****************************************************************************
+void *
+USBHostSerialPoolAlloc(tSerialInstance *psSerialInstance)
+{
+#if USBHS_POOL_BLOCKS
+    uint32_t ui32Idx;
+
+    //
+    // Keep the last block of the quota for receiving, so that data being
+    // sent cannot stop the device from being read.
+    //
+    ui32Idx = PoolTake(psSerialInstance,
+                       (USBHS_POOL_RX(psSerialInstance) &&
+                        (psSerialInstance->pui8PoolRx == 0)) ? 1 : 0);
+    if(ui32Idx == POOL_END)
+    {
+        return(0);
+    }
+
+    return(g_pui32USBHSPool[ui32Idx]);
+#else
+    return(0);
+#endif
+}
+
+//*****************************************************************************
+//
+//! Gives a block back to the shared buffer pool.
+//!
+//! \param pvBlock is the block.
+//!
+//! Instances set up without a receive buffer pass each packet to the
+//! \b USB_EVENT_RX_AVAILABLE callback in a block of its own, which belongs to
+//! the application from then on.  Free it here when the data has been used,
+//! from the callback or later from any task or interrupt handler.  Blocks
+//! taken with USBHostSerialPoolAlloc() are freed the same way.  Pointers
+//! that are not pool blocks, including 0, are ignored.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialPoolFree(void *pvBlock)
+{
+#if USBHS_POOL_BLOCKS
+    tSerialInstance *psOwner;
+    uint32_t ui32Offset, ui32Idx, ui32Head;
+
+    ui32Offset = (uint32_t)((uint8_t *)pvBlock -
+                            (uint8_t *)g_pui32USBHSPool);
+    if(((uint8_t *)pvBlock < (uint8_t *)g_pui32USBHSPool) ||
+       (ui32Offset >= sizeof(g_pui32USBHSPool)) ||
+       ((ui32Offset % USB_TRANSFER_SIZE) != 0))
+    {
+        return;
+    }
+    ui32Idx = ui32Offset / USB_TRANSFER_SIZE;
+
+    psOwner = g_ppsUSBHSPoolOwner[ui32Idx];
+    g_ppsUSBHSPoolOwner[ui32Idx] = 0;
+    if(psOwner != 0)
+    {
+        PoolCount(&psOwner->ui32PoolUsed, -1);
+    }
+
+    do
+    {
+        ui32Head = g_ui32USBHSPoolHead;
+        g_pui16USBHSPoolNext[ui32Idx] = (uint16_t)(ui32Head & POOL_END);
+    }
+    while(!USBHSAtomicCAS(&g_ui32USBHSPoolHead, ui32Head,
+                          ((ui32Head + POOL_TAG) & ~POOL_END) | ui32Idx));
+
+    PoolCount(&g_ui32USBHSPoolFree, 1);
+#endif
+}
+
+//*****************************************************************************
+//
+//! Sets how many pool blocks an instance may hold.
+//!
+//! \param psSerialInstance is an instance pointer, received by global callback
+//! function.
+//! \param ui32Blocks is the number of blocks, at most 255.
+//!
+//! The quota covers the block the bulk IN pipe receives into, received
+//! blocks not yet freed by the application and blocks taken with
+//! USBHostSerialPoolAlloc().  An instance that holds its quota is not polled
+//! until the application frees a block, so a busy or stalled port cannot
+//! take the whole pool from the others.  A quota of 0 makes the instance
+//! receive into the scratch buffer as without a pool.  Instances start with
+//! USBHS_POOL_QUOTA when the device is connected.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialPoolSetQuota(tSerialInstance *psSerialInstance,
+                          uint32_t ui32Blocks)
+{
+#if USBHS_POOL_BLOCKS
+    psSerialInstance->ui8PoolQuota = (ui32Blocks > 0xFF) ? 0xFF :
+                                     (uint8_t)ui32Blocks;
+#endif
+}
+
+//*****************************************************************************
+//
+//! Returns the pool blocks held by an instance.
+//!
+//! \param psSerialInstance is the instance to read.
+//! \param pui32Denied receives the number of times the instance was refused
+//! a block since the device was connected.  May be 0.
+//!
+//! \return The number of blocks charged to the instance.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialPoolGetUsage(tSerialInstance *psSerialInstance,
+                          uint32_t *pui32Denied)
+{
+#if USBHS_POOL_BLOCKS
+    if(pui32Denied != 0)
+    {
+        *pui32Denied = psSerialInstance->ui32PoolDenied;
+    }
+
+    return(psSerialInstance->ui32PoolUsed);
+#else
+    if(pui32Denied != 0)
+    {
+        *pui32Denied = 0;
+    }
+
+    return(0);
+#endif
+}
+
+//*****************************************************************************
+//
+//! Returns the shared buffer pool statistics.
+//!
+//! \param psStats receives the statistics.
+//! \param bClear is true to restart the low water mark and the counters.
+//!
+//! The low water mark tells how far USBHS_POOL_BLOCKS can be reduced for the
+//! load seen so far.  Without a pool all values are 0.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialGetPoolStats(tUSBHSPoolStats *psStats, bool bClear)
+{
+#if USBHS_POOL_BLOCKS
+    psStats->ui32Blocks = USBHS_POOL_BLOCKS;
+    psStats->ui32Free = g_ui32USBHSPoolFree;
+    psStats->ui32FreeMin = g_ui32USBHSPoolFreeMin;
+    psStats->ui32Empty = g_ui32USBHSPoolEmpty;
+    psStats->ui32OverQuota = g_ui32USBHSPoolOverQuota;
+
+    if(bClear)
+    {
+        g_ui32USBHSPoolFreeMin = g_ui32USBHSPoolFree;
+        g_ui32USBHSPoolEmpty = 0;
+        g_ui32USBHSPoolOverQuota = 0;
+    }
+#else
+    psStats->ui32Blocks = 0;
+    psStats->ui32Free = 0;
+    psStats->ui32FreeMin = 0;
+    psStats->ui32Empty = 0;
+    psStats->ui32OverQuota = 0;
+#endif
+}
@@ -0,0 +1,471 @@
+//*****************************************************************************
+//
+// usbhserialpriv.h - Private definitions shared by the serial host library
+//                    modules.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#ifndef USBHSERIALPRIV_H_
+#define USBHSERIALPRIV_H_
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Atomic primitives.  On Cortex-M these are built on the LDREX/STREX
+// exclusive monitor so no interrupts are ever disabled.  Any other target is
+// assumed to be a host build and uses C11 atomics.
+//
+//*****************************************************************************
+#if defined(__TI_ARM__)
+
+static inline bool
+USBHSAtomicCAS(volatile uint32_t *pui32Addr, uint32_t ui32Old,
+               uint32_t ui32New)
+{
+    do
+    {
+        if(__ldrex((void *)pui32Addr) != ui32Old)
+        {
+            __clrex();
+            return(false);
+        }
+    }
+    while(__strex(ui32New, (void *)pui32Addr) != 0);
+
+    return(true);
+}
+
+#define USBHSMemoryBarrier()    __asm(" dmb")
+
+#elif defined(__arm__)
+
+static inline bool
+USBHSAtomicCAS(volatile uint32_t *pui32Addr, uint32_t ui32Old,
+               uint32_t ui32New)
+{
+    uint32_t ui32Value, ui32Fail;
+
+    do
+    {
+        __asm volatile("ldrex %0, [%1]" : "=r" (ui32Value) : "r" (pui32Addr)
+                       : "memory");
+        if(ui32Value != ui32Old)
+        {
+            __asm volatile("clrex" ::: "memory");
+            return(false);
+        }
+        __asm volatile("strex %0, %2, [%1]" : "=&r" (ui32Fail)
+                       : "r" (pui32Addr), "r" (ui32New) : "memory");
+    }
+    while(ui32Fail != 0);
+
+    return(true);
+}
+
+#define USBHSMemoryBarrier()    __asm volatile("dmb" ::: "memory")
+
+#else
+
+#include <stdatomic.h>
+
+static inline bool
+USBHSAtomicCAS(volatile uint32_t *pui32Addr, uint32_t ui32Old,
+               uint32_t ui32New)
+{
+    return(atomic_compare_exchange_strong(
+                (volatile _Atomic uint32_t *)pui32Addr, &ui32Old, ui32New));
+}
+
+#define USBHSMemoryBarrier()    atomic_thread_fence(memory_order_seq_cst)
+
+#endif
+
+//*****************************************************************************
+//
+// Library state shared between the modules (usbhserial.c).
+//
+//*****************************************************************************
+extern tSerialInstance g_psInstances[];
+extern uint8_t g_ui8NumInstances;
+extern tUSBCallback g_pfnGlobalAppCB;
+extern tUSBHSClock g_pfnUSBHSClock;
+
+extern void USBHSerialCallback(uint32_t ui32Pipe, uint32_t ui32Event);
+#if USBHS_INT_IN_PIPE
+extern void USBHSerialIntINCallback(uint32_t ulPipe, uint32_t ulEvent);
+#endif
+extern void *SerialDriverOpen(tUSBHostDevice *psDevice);
+extern void SerialDriverClose(void *pvInstance);
+extern void USBHSerialInstanceReset(tSerialInstance *psInstance);
+extern uint32_t USBHSControlTransfer(tSerialInstance *psInstance,
+                                     tUSBRequest *psSetupPacket,
+                                     uint8_t *pui8Data, uint32_t ui32Size);
+
+//*****************************************************************************
+//
+// Calls a driver operation for an instance.  By default the operation is
+// looked up in the application driver table.  When the library is built
+// with USBHS_STATIC_DRIVERS and one or both of USBHS_STATIC_CDC and
+// USBHS_STATIC_CP210X, the call is resolved at compile time to the driver
+// function itself.
+//
+//*****************************************************************************
+#if defined(USBHS_STATIC_DRIVERS)
+#if defined(USBHS_STATIC_CDC) && defined(USBHS_STATIC_CP210X)
+#define USBHS_DRIVER_CALL(psInstance, Op, Args)                              \
+        (((psInstance)->ui8Driver == 0) ? USBHSerialCDC##Op Args :           \
+                                          USBHSerialCP##Op Args)
+#elif defined(USBHS_STATIC_CDC)
+#define USBHS_DRIVER_CALL(psInstance, Op, Args)                              \
+        USBHSerialCDC##Op Args
+#elif defined(USBHS_STATIC_CP210X)
+#define USBHS_DRIVER_CALL(psInstance, Op, Args)                              \
+        USBHSerialCP##Op Args
+#else
+#error "USBHS_STATIC_DRIVERS requires USBHS_STATIC_CDC or USBHS_STATIC_CP210X"
+#endif
+#else
+#define USBHS_DRIVER_CALL(psInstance, Op, Args)                              \
+        g_psDrivers[(psInstance)->ui8Driver].pfn##Op Args
+#endif
+
+//*****************************************************************************
+//
+// Calls a driver operation that application driver tables written before it
+// was added leave 0, or gives Default if the driver does not have it.  The
+// drivers of the library have every operation.
+//
+//*****************************************************************************
+#if defined(USBHS_STATIC_DRIVERS)
+#define USBHS_DRIVER_HAS(psInstance, Op)                                     \
+        true
+#else
+#define USBHS_DRIVER_HAS(psInstance, Op)                                     \
+        (g_psDrivers[(psInstance)->ui8Driver].pfn##Op != 0)
+#endif
+
+#define USBHS_DRIVER_CALL_OPT(psInstance, Op, Args, Default)                 \
+        (USBHS_DRIVER_HAS(psInstance, Op) ?                                  \
+         USBHS_DRIVER_CALL(psInstance, Op, Args) : (Default))
+
+//*****************************************************************************
+//
+// Reads the application time source.
+//
+//*****************************************************************************
+static inline uint32_t
+USBHSClockGet(void)
+{
+    return(g_pfnUSBHSClock ? g_pfnUSBHSClock() : 0);
+}
+
+//*****************************************************************************
+//
+// Longest time spent in a pipe callback (usbhserialevent.c).  Pipe callbacks
+// read the clock when they start and pass it to USBHSIsrTime() when they
+// return.
+//
+//*****************************************************************************
+extern uint32_t g_ui32USBHSIsrTimeMax;
+
+static inline void
+USBHSIsrTime(uint32_t ui32Start)
+{
+    uint32_t ui32Time;
+
+    ui32Time = USBHSClockGet() - ui32Start;
+    if(ui32Time > g_ui32USBHSIsrTimeMax)
+    {
+        g_ui32USBHSIsrTimeMax = ui32Time;
+    }
+}
+
+//*****************************************************************************
+//
+// Calls an instance callback from a pipe callback.  With an event queue the
+// call is queued for USBHostSerialProcessEvents() (usbhserialevent.c).
+//
+//*****************************************************************************
+#if USBHS_EVENT_QUEUE_DEPTH
+typedef struct
+{
+    tSerialInstance *psInstance;
+    void *pvMsgData;
+    uint32_t ui32MsgParam;
+    uint32_t ui32Event;
+} tUSBHSEvent;
+
+extern tUSBHSEvent g_psUSBHSEvents[USBHS_EVENT_QUEUE_DEPTH];
+extern volatile uint32_t g_ui32USBHSEventHead;
+extern volatile uint32_t g_ui32USBHSEventTail;
+extern uint32_t g_ui32USBHSEventsPeak;
+extern uint32_t g_ui32USBHSEventsLost;
+
+extern void USBHSEventPush(tSerialInstance *psInstance, uint32_t ui32Event,
+                           uint32_t ui32MsgParam, void *pvMsgData);
+extern void USBHSEventPurge(tSerialInstance *psInstance);
+
+#define USBHS_EVENT_SIZE                                                     \
+        (sizeof(g_psUSBHSEvents) + sizeof(g_ui32USBHSEventHead) +            \
+         sizeof(g_ui32USBHSEventTail) + sizeof(g_ui32USBHSEventsPeak) +      \
+         sizeof(g_ui32USBHSEventsLost) + sizeof(g_ui32USBHSIsrTimeMax))
+#define USBHS_CALLBACK(psInstance, ui32Event, ui32MsgParam, pvMsgData)       \
+        USBHSEventPush((psInstance), (ui32Event), (ui32MsgParam), (pvMsgData))
+#define USBHS_EVENT_PURGE(psInstance)                                        \
+        USBHSEventPurge(psInstance)
+#else
+#define USBHS_EVENT_SIZE        sizeof(g_ui32USBHSIsrTimeMax)
+#define USBHS_EVENT_PURGE(psInstance)
+#define USBHS_CALLBACK(psInstance, ui32Event, ui32MsgParam, pvMsgData)       \
+        (psInstance)->pfnCallback((psInstance), (ui32Event), (ui32MsgParam), \
+                                  (pvMsgData))
+#endif
+
+//*****************************************************************************
+//
+// Traffic capture hooks (usbhserialcapture.c).  They compile to nothing
+// unless the library is built with USBHS_CAPTURE defined.
+//
+//*****************************************************************************
+#ifdef USBHS_CAPTURE
+extern volatile bool g_bUSBHSReplay;
+extern const uint8_t *g_pui8USBHSReplayData;
+extern uint32_t g_ui32USBHSReplaySize;
+
+extern void USBHSCaptureRecord(uint32_t ui32Type, tSerialInstance *psInstance,
+                               uint32_t ui32Param, const void *pvData,
+                               uint32_t ui32Size, const void *pvData2,
+                               uint32_t ui32Size2);
+extern void USBHSCaptureOp(tSerialInstance *psInstance, uint32_t ui32Op,
+                           uint32_t ui32Arg0, uint32_t ui32Arg1);
+
+#define USBHS_CAPTURE_EVENT(ui32Type, psInstance, ui32Param, pvData,         \
+                            ui32Size, pvData2, ui32Size2)                    \
+        USBHSCaptureRecord((ui32Type), (psInstance), (ui32Param), (pvData),  \
+                           (ui32Size), (pvData2), (ui32Size2))
+#define USBHS_CAPTURE_OP(psInstance, ui32Op, ui32Arg0, ui32Arg1)             \
+        USBHSCaptureOp((psInstance), (ui32Op), (ui32Arg0), (ui32Arg1))
+#else
+#define USBHS_CAPTURE_EVENT(ui32Type, psInstance, ui32Param, pvData,         \
+                            ui32Size, pvData2, ui32Size2)
+#define USBHS_CAPTURE_OP(psInstance, ui32Op, ui32Arg0, ui32Arg1)
+#endif
+
+//*****************************************************************************
+//
+// Configuration store (usbhserialconfig.c).  The hooks compile to nothing
+// when USBHS_CONFIG_STORE is 0.
+//
+//*****************************************************************************
+#define USBHS_CFG_INIT          USBHS_SETUP_INIT
+#define USBHS_CFG_LINE          USBHS_SETUP_LINE
+#define USBHS_CFG_CONTROL       USBHS_SETUP_CONTROL
+#define USBHS_CFG_FLOW          USBHS_SETUP_FLOW
+
+#if USBHS_CONFIG_STORE
+typedef struct
+{
+    //
+    // Device the entry belongs to.
+    //
+    uint32_t ui32SerialHash;
+    uint16_t ui16VID;
+    uint16_t ui16PID;
+
+    //
+    // Last configuration set by the application.
+    //
+    uint32_t ui32Baud;
+    uint32_t ui32Coding;
+    uint32_t ui32Control;
+    uint32_t ui32Flow;
+
+    //
+    // Time of last use for replacement, and the USBHS_CFG_ items set.
+    //
+    uint32_t ui32Stamp;
+    uint32_t ui32Valid;
+} tUSBHSConfigEntry;
+
+extern tUSBHSConfigEntry g_psUSBHSConfig[USBHS_CONFIG_STORE];
+extern uint32_t g_ui32USBHSConfigStamp;
+
+extern bool USBHSConfigRestore(tSerialInstance *psInstance);
+extern void USBHSConfigSave(tSerialInstance *psInstance, uint32_t ui32Item,
+                            uint32_t ui32Value0, uint32_t ui32Value1);
+
+#define USBHS_CONFIG_SIZE                                                    \
+        (sizeof(g_psUSBHSConfig) + sizeof(g_ui32USBHSConfigStamp))
+#define USBHS_CONFIG_SAVE(psInstance, ui32Item, ui32Value0, ui32Value1)      \
+        USBHSConfigSave((psInstance), (ui32Item), (ui32Value0), (ui32Value1))
+#else
+#define USBHS_CONFIG_SIZE       0
+#define USBHS_CONFIG_SAVE(psInstance, ui32Item, ui32Value0, ui32Value1)
+#endif
+
+//*****************************************************************************
+//
+// Bulk IN scheduler (usbhserialsched.c).  Without a frame budget every poll
+// arms the pipe and the hooks compile to nothing.
+//
+//*****************************************************************************
+#if USBHS_IN_BUDGET
+extern uint32_t g_ui32USBHSInPass;
+extern uint32_t g_ui32USBHSInArmed;
+extern uint16_t g_ui16USBHSInFrame;
+extern uint8_t g_ui8USBHSInFrameArms;
+
+extern bool USBHSInArm(tSerialInstance *psInstance);
+extern void USBHSInReceived(tSerialInstance *psInstance, uint32_t ui32Size);
+extern void USBHSInReset(tSerialInstance *psInstance);
+
+#define USBHS_IN_SIZE                                                        \
+        (sizeof(g_ui32USBHSInPass) + sizeof(g_ui32USBHSInArmed) +            \
+         sizeof(g_ui16USBHSInFrame) + sizeof(g_ui8USBHSInFrameArms))
+#define USBHS_IN_ARM(psInstance)                                             \
+        USBHSInArm(psInstance)
+#define USBHS_IN_RECEIVED(psInstance, ui32Size)                              \
+        USBHSInReceived((psInstance), (ui32Size))
+#define USBHS_IN_RESET(psInstance)                                           \
+        USBHSInReset(psInstance)
+#else
+#define USBHS_IN_SIZE           0
+#define USBHS_IN_ARM(psInstance)                                             \
+        true
+#define USBHS_IN_RECEIVED(psInstance, ui32Size)
+#define USBHS_IN_RESET(psInstance)
+#endif
+
+//*****************************************************************************
+//
+// Bridges between instances (usbhserialbridge.c).  The hooks compile to
+// nothing when USBHS_BRIDGE_BUFFERS is 0.
+//
+//*****************************************************************************
+#if USBHS_BRIDGE_BUFFERS
+extern bool USBHSBridgeArm(tSerialInstance *psInstance);
+extern bool USBHSBridgeReceived(tSerialInstance *psInstance,
+                                uint32_t ui32Size);
+extern bool USBHSBridgeTxDone(tSerialInstance *psInstance, uint8_t *pui8Data);
+extern void USBHSBridgeClose(tSerialInstance *psInstance);
+
+#define USBHS_BRIDGE_ARM(psInstance)                                         \
+        USBHSBridgeArm(psInstance)
+#define USBHS_BRIDGE_RECEIVED(psInstance, ui32Size)                          \
+        USBHSBridgeReceived((psInstance), (ui32Size))
+#define USBHS_BRIDGE_TX_DONE(psInstance, pui8Data)                           \
+        USBHSBridgeTxDone((psInstance), (pui8Data))
+#define USBHS_BRIDGE_CLOSE(psInstance)                                       \
+        USBHSBridgeClose(psInstance)
+#else
+#define USBHS_BRIDGE_ARM(psInstance)                                         \
+        true
+#define USBHS_BRIDGE_RECEIVED(psInstance, ui32Size)                          \
+        false
+#define USBHS_BRIDGE_TX_DONE(psInstance, pui8Data)                           \
+        false
+#define USBHS_BRIDGE_CLOSE(psInstance)
+#endif
+
+//*****************************************************************************
+//
+// Shared buffer pool (usbhserialpool.c).  An instance without an application
+// receive buffer and with a quota receives into pool blocks.  The hooks
+// compile to nothing when USBHS_POOL_BLOCKS is 0.
+//
+//*****************************************************************************
+#if USBHS_POOL_BLOCKS
+extern uint32_t g_pui32USBHSPool[USBHS_POOL_BLOCKS][USB_TRANSFER_SIZE / 4];
+extern uint16_t g_pui16USBHSPoolNext[USBHS_POOL_BLOCKS];
+extern tSerialInstance *g_ppsUSBHSPoolOwner[USBHS_POOL_BLOCKS];
+extern volatile uint32_t g_ui32USBHSPoolHead;
+extern volatile uint32_t g_ui32USBHSPoolFree;
+extern uint32_t g_ui32USBHSPoolFreeMin;
+extern uint32_t g_ui32USBHSPoolEmpty;
+extern uint32_t g_ui32USBHSPoolOverQuota;
+
+extern void USBHSPoolInit(void);
+extern bool USBHSPoolRxArm(tSerialInstance *psInstance);
+extern void USBHSPoolClose(tSerialInstance *psInstance);
+
+#define USBHS_POOL_SIZE                                                      \
+        (sizeof(g_pui32USBHSPool) + sizeof(g_pui16USBHSPoolNext) +           \
+         sizeof(g_ppsUSBHSPoolOwner) + sizeof(g_ui32USBHSPoolHead) +         \
+         sizeof(g_ui32USBHSPoolFree) + sizeof(g_ui32USBHSPoolFreeMin) +      \
+         sizeof(g_ui32USBHSPoolEmpty) + sizeof(g_ui32USBHSPoolOverQuota))
+#define USBHS_POOL_RX(psInstance)                                            \
+        (((psInstance)->ui8PoolQuota != 0) && ((psInstance)->pvInBuffer == 0))
+#define USBHS_POOL_INIT()                                                    \
+        USBHSPoolInit()
+#define USBHS_POOL_ARM(psInstance)                                           \
+        USBHSPoolRxArm(psInstance)
+#define USBHS_POOL_CLOSE(psInstance)                                         \
+        USBHSPoolClose(psInstance)
+#define USBHS_POOL_DROP(ui32Event, pvData)                                   \
+        if(((ui32Event) == USB_EVENT_RX_AVAILABLE) ||                        \
+           ((ui32Event) == USB_EVENT_TX_COMPLETE))                           \
+        {                                                                    \
+            USBHostSerialPoolFree(pvData);                                   \
+        }
+#else
+#define USBHS_POOL_SIZE         0
+#define USBHS_POOL_RX(psInstance)                                            \
+        false
+#define USBHS_POOL_INIT()
+#define USBHS_POOL_ARM(psInstance)                                           \
+        true
+#define USBHS_POOL_CLOSE(psInstance)
+#define USBHS_POOL_DROP(ui32Event, pvData)
+#endif
+
+//*****************************************************************************
+//
+// Lock-free multi-producer, single-consumer queue (usbhserialqueue.c).
+//
+//*****************************************************************************
+extern void USBHSQueueInit(tUSBHSQueue *psQueue, tUSBHSQueueEntry *psEntries,
+                           uint32_t ui32Depth);
+extern bool USBHSQueuePush(tUSBHSQueue *psQueue, void *pvData,
+                           uint32_t ui32Value);
+extern bool USBHSQueuePop(tUSBHSQueue *psQueue, void **ppvData,
+                          uint32_t *pui32Value);
+extern bool USBHSQueueEmpty(tUSBHSQueue *psQueue);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USBHSERIALPRIV_H_ */
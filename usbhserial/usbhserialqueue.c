@@ -0,0 +1,198 @@
+//*****************************************************************************
+//
+// usbhserialqueue.c - Lock-free submission queue used by the serial host
+//                     library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialpriv.h"
+
+//*****************************************************************************
+//
+// The queue is a bounded ring in which every slot carries a sequence number.
+// A slot whose sequence equals the producer position is free, one whose
+// sequence equals the position plus one holds data ready for the consumer.
+// Producers claim a position with a compare-and-swap on the head index and
+// publish the entry by advancing the slot sequence, so any number of tasks
+// and interrupt handlers may push concurrently.  Only one context may pop at
+// a time; the serial library guarantees that with a separate ownership flag.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+//! Initializes a submission queue.
+//!
+//! \param psQueue is the queue to initialize.
+//! \param psEntries is the storage for the queue entries.
+//! \param ui32Depth is the number of entries, which must be a power of two.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHSQueueInit(tUSBHSQueue *psQueue, tUSBHSQueueEntry *psEntries,
+               uint32_t ui32Depth)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < ui32Depth; ui32Idx++)
+    {
+        psEntries[ui32Idx].ui32Sequence = ui32Idx;
+    }
+
+    psQueue->psEntries = psEntries;
+    psQueue->ui32Mask = ui32Depth - 1;
+    psQueue->ui32Head = 0;
+    psQueue->ui32Tail = 0;
+}
+
+//*****************************************************************************
+//
+//! Adds an entry to a submission queue.
+//!
+//! \param psQueue is the queue to add the entry to.
+//! \param pvData is the pointer stored in the entry.
+//! \param ui32Value is the value stored in the entry.
+//!
+//! This function may be called concurrently from any number of tasks and
+//! interrupt handlers.
+//!
+//! \return Returns \b true if the entry was queued or \b false if the queue
+//! was full.
+//
+//*****************************************************************************
+bool
+USBHSQueuePush(tUSBHSQueue *psQueue, void *pvData, uint32_t ui32Value)
+{
+    tUSBHSQueueEntry *psEntry;
+    uint32_t ui32Pos;
+    int32_t i32Diff;
+
+    ui32Pos = psQueue->ui32Head;
+
+    for(;;)
+    {
+        psEntry = &psQueue->psEntries[ui32Pos & psQueue->ui32Mask];
+        i32Diff = (int32_t)(psEntry->ui32Sequence - ui32Pos);
+
+        if(i32Diff == 0)
+        {
+            //
+            // The slot is free, try to claim this position.
+            //
+            if(USBHSAtomicCAS(&psQueue->ui32Head, ui32Pos, ui32Pos + 1))
+            {
+                break;
+            }
+        }
+        else if(i32Diff < 0)
+        {
+            //
+            // The consumer has not released this slot yet, the queue is full.
+            //
+            return(false);
+        }
+
+        //
+        // Another producer got here first, retry at the new head.
+        //
+        ui32Pos = psQueue->ui32Head;
+    }
+
+    psEntry->pvData = pvData;
+    psEntry->ui32Value = ui32Value;
+
+    //
+    // Make the payload visible before handing the slot to the consumer.
+    //
+    USBHSMemoryBarrier();
+    psEntry->ui32Sequence = ui32Pos + 1;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Removes the oldest entry from a submission queue.
+//!
+//! \param psQueue is the queue to remove the entry from.
+//! \param ppvData receives the pointer stored in the entry.
+//! \param pui32Value receives the value stored in the entry.
+//!
+//! Only one context may call this function for a given queue at a time.
+//!
+//! \return Returns \b true if an entry was removed or \b false if the queue
+//! was empty.
+//
+//*****************************************************************************
+bool
+USBHSQueuePop(tUSBHSQueue *psQueue, void **ppvData, uint32_t *pui32Value)
+{
+    tUSBHSQueueEntry *psEntry;
+    uint32_t ui32Pos;
+
+    ui32Pos = psQueue->ui32Tail;
+    psEntry = &psQueue->psEntries[ui32Pos & psQueue->ui32Mask];
+
+    if(psEntry->ui32Sequence != ui32Pos + 1)
+    {
+        return(false);
+    }
+
+    USBHSMemoryBarrier();
+    *ppvData = psEntry->pvData;
+    *pui32Value = psEntry->ui32Value;
+
+    //
+    // Hand the slot back to the producers one lap ahead.
+    //
+    USBHSMemoryBarrier();
+    psEntry->ui32Sequence = ui32Pos + psQueue->ui32Mask + 1;
+    psQueue->ui32Tail = ui32Pos + 1;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Checks whether a submission queue holds any published entries.
+//!
+//! \param psQueue is the queue to check.
+//!
+//! \return Returns \b true if there is nothing for the consumer to pop.
+//
+//*****************************************************************************
+bool
+USBHSQueueEmpty(tUSBHSQueue *psQueue)
+{
+    uint32_t ui32Pos;
+
+    ui32Pos = psQueue->ui32Tail;
+
+    return(psQueue->psEntries[ui32Pos & psQueue->ui32Mask].ui32Sequence !=
+           ui32Pos + 1);
+}
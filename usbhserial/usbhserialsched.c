@@ -0,0 +1,340 @@
+//*****************************************************************************
+//
+// usbhserialsched.c - Weighted fair scheduling of the bulk IN pipes of the
+//                     serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/usb.h"
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialbackend.h"
+#include "usbhserialpriv.h"
+#include "usbhserialusblib.h"
+
+#if USBHS_IN_BUDGET
+
+//*****************************************************************************
+//
+// The scheduler is a stride scheduler driven by the USB_EVENT_SCHEDULER
+// polls of the bulk IN pipes, which arrive from the start of frame interrupt
+// while a pipe is idle.  Every time a pipe is armed its pass advances by
+// IN_STRIDE divided by its weight.  A poll arms the pipe only if fewer than
+// USBHS_IN_BUDGET pipes were armed in the current frame and its pass is less
+// than one IN_STRIDE ahead of the lowest pass of all instances waiting to be
+// polled, so the pipes are armed in proportion to their weights.  Instances
+// that were not waiting, because they were armed or idle, are moved up to
+// at most one IN_STRIDE behind the scheduler pass when they return and
+// cannot claim the bus for the time they were away.
+//
+//*****************************************************************************
+#define IN_STRIDE               0x10000
+
+//*****************************************************************************
+//
+// Frame numbers count modulo 2048.
+//
+//*****************************************************************************
+#define IN_FRAME_MASK           0x7FF
+
+//*****************************************************************************
+//
+// Pass of the slowest waiting instance, number of pipes armed since the
+// statistics were cleared, and the frame and number of pipes armed in it.
+//
+//*****************************************************************************
+uint32_t g_ui32USBHSInPass;
+uint32_t g_ui32USBHSInArmed;
+uint16_t g_ui16USBHSInFrame;
+uint8_t g_ui8USBHSInFrameArms;
+
+//*****************************************************************************
+//
+// Returns the current USB frame number.
+//
+//*****************************************************************************
+static uint32_t
+InFrameGet(void)
+{
+    return(USBHS_BACKEND_CALL(FrameGet, ()) & IN_FRAME_MASK);
+}
+
+//*****************************************************************************
+//
+// Returns true if an instance may be polled in a frame.  Instances that
+// received data in the last USBHS_IN_IDLE_FRAMES frames always may, idle
+// ones only USBHS_IN_IDLE_INTERVAL frames after they were last armed.
+//
+//*****************************************************************************
+static bool
+InReady(tSerialInstance *psInstance, uint32_t ui32Frame)
+{
+    if(((ui32Frame - psInstance->ui16InLastData) & IN_FRAME_MASK) <
+       USBHS_IN_IDLE_FRAMES)
+    {
+        return(true);
+    }
+
+    //
+    // Keep the last data frame just out of the active window so it does not
+    // appear recent again when the frame number wraps.
+    //
+    psInstance->ui16InLastData = (ui32Frame - USBHS_IN_IDLE_FRAMES) &
+                                 IN_FRAME_MASK;
+
+    return(((ui32Frame - psInstance->ui16InLastArm) & IN_FRAME_MASK) >=
+           USBHS_IN_IDLE_INTERVAL);
+}
+
+//*****************************************************************************
+//
+// Moves an instance that fell behind to one stride behind the scheduler
+// pass.
+//
+//*****************************************************************************
+static void
+InCatchUp(tSerialInstance *psInstance)
+{
+    if((int32_t)(g_ui32USBHSInPass - psInstance->ui32InPass) > IN_STRIDE)
+    {
+        psInstance->ui32InPass = g_ui32USBHSInPass - IN_STRIDE;
+    }
+}
+
+//*****************************************************************************
+//
+// Called for a USB_EVENT_SCHEDULER poll of the bulk IN pipe of an instance.
+// Returns true if the pipe should be armed now.
+//
+//*****************************************************************************
+bool
+USBHSInArm(tSerialInstance *psInstance)
+{
+    tSerialInstance *psOther;
+    uint32_t ui32Frame, ui32Min, ui32Idx;
+
+    ui32Frame = InFrameGet();
+
+    //
+    // The pipe is only polled while it is idle.
+    //
+    psInstance->bInArmed = false;
+
+    if(ui32Frame != g_ui16USBHSInFrame)
+    {
+        g_ui16USBHSInFrame = ui32Frame;
+        g_ui8USBHSInFrameArms = 0;
+    }
+
+    if(!InReady(psInstance, ui32Frame))
+    {
+        return(false);
+    }
+
+    if(g_ui8USBHSInFrameArms >= USBHS_IN_BUDGET)
+    {
+        psInstance->sInShare.ui32Deferred++;
+        return(false);
+    }
+
+    //
+    // Find the lowest pass of the instances waiting to be polled.
+    //
+    InCatchUp(psInstance);
+    ui32Min = psInstance->ui32InPass;
+
+    for(ui32Idx = 0; ui32Idx < g_ui8NumInstances; ui32Idx++)
+    {
+        psOther = g_psInstances + ui32Idx;
+
+        if((psOther == psInstance) || !psOther->bConnected ||
+           psOther->bInArmed || !InReady(psOther, ui32Frame))
+        {
+            continue;
+        }
+
+        InCatchUp(psOther);
+        if((int32_t)(psOther->ui32InPass - ui32Min) < 0)
+        {
+            ui32Min = psOther->ui32InPass;
+        }
+    }
+
+    if((int32_t)(ui32Min - g_ui32USBHSInPass) > 0)
+    {
+        g_ui32USBHSInPass = ui32Min;
+    }
+
+    //
+    // Leave the frame to instances that are further behind.
+    //
+    if((psInstance->ui32InPass - ui32Min) >= IN_STRIDE)
+    {
+        psInstance->sInShare.ui32Deferred++;
+        return(false);
+    }
+
+    psInstance->ui32InPass += IN_STRIDE / psInstance->ui8InWeight;
+    psInstance->ui16InLastArm = ui32Frame;
+    psInstance->bInArmed = true;
+    psInstance->sInShare.ui32Armed++;
+    g_ui32USBHSInArmed++;
+    g_ui8USBHSInFrameArms++;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Called when the bulk IN pipe of an instance completed, with the number of
+// bytes received.  psInstance is 0 if the pipe was not found.
+//
+//*****************************************************************************
+void
+USBHSInReceived(tSerialInstance *psInstance, uint32_t ui32Size)
+{
+    if(psInstance == 0)
+    {
+        return;
+    }
+
+    psInstance->bInArmed = false;
+
+    if(ui32Size != 0)
+    {
+        psInstance->ui16InLastData = InFrameGet();
+        psInstance->sInShare.ui32Packets++;
+        psInstance->sInShare.ui32Bytes += ui32Size;
+    }
+}
+
+//*****************************************************************************
+//
+// Prepares the scheduler state of a newly opened instance.  New devices
+// start as active with the default weight of 1.
+//
+//*****************************************************************************
+void
+USBHSInReset(tSerialInstance *psInstance)
+{
+    psInstance->ui32InPass = g_ui32USBHSInPass;
+    psInstance->ui16InLastData = InFrameGet();
+    psInstance->ui16InLastArm = psInstance->ui16InLastData;
+    psInstance->ui8InWeight = 1;
+    psInstance->bInArmed = false;
+    psInstance->sInShare.ui32Armed = 0;
+    psInstance->sInShare.ui32Deferred = 0;
+    psInstance->sInShare.ui32Packets = 0;
+    psInstance->sInShare.ui32Bytes = 0;
+    psInstance->sInShare.ui32Share = 0;
+}
+
+#endif
+
+//*****************************************************************************
+//
+//! Sets the bulk IN scheduling weight of an instance.
+//!
+//! \param psSerialInstance is the instance to change.
+//! \param ui8Weight is the weight, from 1 to 255.  0 is taken as 1.
+//!
+//! When the library is built with USBHS_IN_BUDGET set, at most that many
+//! bulk IN pipes are armed per frame and instances that have data to receive
+//! get them in proportion to their weights.  An active instance with weight
+//! \e w, among active instances with a total weight of \e W, is armed in at
+//! least \e w of every \e W / USBHS_IN_BUDGET + 1 frames in which its driver
+//! polls it.  Instances start with a weight of 1 when they are connected, so
+//! call this from the \b USB_EVENT_CONNECTED handler.  Without a frame budget
+//! the call does nothing.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialSetWeight(tSerialInstance *psSerialInstance, uint8_t ui8Weight)
+{
+#if USBHS_IN_BUDGET
+    psSerialInstance->ui8InWeight = ui8Weight ? ui8Weight : 1;
+#endif
+}
+
+//*****************************************************************************
+//
+//! Returns the bulk IN scheduling statistics of an instance.
+//!
+//! \param psSerialInstance is the instance to read.
+//! \param psShare receives the statistics.
+//!
+//! The statistics count from the time the device was connected or
+//! USBHostSerialShareClear() was called.  Without a frame budget all values
+//! are 0.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialGetShare(tSerialInstance *psSerialInstance,
+                      tUSBHSInShare *psShare)
+{
+#if USBHS_IN_BUDGET
+    *psShare = psSerialInstance->sInShare;
+    psShare->ui32Share = g_ui32USBHSInArmed ?
+        (uint32_t)(((uint64_t)psShare->ui32Armed * 1000) /
+                   g_ui32USBHSInArmed) : 0;
+#else
+    psShare->ui32Armed = 0;
+    psShare->ui32Deferred = 0;
+    psShare->ui32Packets = 0;
+    psShare->ui32Bytes = 0;
+    psShare->ui32Share = 0;
+#endif
+}
+
+//*****************************************************************************
+//
+//! Clears the bulk IN scheduling statistics of all instances.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialShareClear(void)
+{
+#if USBHS_IN_BUDGET
+    uint32_t ui32Idx;
+    tUSBHSInShare *psShare;
+
+    for(ui32Idx = 0; ui32Idx < USBHS_MAX_INSTANCES; ui32Idx++)
+    {
+        psShare = &g_psInstances[ui32Idx].sInShare;
+        psShare->ui32Armed = 0;
+        psShare->ui32Deferred = 0;
+        psShare->ui32Packets = 0;
+        psShare->ui32Bytes = 0;
+    }
+
+    g_ui32USBHSInArmed = 0;
+#endif
+}
@@ -0,0 +1,501 @@
+//*****************************************************************************
+//
+// usbhserialselftest.c - Loopback throughput and latency self-test for the
+//                        serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialselftest.h"
+#include "usbhserialpriv.h"
+
+//*****************************************************************************
+//
+// The test takes over the instance callback and receive buffer, streams a
+// pattern that is a function of the stream offset through the looped back
+// adapter and compares every byte that comes back.  Sending is driven from
+// the receive interrupt so the window of blocks in flight stays full, the
+// main loop only changes the baud rate and evaluates the results.  Between
+// the steps the blocks still queued are purged and the test waits for their
+// completions, so nothing of one step is counted in the next one or reported
+// to the application.
+//
+//*****************************************************************************
+#define SELFTEST_CONFIG         0
+#define SELFTEST_RUN            1
+#define SELFTEST_DONE           2
+#define SELFTEST_DRAIN          3
+
+//*****************************************************************************
+//
+// Returns the pattern byte at a stream offset.
+//
+//*****************************************************************************
+static uint8_t
+SelfTestPattern(uint32_t ui32Offset)
+{
+    return((uint8_t)(ui32Offset ^ (ui32Offset >> 8) ^ (ui32Offset >> 16) ^
+                     0x55));
+}
+
+//*****************************************************************************
+//
+// Returns the stream offset just past the last byte of a block.
+//
+//*****************************************************************************
+static uint32_t
+SelfTestBlockEnd(tUSBHSSelfTest *psTest, uint32_t ui32Block)
+{
+    uint32_t ui32End;
+
+    ui32End = (ui32Block + 1) * USBHS_SELFTEST_BLOCK;
+
+    return((ui32End < psTest->ui32Bytes) ? ui32End : psTest->ui32Bytes);
+}
+
+//*****************************************************************************
+//
+// Records a round trip latency.  The largest USBHS_SELFTEST_TOPK values are
+// kept in descending order for the percentile.
+//
+//*****************************************************************************
+static void
+SelfTestSample(tUSBHSSelfTest *psTest, uint32_t ui32Latency)
+{
+    uint32_t ui32Idx;
+
+    ui32Idx = (psTest->ui32Samples < USBHS_SELFTEST_TOPK) ?
+              psTest->ui32Samples : USBHS_SELFTEST_TOPK;
+
+    if((ui32Idx < USBHS_SELFTEST_TOPK) ||
+       (ui32Latency > psTest->pui32TopK[USBHS_SELFTEST_TOPK - 1]))
+    {
+        if(ui32Idx == USBHS_SELFTEST_TOPK)
+        {
+            ui32Idx--;
+        }
+        while((ui32Idx > 0) && (psTest->pui32TopK[ui32Idx - 1] < ui32Latency))
+        {
+            psTest->pui32TopK[ui32Idx] = psTest->pui32TopK[ui32Idx - 1];
+            ui32Idx--;
+        }
+        psTest->pui32TopK[ui32Idx] = ui32Latency;
+    }
+
+    if(ui32Latency < psTest->ui32LatencyMin)
+    {
+        psTest->ui32LatencyMin = ui32Latency;
+    }
+    if(ui32Latency > psTest->ui32LatencyMax)
+    {
+        psTest->ui32LatencyMax = ui32Latency;
+    }
+    psTest->ui64LatencySum += ui32Latency;
+    psTest->ui32Samples++;
+}
+
+//*****************************************************************************
+//
+// Sends blocks until the window is full.  This is called from both the main
+// loop and the instance callback, whichever context gets here first sends
+// and the other one returns.
+//
+//*****************************************************************************
+static void
+SelfTestFill(tUSBHSSelfTest *psTest)
+{
+    uint32_t ui32Slot, ui32Size, ui32Idx;
+    uint8_t *pui8Block;
+
+    if(!USBHSAtomicCAS(&psTest->ui32Filling, 0, 1))
+    {
+        return;
+    }
+
+    while((psTest->ui32State == SELFTEST_RUN) &&
+          (psTest->ui32TxOffset < psTest->ui32Bytes) &&
+          ((psTest->ui32TxBlock - psTest->ui32RxBlock) <
+           USBHS_SELFTEST_WINDOW))
+    {
+        ui32Slot = psTest->ui32TxBlock % USBHS_SELFTEST_WINDOW;
+        ui32Size = SelfTestBlockEnd(psTest, psTest->ui32TxBlock) -
+                   psTest->ui32TxOffset;
+        pui8Block = psTest->pui8Tx[ui32Slot];
+
+        for(ui32Idx = 0; ui32Idx < ui32Size; ui32Idx++)
+        {
+            pui8Block[ui32Idx] = SelfTestPattern(psTest->ui32TxOffset +
+                                                 ui32Idx);
+        }
+
+        psTest->pui32SendTime[ui32Slot] = USBHSClockGet();
+
+        if(USBHostSerialScheduleWrite(psTest->psInstance, pui8Block,
+                                      ui32Size) != 0)
+        {
+            //
+            // The transmit queue is full, try again later.
+            //
+            break;
+        }
+
+        psTest->ui32TxOffset += ui32Size;
+        psTest->ui32TxBlock++;
+    }
+
+    psTest->ui32Filling = 0;
+}
+
+//*****************************************************************************
+//
+// Gives the instance back to the application.
+//
+//*****************************************************************************
+static void
+SelfTestRestore(tUSBHSSelfTest *psTest)
+{
+    tSerialInstance *psInstance;
+
+    psInstance = psTest->psInstance;
+
+    psTest->ui32State = SELFTEST_DONE;
+
+    //
+    // Remove the callback first so the interrupt never sees the application
+    // callback with the test state or the other way round.
+    //
+    psInstance->pfnCallback = 0;
+    psInstance->pvInBuffer = psTest->pvSavedInBuffer;
+    psInstance->ui16InBufferSize = psTest->ui16SavedInBufferSize;
+#if USBHS_RX_REARM
+    psInstance->pvInBufferAlt = psTest->pvSavedInBufferAlt;
+#endif
+    psInstance->pvCBData = psTest->pvSavedCBData;
+    psInstance->pfnCallback = psTest->pfnSavedCallback;
+}
+
+//*****************************************************************************
+//
+// Instance callback installed while the test runs.
+//
+//*****************************************************************************
+static uint32_t
+SelfTestCallback(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgParam,
+                 void *pvMsgData)
+{
+    tSerialInstance *psInstance;
+    tUSBHSSelfTest *psTest;
+    uint32_t ui32Count, ui32Idx, ui32Now;
+
+    psInstance = (tSerialInstance *)pvCBData;
+    psTest = (tUSBHSSelfTest *)psInstance->pvCBData;
+
+    switch(ui32Event)
+    {
+        case USB_EVENT_RX_AVAILABLE:
+        {
+            if(psTest->ui32State != SELFTEST_RUN)
+            {
+                break;
+            }
+
+            ui32Now = USBHSClockGet();
+            ui32Count = USBHostSerialReadDataCount(psInstance);
+
+            for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+            {
+                if(psTest->pui8Rx[ui32Idx] !=
+                   SelfTestPattern(psTest->ui32RxOffset))
+                {
+                    psTest->ui32Errors++;
+                }
+                psTest->ui32RxOffset++;
+
+                //
+                // Time every block whose last byte has come back.
+                //
+                while((psTest->ui32RxBlock != psTest->ui32TxBlock) &&
+                      (psTest->ui32RxOffset >=
+                       SelfTestBlockEnd(psTest, psTest->ui32RxBlock)))
+                {
+                    SelfTestSample(psTest, ui32Now - psTest->pui32SendTime[
+                                   psTest->ui32RxBlock % USBHS_SELFTEST_WINDOW]);
+                    psTest->ui32RxBlock++;
+                }
+            }
+
+            psTest->ui32LastRx = ui32Now;
+
+            SelfTestFill(psTest);
+
+            break;
+        }
+
+        case USB_EVENT_TX_COMPLETE:
+        {
+            //
+            // Only one context at a time reports completions, the owner of
+            // the transmit path, so the count needs no atomic update.
+            // Completions of writes the application made before the test
+            // are not counted.
+            //
+            if(((uint8_t *)pvMsgData >= psTest->pui8Tx[0]) &&
+               ((uint8_t *)pvMsgData <
+                psTest->pui8Tx[USBHS_SELFTEST_WINDOW - 1] +
+                USBHS_SELFTEST_BLOCK))
+            {
+                psTest->ui32TxDone++;
+            }
+
+            SelfTestFill(psTest);
+            break;
+        }
+
+        case USB_EVENT_DISCONNECTED:
+        {
+            //
+            // Stop the test and pass the event on.
+            //
+            SelfTestRestore(psTest);
+
+            if(psInstance->pfnCallback != 0)
+            {
+                psInstance->pfnCallback(psInstance, ui32Event, ui32MsgParam,
+                                        pvMsgData);
+            }
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Fills in the result of the current baud rate step.
+//
+//*****************************************************************************
+static void
+SelfTestResult(tUSBHSSelfTest *psTest)
+{
+    tUSBHSSelfTestResult *psResult;
+    uint32_t ui32Elapsed, ui32Rank;
+
+    psResult = &psTest->psResults[psTest->ui32Step];
+
+    psResult->ui32Baud = psTest->pui32Baud[psTest->ui32Step];
+    psResult->ui32BytesSent = psTest->ui32TxOffset;
+    psResult->ui32BytesReceived = psTest->ui32RxOffset;
+    psResult->ui32Errors = psTest->ui32Errors;
+    psResult->ui32Lost = (psTest->ui32TxOffset > psTest->ui32RxOffset) ?
+                         psTest->ui32TxOffset - psTest->ui32RxOffset : 0;
+
+    ui32Elapsed = psTest->ui32LastRx - psTest->ui32Start;
+    psResult->ui32BytesPerSecond =
+        ui32Elapsed ? (uint32_t)(((uint64_t)psTest->ui32RxOffset *
+                                  psTest->ui32TicksPerSecond) / ui32Elapsed) :
+                      0;
+
+    if(psTest->ui32Samples == 0)
+    {
+        psResult->ui32LatencyMin = 0;
+        psResult->ui32LatencyAvg = 0;
+        psResult->ui32LatencyMax = 0;
+        psResult->ui32LatencyP99 = 0;
+        return;
+    }
+
+    psResult->ui32LatencyMin = psTest->ui32LatencyMin;
+    psResult->ui32LatencyMax = psTest->ui32LatencyMax;
+    psResult->ui32LatencyAvg = (uint32_t)(psTest->ui64LatencySum /
+                                          psTest->ui32Samples);
+
+    //
+    // The 99th percentile is the n / 100 largest sample, rounded up.
+    //
+    ui32Rank = (psTest->ui32Samples + 99) / 100;
+    if(ui32Rank > USBHS_SELFTEST_TOPK)
+    {
+        ui32Rank = USBHS_SELFTEST_TOPK;
+    }
+    psResult->ui32LatencyP99 = psTest->pui32TopK[ui32Rank - 1];
+}
+
+//*****************************************************************************
+//
+//! Starts a loopback self-test on a serial instance.
+//!
+//! \param psInstance is the instance to test.  Its adapter must have the
+//! transmit line looped back to the receive line.
+//! \param psTest is the test configuration and state.  It must stay valid
+//! until USBHostSerialSelfTestProcess() returns \b true.
+//!
+//! For each baud rate in \e psTest the line is configured, \e ui32Bytes of a
+//! known pattern are streamed through the adapter and every received byte is
+//! checked.  The instance callback and receive buffer are taken over during
+//! the test and restored at the end; a disconnect ends the test and is passed
+//! on to the application callback.  The clock registered with
+//! USBHostSerialSetClock() is used for all measurements.
+//!
+//! \return Returns 0 if the test was started or non-zero if no clock is
+//! registered or the configuration is incomplete.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialSelfTestStart(tSerialInstance *psInstance, tUSBHSSelfTest *psTest)
+{
+    if((g_pfnUSBHSClock == 0) || (psTest->pui32Baud == 0) ||
+       (psTest->ui32NumBaud == 0) || (psTest->psResults == 0) ||
+       (psTest->ui32TicksPerSecond == 0))
+    {
+        return(1);
+    }
+
+    psTest->psInstance = psInstance;
+    psTest->pfnSavedCallback = psInstance->pfnCallback;
+    psTest->pvSavedCBData = psInstance->pvCBData;
+    psTest->pvSavedInBuffer = psInstance->pvInBuffer;
+    psTest->ui16SavedInBufferSize = psInstance->ui16InBufferSize;
+#if USBHS_RX_REARM
+    psTest->pvSavedInBufferAlt = psInstance->pvInBufferAlt;
+    psInstance->pvInBufferAlt = 0;
+#endif
+    psTest->ui32State = SELFTEST_CONFIG;
+    psTest->ui32Step = 0;
+    psTest->ui32Filling = 0;
+
+    psInstance->pfnCallback = 0;
+    psInstance->pvCBData = psTest;
+    USBHostSerialSetupInstance(psInstance, SelfTestCallback, psTest->pui8Rx);
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+//! Advances a loopback self-test.
+//!
+//! \param psTest is the test started with USBHostSerialSelfTestStart().
+//!
+//! This function must be called from the main loop, it changes the line
+//! configuration with control transfers between the baud rate steps.
+//!
+//! \return Returns \b true once all baud rates have been tested and the
+//! results are available, or the device was disconnected.
+//
+//*****************************************************************************
+bool
+USBHostSerialSelfTestProcess(tUSBHSSelfTest *psTest)
+{
+    uint32_t ui32Now;
+
+    switch(psTest->ui32State)
+    {
+        case SELFTEST_CONFIG:
+        {
+            USBHostSerialSetLineConfig(psTest->psInstance,
+                                       psTest->pui32Baud[psTest->ui32Step],
+                                       psTest->ui32Coding);
+
+            psTest->ui32TxOffset = 0;
+            psTest->ui32TxBlock = 0;
+            psTest->ui32TxDone = 0;
+            psTest->ui32RxOffset = 0;
+            psTest->ui32RxBlock = 0;
+            psTest->ui32Errors = 0;
+            psTest->ui32LatencyMin = 0xFFFFFFFF;
+            psTest->ui32LatencyMax = 0;
+            psTest->ui64LatencySum = 0;
+            psTest->ui32Samples = 0;
+            psTest->ui32Start = USBHSClockGet();
+            psTest->ui32LastRx = psTest->ui32Start;
+
+            psTest->ui32State = SELFTEST_RUN;
+            SelfTestFill(psTest);
+
+            break;
+        }
+
+        case SELFTEST_RUN:
+        {
+            //
+            // Send anything the interrupt could not queue.
+            //
+            SelfTestFill(psTest);
+
+            ui32Now = USBHSClockGet();
+            if((psTest->ui32RxOffset < psTest->ui32Bytes) &&
+               ((ui32Now - psTest->ui32LastRx) < psTest->ui32Timeout))
+            {
+                break;
+            }
+
+            //
+            // Stop the interrupt from using the counters before reading them,
+            // then drop the blocks that have not been sent yet.
+            //
+            psTest->ui32State = SELFTEST_DRAIN;
+            SelfTestResult(psTest);
+
+            USBHostSerialPurge(psTest->psInstance, true, true);
+
+            break;
+        }
+
+        case SELFTEST_DRAIN:
+        {
+            //
+            // Wait until every block has been completed, sent or purged,
+            // and then drop what has come back of them meanwhile.
+            //
+            if(psTest->ui32TxDone != psTest->ui32TxBlock)
+            {
+                break;
+            }
+
+            USBHostSerialPurge(psTest->psInstance, true, true);
+
+            psTest->ui32State = SELFTEST_CONFIG;
+            psTest->ui32Step++;
+            if(psTest->ui32Step == psTest->ui32NumBaud)
+            {
+                SelfTestRestore(psTest);
+            }
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    return(psTest->ui32State == SELFTEST_DONE);
+}
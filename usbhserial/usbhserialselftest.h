@@ -0,0 +1,214 @@
+//*****************************************************************************
+//
+// usbhserialselftest.h - Loopback throughput and latency self-test for the
+//                        serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#ifndef USBHSERIALSELFTEST_H_
+#define USBHSERIALSELFTEST_H_
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+//! \addtogroup usblib_host_class
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+//! Size of the blocks the test pattern is sent in, and the number of blocks
+//! that may be on their way through the adapter at the same time.
+//
+//*****************************************************************************
+#ifndef USBHS_SELFTEST_BLOCK
+#define USBHS_SELFTEST_BLOCK    64
+#endif
+
+#ifndef USBHS_SELFTEST_WINDOW
+#define USBHS_SELFTEST_WINDOW   4
+#endif
+
+//*****************************************************************************
+//
+//! Number of largest latencies kept to compute the 99th percentile.  The
+//! percentile is exact for up to 100 times this many blocks per baud rate,
+//! above that the reported value is an upper bound.
+//
+//*****************************************************************************
+#ifndef USBHS_SELFTEST_TOPK
+#define USBHS_SELFTEST_TOPK     16
+#endif
+
+//*****************************************************************************
+//
+//! Results of the self-test at one baud rate.  Latencies are the time from
+//! scheduling a block until its last byte came back, in application clock
+//! ticks.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Baud rate the result was measured at.
+    //
+    uint32_t ui32Baud;
+
+    //
+    //! Number of bytes sent and received.
+    //
+    uint32_t ui32BytesSent;
+    uint32_t ui32BytesReceived;
+
+    //
+    //! Number of received bytes that did not match the pattern.
+    //
+    uint32_t ui32Errors;
+
+    //
+    //! Number of bytes sent that never came back.
+    //
+    uint32_t ui32Lost;
+
+    //
+    //! Received bytes per second from the first block sent to the last byte
+    //! received.
+    //
+    uint32_t ui32BytesPerSecond;
+
+    //
+    //! Round trip latency of the blocks.
+    //
+    uint32_t ui32LatencyMin;
+    uint32_t ui32LatencyAvg;
+    uint32_t ui32LatencyMax;
+    uint32_t ui32LatencyP99;
+} tUSBHSSelfTestResult;
+
+//*****************************************************************************
+//
+//! State of a self-test.  The application fills in the configuration fields
+//! and passes the structure to USBHostSerialSelfTestStart(); the remaining
+//! fields are private to the library.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Baud rates to test, one after the other.
+    //
+    const uint32_t *pui32Baud;
+    uint32_t ui32NumBaud;
+
+    //
+    //! Line coding used for every baud rate, see USBHostSerialSetLineConfig().
+    //
+    uint32_t ui32Coding;
+
+    //
+    //! Number of bytes sent at each baud rate.
+    //
+    uint32_t ui32Bytes;
+
+    //
+    //! Rate of the clock registered with USBHostSerialSetClock().
+    //
+    uint32_t ui32TicksPerSecond;
+
+    //
+    //! A baud rate step ends when nothing is received for this many ticks.
+    //
+    uint32_t ui32Timeout;
+
+    //
+    //! Receives ui32NumBaud results.
+    //
+    tUSBHSSelfTestResult *psResults;
+
+    //
+    // Private state.
+    //
+    tSerialInstance *psInstance;
+    tUSBCallback pfnSavedCallback;
+    void *pvSavedCBData;
+    void *pvSavedInBuffer;
+    uint16_t ui16SavedInBufferSize;
+#if USBHS_RX_REARM
+    void *pvSavedInBufferAlt;
+#endif
+    volatile uint32_t ui32State;
+    uint32_t ui32Step;
+    volatile uint32_t ui32Filling;
+    volatile uint32_t ui32TxOffset;
+    volatile uint32_t ui32TxBlock;
+    volatile uint32_t ui32TxDone;
+    volatile uint32_t ui32RxOffset;
+    volatile uint32_t ui32RxBlock;
+    volatile uint32_t ui32Errors;
+    volatile uint32_t ui32LastRx;
+    uint32_t ui32Start;
+    uint32_t ui32LatencyMin;
+    uint32_t ui32LatencyMax;
+    uint64_t ui64LatencySum;
+    uint32_t ui32Samples;
+    uint32_t pui32TopK[USBHS_SELFTEST_TOPK];
+    uint32_t pui32SendTime[USBHS_SELFTEST_WINDOW];
+    uint8_t pui8Tx[USBHS_SELFTEST_WINDOW][USBHS_SELFTEST_BLOCK];
+    uint8_t pui8Rx[USB_TRANSFER_SIZE];
+} tUSBHSSelfTest;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern uint32_t USBHostSerialSelfTestStart(tSerialInstance *psInstance,
+                                           tUSBHSSelfTest *psTest);
+extern bool USBHostSerialSelfTestProcess(tUSBHSSelfTest *psTest);
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USBHSERIALSELFTEST_H_ */
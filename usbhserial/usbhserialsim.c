@@ -0,0 +1,493 @@
+//*****************************************************************************
+//
+// usbhserialsim.c - Simulated host controller of the serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialbackend.h"
+#include "usbhserialsim.h"
+#include "usbhserialpriv.h"
+
+#ifdef USBHS_BACKEND_TABLE
+
+//*****************************************************************************
+//
+// The simulated host controller runs one frame per call of
+// USBHostSerialSimStep().  In a frame every busy pipe moves one packet to or
+// from its device model and idle IN pipes are polled once their interval
+// has passed.  The pipe callbacks run from USBHostSerialSimStep(), which
+// takes the place of the USB interrupt.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Pipe states.
+//
+//*****************************************************************************
+#define SIM_FREE                0
+#define SIM_IDLE                1
+#define SIM_BUSY                2
+
+//*****************************************************************************
+//
+// A pipe of the simulated host controller.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Type;
+    tUSBHSSimDevice *psSim;
+    tHCDPipeCallback pfnCallback;
+    uint32_t ui32Interval;
+    uint32_t ui32Countdown;
+    uint32_t ui32MaxPacket;
+    uint8_t *pui8Data;
+    uint32_t ui32Size;
+    uint32_t ui32Done;
+    uint32_t ui32Received;
+    uint8_t ui8State;
+    uint8_t pui8Fifo[USB_TRANSFER_SIZE];
+} tSimPipe;
+
+static tSimPipe g_psSimPipes[USBHS_SIM_PIPES];
+static tUSBHSSimDevice *g_ppsSimDevices[USBHS_MAX_INSTANCES];
+static uint32_t g_ui32SimFrame;
+
+//*****************************************************************************
+//
+// Returns the pipe of a handle, or 0.
+//
+//*****************************************************************************
+static tSimPipe *
+SimPipe(uint32_t ui32Pipe)
+{
+    if((ui32Pipe == 0) || (ui32Pipe > USBHS_SIM_PIPES) ||
+       (g_psSimPipes[ui32Pipe - 1].ui8State == SIM_FREE))
+    {
+        return(0);
+    }
+
+    return(g_psSimPipes + ui32Pipe - 1);
+}
+
+//*****************************************************************************
+//
+// Backend operations.
+//
+//*****************************************************************************
+static void
+SimInit(void)
+{
+    memset(g_psSimPipes, 0, sizeof(g_psSimPipes));
+    memset(g_ppsSimDevices, 0, sizeof(g_ppsSimDevices));
+    g_ui32SimFrame = 0;
+}
+
+static uint32_t
+SimPipeAlloc(uint32_t ui32Type, tUSBHostDevice *psDevice, uint32_t ui32Size,
+             tHCDPipeCallback pfnCallback)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < USBHS_SIM_PIPES; ui32Idx++)
+    {
+        if(g_psSimPipes[ui32Idx].ui8State == SIM_FREE)
+        {
+            memset(g_psSimPipes + ui32Idx, 0, sizeof(tSimPipe));
+            g_psSimPipes[ui32Idx].ui32Type = ui32Type;
+            g_psSimPipes[ui32Idx].psSim =
+                (tUSBHSSimDevice *)((uint8_t *)psDevice -
+                                    offsetof(tUSBHSSimDevice, sDevice));
+            g_psSimPipes[ui32Idx].pfnCallback = pfnCallback;
+            g_psSimPipes[ui32Idx].ui32MaxPacket = ui32Size;
+            g_psSimPipes[ui32Idx].ui8State = SIM_IDLE;
+
+            return(ui32Idx + 1);
+        }
+    }
+
+    return(0);
+}
+
+static void
+SimPipeConfig(uint32_t ui32Pipe, uint32_t ui32MaxPacket,
+              uint32_t ui32Interval, uint32_t ui32Endpoint)
+{
+    tSimPipe *psPipe;
+
+    psPipe = SimPipe(ui32Pipe);
+    if(psPipe)
+    {
+        psPipe->ui32MaxPacket = ui32MaxPacket;
+        psPipe->ui32Interval = ui32Interval;
+        psPipe->ui32Countdown = ui32Interval;
+    }
+}
+
+static void
+SimPipeFree(uint32_t ui32Pipe)
+{
+    tSimPipe *psPipe;
+
+    psPipe = SimPipe(ui32Pipe);
+    if(psPipe)
+    {
+        psPipe->ui8State = SIM_FREE;
+    }
+}
+
+static void
+SimPipeSchedule(uint32_t ui32Pipe, uint8_t *pui8Data, uint32_t ui32Size)
+{
+    tSimPipe *psPipe;
+
+    psPipe = SimPipe(ui32Pipe);
+    if(psPipe)
+    {
+        psPipe->pui8Data = pui8Data;
+        psPipe->ui32Size = ui32Size;
+        psPipe->ui32Done = 0;
+        psPipe->ui8State = SIM_BUSY;
+    }
+}
+
+static uint32_t
+SimPipeSizeGet(uint32_t ui32Pipe)
+{
+    tSimPipe *psPipe;
+
+    psPipe = SimPipe(ui32Pipe);
+
+    return(psPipe ? psPipe->ui32Received : 0);
+}
+
+static void
+SimPipeRead(uint32_t ui32Pipe, uint8_t *pui8Data, uint32_t ui32Size)
+{
+    tSimPipe *psPipe;
+
+    psPipe = SimPipe(ui32Pipe);
+    if(psPipe && pui8Data)
+    {
+        if(ui32Size > psPipe->ui32Received)
+        {
+            ui32Size = psPipe->ui32Received;
+        }
+        memcpy(pui8Data, psPipe->pui8Fifo, ui32Size);
+    }
+}
+
+static uint32_t
+SimControlTransfer(tUSBHostDevice *psDevice, tUSBRequest *psSetupPacket,
+                   uint8_t *pui8Data, uint32_t ui32Size)
+{
+    tUSBHSSimDevice *psSim;
+    uint32_t ui32Bytes;
+
+    psSim = (tUSBHSSimDevice *)((uint8_t *)psDevice -
+                                offsetof(tUSBHSSimDevice, sDevice));
+
+    ui32Bytes = psSim->psModel->pfnControl(psSim->pvModel, psSetupPacket,
+                                           pui8Data, ui32Size);
+
+    return((ui32Bytes == USBHS_SIM_STALL) ? 0 : ui32Bytes);
+}
+
+static void
+SimClearFeature(tUSBHostDevice *psDevice, uint32_t ui32Pipe,
+                uint32_t ui32Feature)
+{
+}
+
+static uint32_t
+SimFrameGet(void)
+{
+    return(g_ui32SimFrame);
+}
+
+const tUSBHSBackend g_sUSBHSBackendSim =
+{
+    SimInit,
+    SimPipeAlloc,
+    SimPipeConfig,
+    SimPipeFree,
+    SimPipeSchedule,
+    SimPipeSizeGet,
+    SimPipeRead,
+    SimPipeSizeGet,
+    SimControlTransfer,
+    SimClearFeature,
+    SimFrameGet
+};
+
+//*****************************************************************************
+//
+// Moves one packet of a busy pipe.  Returns the event to report, or 0 if the
+// transfer goes on.
+//
+//*****************************************************************************
+static uint32_t
+SimTransfer(tSimPipe *psPipe)
+{
+    const tUSBHSSimModel *psModel;
+    uint32_t ui32Size;
+    uint8_t *pui8Dest;
+
+    psModel = psPipe->psSim->psModel;
+
+    if(psPipe->ui32Type & EP_PIPE_TYPE_OUT)
+    {
+        ui32Size = psPipe->ui32Size - psPipe->ui32Done;
+        if(ui32Size > psPipe->ui32MaxPacket)
+        {
+            ui32Size = psPipe->ui32MaxPacket;
+        }
+
+        ui32Size = psModel->pfnBulkOut(psPipe->psSim->pvModel,
+                                       psPipe->pui8Data + psPipe->ui32Done,
+                                       ui32Size);
+        if(ui32Size == USBHS_SIM_STALL)
+        {
+            return(USB_EVENT_STALL);
+        }
+
+        psPipe->ui32Done += ui32Size;
+
+        return((psPipe->ui32Done == psPipe->ui32Size) ?
+               USB_EVENT_TX_COMPLETE : 0);
+    }
+
+    //
+    // IN pipes receive into the buffer given to the schedule call, or into
+    // the FIFO to be read out, which like usblib takes a whole packet
+    // whatever size was asked for.
+    //
+    if(psPipe->pui8Data)
+    {
+        pui8Dest = psPipe->pui8Data;
+        ui32Size = psPipe->ui32Size;
+    }
+    else
+    {
+        pui8Dest = psPipe->pui8Fifo;
+        ui32Size = sizeof(psPipe->pui8Fifo);
+    }
+    if(ui32Size > psPipe->ui32MaxPacket)
+    {
+        ui32Size = psPipe->ui32MaxPacket;
+    }
+
+    if(psPipe->ui32Type & EP_PIPE_TYPE_INTR)
+    {
+        ui32Size = psModel->pfnIntIn ?
+                   psModel->pfnIntIn(psPipe->psSim->pvModel, pui8Dest,
+                                     ui32Size) : USBHS_SIM_NAK;
+    }
+    else
+    {
+        ui32Size = psModel->pfnBulkIn(psPipe->psSim->pvModel, pui8Dest,
+                                      ui32Size);
+    }
+
+    if(ui32Size == USBHS_SIM_NAK)
+    {
+        return(0);
+    }
+    if(ui32Size == USBHS_SIM_STALL)
+    {
+        return(USB_EVENT_STALL);
+    }
+
+    psPipe->ui32Received = ui32Size;
+
+    return(USB_EVENT_RX_AVAILABLE);
+}
+
+//*****************************************************************************
+//
+//! Connects a simulated device.
+//!
+//! \param psSim is the device, with its model, IDs and configuration
+//! descriptor filled in.
+//!
+//! The device is announced to the library as if it had been enumerated,
+//! so \b USB_EVENT_CONNECTED reaches the global callback before the function
+//! returns.  The library must be built with USBHS_BACKEND_TABLE and use
+//! \b g_sUSBHSBackendSim.
+//!
+//! \return The instance of the device, or 0 if it is not supported.
+//
+//*****************************************************************************
+void *
+USBHostSerialSimConnect(tUSBHSSimDevice *psSim)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < USBHS_MAX_INSTANCES; ui32Idx++)
+    {
+        if(g_ppsSimDevices[ui32Idx] == 0)
+        {
+            break;
+        }
+    }
+    if(ui32Idx == USBHS_MAX_INSTANCES)
+    {
+        return(0);
+    }
+
+    memset(&psSim->sDevice, 0, sizeof(psSim->sDevice));
+    psSim->sDevice.sDeviceDescriptor.bLength = sizeof(tDeviceDescriptor);
+    psSim->sDevice.sDeviceDescriptor.bDescriptorType = USB_DTYPE_DEVICE;
+    psSim->sDevice.sDeviceDescriptor.idVendor = psSim->ui16VID;
+    psSim->sDevice.sDeviceDescriptor.idProduct = psSim->ui16PID;
+    psSim->sDevice.sDeviceDescriptor.bMaxPacketSize0 = MAX_PACKET_SIZE_EP0;
+    psSim->sDevice.sDeviceDescriptor.bNumConfigurations = 1;
+    psSim->sDevice.psConfigDescriptor = (tConfigDescriptor *)psSim->pui8Config;
+    psSim->sDevice.ui32ConfigDescriptorSize =
+        psSim->pui8Config[2] | ((uint32_t)psSim->pui8Config[3] << 8);
+    psSim->sDevice.ui32Address = 1;
+
+    psSim->pvInstance = USBHostSerialBackendConnect(&psSim->sDevice);
+    if(psSim->pvInstance)
+    {
+        g_ppsSimDevices[ui32Idx] = psSim;
+    }
+
+    return(psSim->pvInstance);
+}
+
+//*****************************************************************************
+//
+//! Disconnects a simulated device.
+//!
+//! \param psSim is a device connected with USBHostSerialSimConnect().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialSimDisconnect(tUSBHSSimDevice *psSim)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < USBHS_MAX_INSTANCES; ui32Idx++)
+    {
+        if(g_ppsSimDevices[ui32Idx] == psSim)
+        {
+            g_ppsSimDevices[ui32Idx] = 0;
+        }
+    }
+
+    USBHostSerialBackendDisconnect(psSim->pvInstance);
+    psSim->pvInstance = 0;
+}
+
+//*****************************************************************************
+//
+//! Returns the time of the simulated host controller.
+//!
+//! The time advances by 1000 with every USBHostSerialSimStep() and starts
+//! at 0 when the library is initialized, so a simulation runs the same way
+//! every time.  Pass the function to USBHostSerialSetClock() to take
+//! timestamps in microseconds of simulated time.
+//!
+//! \return The number of microseconds simulated.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialSimClock(void)
+{
+    return(g_ui32SimFrame * 1000);
+}
+
+//*****************************************************************************
+//
+//! Runs one frame of the simulated host controller.
+//!
+//! Transfers in progress move one packet to or from their device and idle
+//! IN pipes are polled once their interval has passed, or every frame for
+//! an interval of 0.  The pipe callbacks of the library are called from this
+//! function, which stands in for the USB interrupt.
+//!
+//! \return The number of pipe events reported.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialSimStep(void)
+{
+    tSimPipe *psPipe;
+    uint32_t ui32Idx, ui32Event, ui32Count;
+
+    g_ui32SimFrame++;
+    ui32Count = 0;
+
+    for(ui32Idx = 0; ui32Idx < USBHS_MAX_INSTANCES; ui32Idx++)
+    {
+        if(g_ppsSimDevices[ui32Idx] &&
+           g_ppsSimDevices[ui32Idx]->psModel->pfnFrame)
+        {
+            g_ppsSimDevices[ui32Idx]->psModel->pfnFrame(
+                g_ppsSimDevices[ui32Idx]->pvModel);
+        }
+    }
+
+    for(ui32Idx = 0; ui32Idx < USBHS_SIM_PIPES; ui32Idx++)
+    {
+        psPipe = g_psSimPipes + ui32Idx;
+
+        if(psPipe->ui8State == SIM_BUSY)
+        {
+            ui32Event = SimTransfer(psPipe);
+            if(ui32Event != 0)
+            {
+                psPipe->ui8State = SIM_IDLE;
+                psPipe->ui32Countdown = psPipe->ui32Interval;
+                psPipe->pfnCallback(ui32Idx + 1, ui32Event);
+                ui32Count++;
+            }
+        }
+        else if((psPipe->ui8State == SIM_IDLE) &&
+                (psPipe->ui32Type & EP_PIPE_TYPE_IN))
+        {
+            if(psPipe->ui32Countdown > 1)
+            {
+                psPipe->ui32Countdown--;
+                continue;
+            }
+
+            psPipe->ui32Countdown = psPipe->ui32Interval;
+            psPipe->pfnCallback(ui32Idx + 1, USB_EVENT_SCHEDULER);
+            ui32Count++;
+        }
+    }
+
+    return(ui32Count);
+}
+
+#endif
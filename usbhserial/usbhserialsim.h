@@ -0,0 +1,164 @@
+//*****************************************************************************
+//
+// usbhserialsim.h - Simulated host controller of the serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#ifndef USBHSERIALSIM_H_
+#define USBHSERIALSIM_H_
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+//! \addtogroup usblib_host_class
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+//! Number of pipes of the simulated host controller.
+//
+//*****************************************************************************
+#ifndef USBHS_SIM_PIPES
+#define USBHS_SIM_PIPES         (3 * USBHS_MAX_INSTANCES)
+#endif
+
+//*****************************************************************************
+//
+//! Values the model functions return instead of a size.
+//
+//*****************************************************************************
+#define USBHS_SIM_NAK           0xFFFFFFFF
+#define USBHS_SIM_STALL         0xFFFFFFFE
+
+//*****************************************************************************
+//
+//! The behaviour of a simulated device.  pvModel of the device is passed to
+//! every function.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Handles a control request.  Returns the size of the data stage or
+    //! USBHS_SIM_STALL.
+    //
+    uint32_t (* pfnControl)(void *pvModel, tUSBRequest *psSetup,
+                            uint8_t *pui8Data, uint32_t ui32Size);
+
+    //
+    //! Takes bytes sent on the bulk OUT endpoint.  Returns the number of
+    //! bytes accepted, the rest is offered again in the next frame, or
+    //! USBHS_SIM_STALL.
+    //
+    uint32_t (* pfnBulkOut)(void *pvModel, const uint8_t *pui8Data,
+                            uint32_t ui32Size);
+
+    //
+    //! Fills a bulk IN packet of at most ui32Size bytes.  Returns its size,
+    //! USBHS_SIM_NAK if there is nothing to send or USBHS_SIM_STALL.
+    //
+    uint32_t (* pfnBulkIn)(void *pvModel, uint8_t *pui8Data,
+                           uint32_t ui32Size);
+
+    //
+    //! Fills an interrupt IN packet, as pfnBulkIn.  May be 0.
+    //
+    uint32_t (* pfnIntIn)(void *pvModel, uint8_t *pui8Data,
+                          uint32_t ui32Size);
+
+    //
+    //! Called at the start of every frame.  May be 0.
+    //
+    void (* pfnFrame)(void *pvModel);
+} tUSBHSSimModel;
+
+//*****************************************************************************
+//
+//! A simulated device.  The application fills in the first fields and
+//! passes the structure to USBHostSerialSimConnect(); the remaining fields
+//! are private.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Behaviour of the device and the pointer passed to it.
+    //
+    const tUSBHSSimModel *psModel;
+    void *pvModel;
+
+    //
+    //! Vendor and product ID.
+    //
+    uint16_t ui16VID;
+    uint16_t ui16PID;
+
+    //
+    //! Configuration descriptor with its interface and endpoint descriptors.
+    //
+    const uint8_t *pui8Config;
+
+    //
+    // Private state.
+    //
+    tUSBHostDevice sDevice;
+    void *pvInstance;
+} tUSBHSSimDevice;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void *USBHostSerialSimConnect(tUSBHSSimDevice *psSim);
+extern void USBHostSerialSimDisconnect(tUSBHSSimDevice *psSim);
+extern uint32_t USBHostSerialSimStep(void);
+extern uint32_t USBHostSerialSimClock(void);
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USBHSERIALSIM_H_ */
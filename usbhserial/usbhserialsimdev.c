@@ -0,0 +1,901 @@
+//*****************************************************************************
+//
+// usbhserialsimdev.c - Simulated serial adapters of the serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialsim.h"
+#include "usbhserialsimdev.h"
+
+#ifdef USBHS_BACKEND_TABLE
+
+//*****************************************************************************
+//
+// Simulated CDC ACM and CP210x adapters.  Both answer the control requests
+// the drivers use and share the data path: bytes the host sends go to the
+// transmit FIFO, leave it at the rate of the line coding, and come back
+// through the receive FIFO when looped back or injected by the application.
+// Time is counted in frames of the simulated host controller, so a run is
+// the same every time.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// CDC class requests and notification.
+//
+//*****************************************************************************
+#define USBREQ_SET_LINE_CODING  0x20
+#define USBREQ_GET_LINE_CODING  0x21
+#define USBREQ_SET_CONTROL_LINE_STATE  0x22
+#define USBREQ_SEND_BREAK       0x23
+#define CDC_SERIAL_STATE    0x20
+
+//
+// Bits of the SERIAL_STATE notification.
+//
+#define CDC_STATE_DCD           0x0001
+#define CDC_STATE_DSR           0x0002
+#define CDC_STATE_RI            0x0008
+#define CDC_STATE_OVERRUN       0x0040
+
+//*****************************************************************************
+//
+// CP210x vendor requests, from application note AN571.
+//
+//*****************************************************************************
+#define CPCDC_IFC_ENABLE    0x00
+#define CPCDC_SET_BAUDDIV   0x01
+#define CPCDC_GET_BAUDDIV   0x02
+#define CPCDC_SET_LINE_CTL  0x03
+#define CPCDC_GET_LINE_CTL  0x04
+#define CPCDC_SET_BREAK     0x05
+#define CPCDC_SET_MHS       0x07
+#define CPCDC_GET_MDMSTS    0x08
+#define CPCDC_GET_COMM_STATUS   0x10
+#define CPCDC_PURGE         0x12
+#define CPCDC_SET_FLOW      0x13
+#define CPCDC_GET_FLOW      0x14
+#define CPCDC_GET_BAUDRATE  0x1D
+#define CPCDC_SET_BAUDRATE  0x1E
+#define CPCDC_VENDOR        0xFF
+#define CPCDC_GET_PARTNUM   0x370B
+
+//
+// Clock the baud rate divisor divides.
+//
+#define CP_BAUD_CLOCK       3686400
+
+//
+// Error and hold reason bits of GET_COMM_STATUS, and the CTS handshake bit
+// of the flow control settings.
+//
+#define CP_ERROR_OVERRUN    0x08
+#define CP_HOLD_CTS         0x01
+#define CP_FLOW_CTS         0x08
+
+//*****************************************************************************
+//
+// Configuration descriptors.  The CDC device has a communication interface
+// with the notification endpoint and a data interface, the CP210x a single
+// vendor interface.
+//
+//*****************************************************************************
+static const uint8_t g_pui8SimCDCConfig[] =
+{
+    9, USB_DTYPE_CONFIGURATION, 67, 0, 2, 1, 0, 0x80, 50,
+
+    9, USB_DTYPE_INTERFACE, 0, 0, 1, 0x02, 0x02, 0x01, 0,
+    5, 0x24, 0x00, 0x10, 0x01,
+    5, 0x24, 0x01, 0x00, 0x01,
+    4, 0x24, 0x02, 0x02,
+    5, 0x24, 0x06, 0x00, 0x01,
+    7, USB_DTYPE_ENDPOINT, 0x83, 0x03, 16, 0, 10,
+
+    9, USB_DTYPE_INTERFACE, 1, 0, 2, 0x0A, 0x00, 0x00, 0,
+    7, USB_DTYPE_ENDPOINT, 0x81, 0x02, 64, 0, 0,
+    7, USB_DTYPE_ENDPOINT, 0x02, 0x02, 64, 0, 0
+};
+
+static const uint8_t g_pui8SimCP210xConfig[] =
+{
+    9, USB_DTYPE_CONFIGURATION, 32, 0, 1, 1, 0, 0x80, 50,
+
+    9, USB_DTYPE_INTERFACE, 0, 0, 2, 0xFF, 0x00, 0x00, 0,
+    7, USB_DTYPE_ENDPOINT, 0x81, 0x02, 64, 0, 0,
+    7, USB_DTYPE_ENDPOINT, 0x01, 0x02, 64, 0, 0
+};
+
+//*****************************************************************************
+//
+// Little endian access to request data.
+//
+//*****************************************************************************
+static void
+SimPut32(uint8_t *pui8Data, uint32_t ui32Value)
+{
+    pui8Data[0] = (uint8_t)ui32Value;
+    pui8Data[1] = (uint8_t)(ui32Value >> 8);
+    pui8Data[2] = (uint8_t)(ui32Value >> 16);
+    pui8Data[3] = (uint8_t)(ui32Value >> 24);
+}
+
+static uint32_t
+SimGet32(const uint8_t *pui8Data)
+{
+    return((uint32_t)pui8Data[0] | ((uint32_t)pui8Data[1] << 8) |
+           ((uint32_t)pui8Data[2] << 16) | ((uint32_t)pui8Data[3] << 24));
+}
+
+//*****************************************************************************
+//
+// Returns true if both adapters accept the line settings: 5 to 8 data bits,
+// parity 0 to 4 and stop bits 0 to 2.  Others are stalled.
+//
+//*****************************************************************************
+static bool
+SimLineValid(uint32_t ui32DataBits, uint32_t ui32Parity,
+             uint32_t ui32StopBits)
+{
+    return((ui32DataBits >= 5) && (ui32DataBits <= 8) && (ui32Parity <= 4) &&
+           (ui32StopBits <= 2));
+}
+
+//*****************************************************************************
+//
+// Returns the size of the FIFOs.
+//
+//*****************************************************************************
+static uint32_t
+SimFifoSize(tUSBHSSimSerial *psSerial)
+{
+    if((psSerial->ui32FifoSize == 0) ||
+       (psSerial->ui32FifoSize > USBHS_SIM_FIFO_MAX))
+    {
+        return(USBHS_SIM_FIFO_MAX);
+    }
+
+    return(psSerial->ui32FifoSize);
+}
+
+//*****************************************************************************
+//
+// Returns true if the device NAKs a token it could answer.  The decision
+// comes from a xorshift sequence, so it repeats from run to run.
+//
+//*****************************************************************************
+static bool
+SimNak(tUSBHSSimSerial *psSerial)
+{
+    if(psSerial->ui8NakRate == 0)
+    {
+        return(false);
+    }
+
+    psSerial->ui32Seed ^= psSerial->ui32Seed << 13;
+    psSerial->ui32Seed ^= psSerial->ui32Seed >> 17;
+    psSerial->ui32Seed ^= psSerial->ui32Seed << 5;
+
+    if((psSerial->ui32Seed & 0xFF) < psSerial->ui8NakRate)
+    {
+        psSerial->ui32Naks++;
+        return(true);
+    }
+
+    return(false);
+}
+
+//*****************************************************************************
+//
+// Stores a byte received on the line.  A full FIFO loses it.
+//
+//*****************************************************************************
+static void
+SimRxPut(tUSBHSSimSerial *psSerial, uint8_t ui8Byte)
+{
+    uint32_t ui32Size;
+
+    ui32Size = SimFifoSize(psSerial);
+    if(psSerial->ui32RxCount == ui32Size)
+    {
+        psSerial->ui32Overruns++;
+        psSerial->ui32Errors |= (psSerial->ui32Type == USBHS_SIM_CP210X) ?
+                                CP_ERROR_OVERRUN : CDC_STATE_OVERRUN;
+        return;
+    }
+
+    psSerial->pui8Rx[(psSerial->ui32RxHead + psSerial->ui32RxCount) %
+                     ui32Size] = ui8Byte;
+    psSerial->ui32RxCount++;
+}
+
+//*****************************************************************************
+//
+// Empties the FIFOs.
+//
+//*****************************************************************************
+static void
+SimPurge(tUSBHSSimSerial *psSerial, bool bTx, bool bRx)
+{
+    if(bTx)
+    {
+        psSerial->ui32TxHead = 0;
+        psSerial->ui32TxCount = 0;
+    }
+    if(bRx)
+    {
+        psSerial->ui32RxHead = 0;
+        psSerial->ui32RxCount = 0;
+        psSerial->ui32RxAge = 0;
+    }
+}
+
+//*****************************************************************************
+//
+// Handles the requests of a CDC ACM device.
+//
+//*****************************************************************************
+static uint32_t
+SimCDCControl(void *pvModel, tUSBRequest *psSetup, uint8_t *pui8Data,
+              uint32_t ui32Size)
+{
+    tUSBHSSimSerial *psSerial = pvModel;
+
+    psSerial->ui32Requests++;
+
+    if((psSetup->bmRequestType & USB_RTYPE_TYPE_M) == USB_RTYPE_CLASS)
+    {
+        switch(psSetup->bRequest)
+        {
+            case USBREQ_SET_LINE_CODING:
+            {
+                if((ui32Size < 7) ||
+                   !SimLineValid(pui8Data[6], pui8Data[5], pui8Data[4]))
+                {
+                    break;
+                }
+                psSerial->ui32Baud = SimGet32(pui8Data);
+                psSerial->ui8StopBits = pui8Data[4];
+                psSerial->ui8Parity = pui8Data[5];
+                psSerial->ui8DataBits = pui8Data[6];
+                return(7);
+            }
+            case USBREQ_GET_LINE_CODING:
+            {
+                if(ui32Size < 7)
+                {
+                    break;
+                }
+                SimPut32(pui8Data, psSerial->ui32Baud);
+                pui8Data[4] = psSerial->ui8StopBits;
+                pui8Data[5] = psSerial->ui8Parity;
+                pui8Data[6] = psSerial->ui8DataBits;
+                return(7);
+            }
+            case USBREQ_SET_CONTROL_LINE_STATE:
+            {
+                psSerial->ui32Control &= ~(USBHS_CONTROL_DTR |
+                                           USBHS_CONTROL_RTS);
+                if(psSetup->wValue & 0x01)
+                {
+                    psSerial->ui32Control |= USBHS_CONTROL_DTR;
+                }
+                if(psSetup->wValue & 0x02)
+                {
+                    psSerial->ui32Control |= USBHS_CONTROL_RTS;
+                }
+                return(0);
+            }
+            case USBREQ_SEND_BREAK:
+            {
+                psSerial->ui32Breaks++;
+                return(0);
+            }
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    psSerial->ui32Stalls++;
+
+    return(USBHS_SIM_STALL);
+}
+
+//*****************************************************************************
+//
+// Handles the vendor requests of a CP210x.
+//
+//*****************************************************************************
+static uint32_t
+SimCPControl(void *pvModel, tUSBRequest *psSetup, uint8_t *pui8Data,
+             uint32_t ui32Size)
+{
+    tUSBHSSimSerial *psSerial = pvModel;
+    uint32_t ui32Bits;
+
+    psSerial->ui32Requests++;
+
+    if((psSetup->bmRequestType & USB_RTYPE_TYPE_M) == USB_RTYPE_VENDOR)
+    {
+        switch(psSetup->bRequest)
+        {
+            case CPCDC_IFC_ENABLE:
+            {
+                psSerial->bEnabled = (psSetup->wValue & 1) != 0;
+                if(!psSerial->bEnabled)
+                {
+                    SimPurge(psSerial, true, true);
+                }
+                return(0);
+            }
+            case CPCDC_SET_BAUDDIV:
+            {
+                if(psSetup->wValue == 0)
+                {
+                    break;
+                }
+                psSerial->ui32Baud = CP_BAUD_CLOCK / psSetup->wValue;
+                return(0);
+            }
+            case CPCDC_GET_BAUDDIV:
+            {
+                if((ui32Size < 2) || (psSerial->ui32Baud == 0))
+                {
+                    break;
+                }
+                ui32Bits = CP_BAUD_CLOCK / psSerial->ui32Baud;
+                pui8Data[0] = (uint8_t)ui32Bits;
+                pui8Data[1] = (uint8_t)(ui32Bits >> 8);
+                return(2);
+            }
+            case CPCDC_SET_BAUDRATE:
+            {
+                if(ui32Size < 4)
+                {
+                    break;
+                }
+                psSerial->ui32Baud = SimGet32(pui8Data);
+                return(4);
+            }
+            case CPCDC_GET_BAUDRATE:
+            {
+                if(ui32Size < 4)
+                {
+                    break;
+                }
+                SimPut32(pui8Data, psSerial->ui32Baud);
+                return(4);
+            }
+            case CPCDC_SET_LINE_CTL:
+            {
+                if(!SimLineValid(psSetup->wValue >> 8,
+                                 (psSetup->wValue >> 4) & 0x0F,
+                                 psSetup->wValue & 0x0F))
+                {
+                    break;
+                }
+                psSerial->ui8StopBits = psSetup->wValue & 0x0F;
+                psSerial->ui8Parity = (psSetup->wValue >> 4) & 0x0F;
+                psSerial->ui8DataBits = psSetup->wValue >> 8;
+                return(0);
+            }
+            case CPCDC_GET_LINE_CTL:
+            {
+                if(ui32Size < 2)
+                {
+                    break;
+                }
+                pui8Data[0] = psSerial->ui8StopBits |
+                              (psSerial->ui8Parity << 4);
+                pui8Data[1] = psSerial->ui8DataBits;
+                return(2);
+            }
+            case CPCDC_SET_BREAK:
+            {
+                if(psSetup->wValue & 1)
+                {
+                    psSerial->ui32Breaks++;
+                }
+                return(0);
+            }
+            case CPCDC_SET_MHS:
+            {
+                //
+                // The high byte selects which of the low byte's lines are
+                // written.
+                //
+                if(psSetup->wValue & 0x0100)
+                {
+                    psSerial->ui32Control &= ~USBHS_CONTROL_DTR;
+                    if(psSetup->wValue & 0x01)
+                    {
+                        psSerial->ui32Control |= USBHS_CONTROL_DTR;
+                    }
+                }
+                if(psSetup->wValue & 0x0200)
+                {
+                    psSerial->ui32Control &= ~USBHS_CONTROL_RTS;
+                    if(psSetup->wValue & 0x02)
+                    {
+                        psSerial->ui32Control |= USBHS_CONTROL_RTS;
+                    }
+                }
+                return(0);
+            }
+            case CPCDC_GET_MDMSTS:
+            {
+                if(ui32Size < 1)
+                {
+                    break;
+                }
+                pui8Data[0] =
+                    ((psSerial->ui32Control & USBHS_CONTROL_DTR) ? 0x01 : 0) |
+                    ((psSerial->ui32Control & USBHS_CONTROL_RTS) ? 0x02 : 0) |
+                    ((psSerial->ui32Control & USBHS_CONTROL_CTS) ? 0x10 : 0) |
+                    ((psSerial->ui32Control & USBHS_CONTROL_DSR) ? 0x20 : 0) |
+                    ((psSerial->ui32Control & USBHS_CONTROL_RI) ? 0x40 : 0) |
+                    ((psSerial->ui32Control & USBHS_CONTROL_DCD) ? 0x80 : 0);
+                return(1);
+            }
+            case CPCDC_GET_COMM_STATUS:
+            {
+                if(ui32Size < 0x13)
+                {
+                    break;
+                }
+                memset(pui8Data, 0, 0x13);
+                SimPut32(pui8Data, psSerial->ui32Errors);
+                SimPut32(pui8Data + 4,
+                         ((psSerial->pui8Flow[0] & CP_FLOW_CTS) &&
+                          !(psSerial->ui32Control & USBHS_CONTROL_CTS)) ?
+                         CP_HOLD_CTS : 0);
+                SimPut32(pui8Data + 8, psSerial->ui32RxCount);
+                SimPut32(pui8Data + 12, psSerial->ui32TxCount);
+
+                //
+                // Reading the errors clears them.
+                //
+                psSerial->ui32Errors = 0;
+                return(0x13);
+            }
+            case CPCDC_PURGE:
+            {
+                SimPurge(psSerial, (psSetup->wValue & 0x05) != 0,
+                         (psSetup->wValue & 0x0A) != 0);
+                return(0);
+            }
+            case CPCDC_SET_FLOW:
+            {
+                if(ui32Size < sizeof(psSerial->pui8Flow))
+                {
+                    break;
+                }
+                memcpy(psSerial->pui8Flow, pui8Data,
+                       sizeof(psSerial->pui8Flow));
+                return(sizeof(psSerial->pui8Flow));
+            }
+            case CPCDC_GET_FLOW:
+            {
+                if(ui32Size < sizeof(psSerial->pui8Flow))
+                {
+                    break;
+                }
+                memcpy(pui8Data, psSerial->pui8Flow,
+                       sizeof(psSerial->pui8Flow));
+                return(sizeof(psSerial->pui8Flow));
+            }
+            case CPCDC_VENDOR:
+            {
+                if((psSetup->wValue != CPCDC_GET_PARTNUM) || (ui32Size < 1))
+                {
+                    break;
+                }
+                pui8Data[0] = psSerial->ui8PartNum;
+                return(1);
+            }
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    psSerial->ui32Stalls++;
+
+    return(USBHS_SIM_STALL);
+}
+
+//*****************************************************************************
+//
+// Takes bytes from the host into the transmit FIFO.  A disabled CP210x
+// drops them and a full FIFO NAKs.
+//
+//*****************************************************************************
+static uint32_t
+SimBulkOut(void *pvModel, const uint8_t *pui8Data, uint32_t ui32Size)
+{
+    tUSBHSSimSerial *psSerial = pvModel;
+    uint32_t ui32FifoSize, ui32Idx;
+
+    if(!psSerial->bEnabled)
+    {
+        return(ui32Size);
+    }
+    if(SimNak(psSerial))
+    {
+        return(0);
+    }
+
+    ui32FifoSize = SimFifoSize(psSerial);
+    if(ui32Size > ui32FifoSize - psSerial->ui32TxCount)
+    {
+        ui32Size = ui32FifoSize - psSerial->ui32TxCount;
+    }
+
+    for(ui32Idx = 0; ui32Idx < ui32Size; ui32Idx++)
+    {
+        psSerial->pui8Tx[(psSerial->ui32TxHead + psSerial->ui32TxCount) %
+                         ui32FifoSize] = pui8Data[ui32Idx];
+        psSerial->ui32TxCount++;
+    }
+
+    return(ui32Size);
+}
+
+//*****************************************************************************
+//
+// Sends received bytes to the host once a full packet is waiting or the
+// latency has passed.
+//
+//*****************************************************************************
+static uint32_t
+SimBulkIn(void *pvModel, uint8_t *pui8Data, uint32_t ui32Size)
+{
+    tUSBHSSimSerial *psSerial = pvModel;
+    uint32_t ui32FifoSize, ui32Idx;
+
+    if(!psSerial->bEnabled || (psSerial->ui32RxCount == 0) ||
+       ((psSerial->ui32RxCount < ui32Size) &&
+        (psSerial->ui32RxAge < psSerial->ui32Latency)))
+    {
+        return(USBHS_SIM_NAK);
+    }
+    if(SimNak(psSerial))
+    {
+        return(USBHS_SIM_NAK);
+    }
+
+    if(ui32Size > psSerial->ui32RxCount)
+    {
+        ui32Size = psSerial->ui32RxCount;
+    }
+
+    ui32FifoSize = SimFifoSize(psSerial);
+    for(ui32Idx = 0; ui32Idx < ui32Size; ui32Idx++)
+    {
+        pui8Data[ui32Idx] = psSerial->pui8Rx[psSerial->ui32RxHead];
+        psSerial->ui32RxHead = (psSerial->ui32RxHead + 1) % ui32FifoSize;
+    }
+    psSerial->ui32RxCount -= ui32Size;
+    psSerial->ui32RxAge = 0;
+
+    return(ui32Size);
+}
+
+//*****************************************************************************
+//
+// Sends a SERIAL_STATE notification when the modem inputs changed or an
+// error occurred.
+//
+//*****************************************************************************
+static uint32_t
+SimCDCIntIn(void *pvModel, uint8_t *pui8Data, uint32_t ui32Size)
+{
+    tUSBHSSimSerial *psSerial = pvModel;
+    uint32_t ui32State;
+
+    ui32State = ((psSerial->ui32Control & USBHS_CONTROL_DCD) ?
+                 CDC_STATE_DCD : 0) |
+                ((psSerial->ui32Control & USBHS_CONTROL_DSR) ?
+                 CDC_STATE_DSR : 0) |
+                ((psSerial->ui32Control & USBHS_CONTROL_RI) ?
+                 CDC_STATE_RI : 0);
+
+    if(((ui32State == psSerial->ui32Reported) &&
+        (psSerial->ui32Errors == 0)) || (ui32Size < 10))
+    {
+        return(USBHS_SIM_NAK);
+    }
+
+    psSerial->ui32Reported = ui32State;
+    ui32State |= psSerial->ui32Errors;
+    psSerial->ui32Errors = 0;
+
+    pui8Data[0] = USB_RTYPE_DIR_IN | USB_RTYPE_CLASS | USB_RTYPE_INTERFACE;
+    pui8Data[1] = CDC_SERIAL_STATE;
+    pui8Data[2] = 0;
+    pui8Data[3] = 0;
+    pui8Data[4] = 0;
+    pui8Data[5] = 0;
+    pui8Data[6] = 2;
+    pui8Data[7] = 0;
+    pui8Data[8] = (uint8_t)ui32State;
+    pui8Data[9] = (uint8_t)(ui32State >> 8);
+
+    return(10);
+}
+
+//*****************************************************************************
+//
+// Moves bytes on the line for one frame.  Both directions run at the rate
+// of the line coding: a character takes a start bit, the data and parity
+// bits and the stop bits.
+//
+//*****************************************************************************
+static void
+SimFrame(void *pvModel)
+{
+    tUSBHSSimSerial *psSerial = pvModel;
+    uint32_t ui32Cost, ui32Chars, ui32Out, ui32In, ui32FifoSize;
+    uint8_t ui8Byte;
+
+    if(psSerial->ui32RxCount != 0)
+    {
+        psSerial->ui32RxAge++;
+    }
+
+    //
+    // Credit is kept in hundredths of tenths of a bit, so one frame of a
+    // millisecond adds the baud rate.
+    //
+    ui32Cost = (10 * (1 + psSerial->ui8DataBits +
+                      (psSerial->ui8Parity ? 1 : 0)) +
+                5 * psSerial->ui8StopBits + 10) * 100;
+    psSerial->ui32Credit += psSerial->ui32Baud;
+    ui32Chars = psSerial->ui32Credit / ui32Cost;
+    psSerial->ui32Credit -= ui32Chars * ui32Cost;
+
+    //
+    // A line that is quiet does not save up time for later.
+    //
+    if((psSerial->ui32TxCount == 0) && (psSerial->ui32InputSize == 0))
+    {
+        psSerial->ui32Credit = 0;
+    }
+
+    //
+    // Transmit, unless the CTS handshake holds the line.
+    //
+    ui32Out = psSerial->ui32TxCount;
+    if(ui32Out > ui32Chars)
+    {
+        ui32Out = ui32Chars;
+    }
+    if((psSerial->ui32Type == USBHS_SIM_CP210X) &&
+       (psSerial->pui8Flow[0] & CP_FLOW_CTS) &&
+       !(psSerial->ui32Control & USBHS_CONTROL_CTS))
+    {
+        ui32Out = 0;
+    }
+
+    ui32FifoSize = SimFifoSize(psSerial);
+    psSerial->ui32LineOut += ui32Out;
+    while(ui32Out--)
+    {
+        ui8Byte = psSerial->pui8Tx[psSerial->ui32TxHead];
+        psSerial->ui32TxHead = (psSerial->ui32TxHead + 1) % ui32FifoSize;
+        psSerial->ui32TxCount--;
+
+        if(psSerial->pfnOutput)
+        {
+            psSerial->pfnOutput(psSerial->pvCBData, &ui8Byte, 1);
+        }
+        if(psSerial->bLoopback)
+        {
+            SimRxPut(psSerial, ui8Byte);
+            psSerial->ui32LineIn++;
+            ui32Chars--;
+        }
+    }
+
+    //
+    // Receive the bytes the application injected in the time left.
+    //
+    ui32In = psSerial->ui32InputSize;
+    if(ui32In > ui32Chars)
+    {
+        ui32In = ui32Chars;
+    }
+    psSerial->ui32LineIn += ui32In;
+    psSerial->ui32InputSize -= ui32In;
+    while(ui32In--)
+    {
+        SimRxPut(psSerial, *psSerial->pui8Input++);
+    }
+}
+
+//*****************************************************************************
+//
+// The models.
+//
+//*****************************************************************************
+const tUSBHSSimModel g_sUSBHSSimCDC =
+{
+    SimCDCControl,
+    SimBulkOut,
+    SimBulkIn,
+    SimCDCIntIn,
+    SimFrame
+};
+
+const tUSBHSSimModel g_sUSBHSSimCP210x =
+{
+    SimCPControl,
+    SimBulkOut,
+    SimBulkIn,
+    0,
+    SimFrame
+};
+
+//*****************************************************************************
+//
+//! Prepares a simulated serial adapter.
+//!
+//! \param psSim is the device to connect with USBHostSerialSimConnect().
+//! \param psSerial is the adapter, with its settings filled in.
+//! \param ui32Type is \b USBHS_SIM_CDC or \b USBHS_SIM_CP210X.
+//!
+//! The model, IDs and descriptors of \e psSim are set, and the adapter starts
+//! at 9600 baud, 8 data bits, no parity and 1 stop bit with empty FIFOs.
+//! Like the real part a CP210x moves no data until the host enables its
+//! interface.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialSimSerialSetup(tUSBHSSimDevice *psSim, tUSBHSSimSerial *psSerial,
+                            uint32_t ui32Type)
+{
+    psSerial->ui32Type = ui32Type;
+    psSerial->ui32Baud = 9600;
+    psSerial->ui8DataBits = 8;
+    psSerial->ui8Parity = 0;
+    psSerial->ui8StopBits = 0;
+    psSerial->ui32Control = 0;
+    psSerial->bEnabled = (ui32Type == USBHS_SIM_CDC);
+    memset(psSerial->pui8Flow, 0, sizeof(psSerial->pui8Flow));
+    psSerial->ui32Requests = 0;
+    psSerial->ui32Stalls = 0;
+    psSerial->ui32Breaks = 0;
+    psSerial->ui32Naks = 0;
+    psSerial->ui32Overruns = 0;
+    psSerial->ui32LineOut = 0;
+    psSerial->ui32LineIn = 0;
+    psSerial->ui32Credit = 0;
+    psSerial->ui32Errors = 0;
+    psSerial->ui32Reported = 0;
+    psSerial->pui8Input = 0;
+    psSerial->ui32InputSize = 0;
+    SimPurge(psSerial, true, true);
+
+    if(psSerial->ui32Seed == 0)
+    {
+        psSerial->ui32Seed = 1;
+    }
+    if(psSerial->ui8PartNum == 0)
+    {
+        psSerial->ui8PartNum = 0x02;
+    }
+
+    psSim->pvModel = psSerial;
+    if(ui32Type == USBHS_SIM_CP210X)
+    {
+        psSim->psModel = &g_sUSBHSSimCP210x;
+        psSim->ui16VID = 0x10C4;
+        psSim->ui16PID = 0xEA60;
+        psSim->pui8Config = g_pui8SimCP210xConfig;
+    }
+    else
+    {
+        psSim->psModel = &g_sUSBHSSimCDC;
+        psSim->ui16VID = 0x1CBE;
+        psSim->ui16PID = 0x0002;
+        psSim->pui8Config = g_pui8SimCDCConfig;
+    }
+}
+
+//*****************************************************************************
+//
+//! Feeds bytes to the receive line of a simulated adapter.
+//!
+//! \param psSerial is the adapter.
+//! \param pui8Data is the data, which must stay valid until it has been
+//! received.
+//! \param ui32Size is the number of bytes.
+//!
+//! The bytes arrive at the rate of the line coding and replace any input
+//! still waiting.  Bytes that find the receive FIFO full are lost and
+//! counted as overruns.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialSimSerialInput(tUSBHSSimSerial *psSerial,
+                            const uint8_t *pui8Data, uint32_t ui32Size)
+{
+    psSerial->pui8Input = pui8Data;
+    psSerial->ui32InputSize = ui32Size;
+}
+
+//*****************************************************************************
+//
+//! Sets the modem inputs of a simulated adapter.
+//!
+//! \param psSerial is the adapter.
+//! \param ui32Lines is a combination of \b USBHS_CONTROL_CTS,
+//! \b USBHS_CONTROL_DSR, \b USBHS_CONTROL_RI and \b USBHS_CONTROL_DCD.
+//!
+//! A CDC device reports a change with a SERIAL_STATE notification, a CP210x
+//! in the answer to GET_MDMSTS.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+USBHostSerialSimSerialModem(tUSBHSSimSerial *psSerial, uint32_t ui32Lines)
+{
+    psSerial->ui32Control = (psSerial->ui32Control &
+                             (USBHS_CONTROL_DTR | USBHS_CONTROL_RTS)) |
+                            (ui32Lines & (USBHS_CONTROL_CTS |
+                                          USBHS_CONTROL_DSR |
+                                          USBHS_CONTROL_RI |
+                                          USBHS_CONTROL_DCD));
+}
+
+//*****************************************************************************
+//
+//! Returns the number of bytes a simulated adapter still holds.
+//!
+//! \param psSerial is the adapter.
+//!
+//! \return The bytes of input not yet received on the line and the bytes in
+//! the transmit and receive FIFOs.  A test has run to completion once this
+//! is 0.
+//
+//*****************************************************************************
+uint32_t
+USBHostSerialSimSerialPending(tUSBHSSimSerial *psSerial)
+{
+    return(psSerial->ui32InputSize + psSerial->ui32TxCount +
+           psSerial->ui32RxCount);
+}
+
+#endif
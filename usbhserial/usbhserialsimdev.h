@@ -0,0 +1,202 @@
+//*****************************************************************************
+//
+// usbhserialsimdev.h - Simulated serial adapters of the serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#ifndef USBHSERIALSIMDEV_H_
+#define USBHSERIALSIMDEV_H_
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+//! \addtogroup usblib_host_class
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+//! Largest transmit and receive FIFO of a simulated adapter, the receive
+//! FIFO of a CP2102.
+//
+//*****************************************************************************
+#ifndef USBHS_SIM_FIFO_MAX
+#define USBHS_SIM_FIFO_MAX      640
+#endif
+
+//*****************************************************************************
+//
+//! Protocols of simulated adapters, for USBHostSerialSimSerialSetup().
+//
+//*****************************************************************************
+#define USBHS_SIM_CDC           0
+#define USBHS_SIM_CP210X        1
+
+//*****************************************************************************
+//
+//! A simulated USB serial adapter.  The settings are filled in before
+//! USBHostSerialSimSerialSetup(), 0 selects the default.  The line state
+//! shows what the host configured and the counters what happened on the
+//! device; the remaining fields are private.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Size of each of the transmit and receive FIFOs, at most and by
+    //! default USBHS_SIM_FIFO_MAX.
+    //
+    uint32_t ui32FifoSize;
+
+    //
+    //! Frames received bytes wait for a full packet before the device sends
+    //! them anyway, the latency timer of the adapter.
+    //
+    uint32_t ui32Latency;
+
+    //
+    //! Chance in 256 that the device NAKs a bulk token it could answer, and
+    //! the seed of the sequence deciding which ones.
+    //
+    uint8_t ui8NakRate;
+    uint32_t ui32Seed;
+
+    //
+    //! Part number the CP210x reports, CP2102 by default.
+    //
+    uint8_t ui8PartNum;
+
+    //
+    //! Bytes transmitted on the line are received again.
+    //
+    bool bLoopback;
+
+    //
+    //! Called with the bytes transmitted on the line.  May be 0.
+    //
+    void (* pfnOutput)(void *pvCBData, const uint8_t *pui8Data,
+                       uint32_t ui32Size);
+    void *pvCBData;
+
+    //
+    //! Line settings as the host configured them.  Stop bits and parity use
+    //! the encoding of both protocols: 0, 1 and 2 for 1, 1.5 and 2 stop bits,
+    //! 0 to 4 for none, odd, even, mark and space.
+    //
+    uint32_t ui32Baud;
+    uint8_t ui8DataBits;
+    uint8_t ui8Parity;
+    uint8_t ui8StopBits;
+
+    //
+    //! \b USBHS_CONTROL_DTR and \b USBHS_CONTROL_RTS as set by the host and
+    //! the modem inputs set with USBHostSerialSimSerialModem().
+    //
+    uint32_t ui32Control;
+
+    //
+    //! The CP210x interface is enabled, and its flow control settings.  A
+    //! CDC device is always enabled.
+    //
+    bool bEnabled;
+    uint8_t pui8Flow[16];
+
+    //
+    //! Counters of control requests, stalled requests, breaks, NAKed tokens,
+    //! bytes lost to a full receive FIFO and bytes moved on the line.
+    //
+    uint32_t ui32Requests;
+    uint32_t ui32Stalls;
+    uint32_t ui32Breaks;
+    uint32_t ui32Naks;
+    uint32_t ui32Overruns;
+    uint32_t ui32LineOut;
+    uint32_t ui32LineIn;
+
+    //
+    // Private state.
+    //
+    uint32_t ui32Type;
+    uint32_t ui32Credit;
+    uint32_t ui32RxAge;
+    uint32_t ui32Errors;
+    uint32_t ui32Reported;
+    const uint8_t *pui8Input;
+    uint32_t ui32InputSize;
+    uint32_t ui32TxHead;
+    uint32_t ui32TxCount;
+    uint32_t ui32RxHead;
+    uint32_t ui32RxCount;
+    uint8_t pui8Tx[USBHS_SIM_FIFO_MAX];
+    uint8_t pui8Rx[USBHS_SIM_FIFO_MAX];
+} tUSBHSSimSerial;
+
+//*****************************************************************************
+//
+//! Models of the adapters, used by USBHostSerialSimSerialSetup().
+//
+//*****************************************************************************
+extern const tUSBHSSimModel g_sUSBHSSimCDC;
+extern const tUSBHSSimModel g_sUSBHSSimCP210x;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void USBHostSerialSimSerialSetup(tUSBHSSimDevice *psSim,
+                                        tUSBHSSimSerial *psSerial,
+                                        uint32_t ui32Type);
+extern void USBHostSerialSimSerialInput(tUSBHSSimSerial *psSerial,
+                                        const uint8_t *pui8Data,
+                                        uint32_t ui32Size);
+extern void USBHostSerialSimSerialModem(tUSBHSSimSerial *psSerial,
+                                        uint32_t ui32Lines);
+extern uint32_t USBHostSerialSimSerialPending(tUSBHSSimSerial *psSerial);
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USBHSERIALSIMDEV_H_ */
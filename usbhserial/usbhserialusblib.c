@@ -0,0 +1,198 @@
+//*****************************************************************************
+//
+// usbhserialusblib.c - usblib host controller backend of the serial host
+//                      library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/usb.h"
+#include "usblib/usblib.h"
+#include "usblib/usbcdc.h"
+#include "usblib/host/usbhost.h"
+#include "usbhserial.h"
+#include "usbhserialbackend.h"
+#include "usbhserialpriv.h"
+#include "usbhserialusblib.h"
+
+#if !defined(USBHS_BACKEND_TABLE) || defined(USBHS_BACKEND_USBLIB)
+
+//*****************************************************************************
+//
+//! This constant global structure defines the CDC Class Driver that is
+//! provided with the USB library.
+//
+//*****************************************************************************
+const tUSBHostClassDriver g_sUSBSerialCDCClassDriver =
+{
+    USB_CLASS_CDC,
+    SerialDriverOpen,
+    SerialDriverClose,
+    0
+};
+
+const tUSBHostClassDriver g_sUSBSerialVendorClassDriver =
+{
+    USB_CLASS_VEND_SPECIFIC,
+    SerialDriverOpen,
+    SerialDriverClose,
+    0
+};
+
+//*****************************************************************************
+//
+// Declare the USB Events driver interface.
+//
+//*****************************************************************************
+DECLARE_EVENT_DRIVER(g_sUSBEventDriver, 0, 0, USBHCDEvents);
+
+//*****************************************************************************
+//
+// The global that holds all of the host drivers in use in the application.
+// In this case, only the CDC class is loaded.
+//
+//*****************************************************************************
+static tUSBHostClassDriver const * const g_ppHostClassDrivers[] =
+{
+    &g_sUSBSerialCDCClassDriver,
+    &g_sUSBSerialVendorClassDriver,
+    &g_sUSBEventDriver
+};
+
+//*****************************************************************************
+//
+// This global holds the number of class drivers in the g_ppHostClassDrivers
+// list.
+//
+//*****************************************************************************
+static const uint32_t g_ui32NumHostClassDrivers =
+    sizeof(g_ppHostClassDrivers) / sizeof(tUSBHostClassDriver *);
+
+//*****************************************************************************
+//
+// This is the generic callback from host stack.
+//
+// \param pvData is actually a pointer to a tEventInfo structure.
+//
+// This function will be called to inform the application when a USB event has
+// occurred that is outside those related to the CDC device.  At this
+// point this is used to detect unsupported devices being inserted and removed.
+// It is also used to inform the application when a power fault has occurred.
+// This function is required when the g_USBGenericEventDriver is included in
+// the host controller driver array that is passed in to the
+// USBHCDRegisterDrivers() function.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+USBHCDEvents(void *pvData)
+{
+    tEventInfo *pEventInfo;
+
+    //
+    // Cast this pointer to its actual type.
+    //
+    pEventInfo = (tEventInfo *)pvData;
+
+    switch(pEventInfo->ui32Event)
+    {
+        //
+        // New CDC device detected.
+        //
+        case USB_EVENT_CONNECTED:
+        {
+
+            break;
+        }
+        //
+        // Unsupported device detected.
+        //
+        case USB_EVENT_UNKNOWN_CONNECTED:
+        {
+            if(g_pfnGlobalAppCB != 0)
+            {
+                g_pfnGlobalAppCB(0, USB_EVENT_UNKNOWN_CONNECTED, 0, 0);
+            }
+            break;
+        }
+        //
+        // Device has been unplugged.
+        //
+        case USB_EVENT_DISCONNECTED:
+        {
+            break;
+        }
+        //
+        // Power Fault has occurred.
+        //
+        case USB_EVENT_POWER_FAULT:
+        {
+            if(g_pfnGlobalAppCB != 0)
+            {
+                g_pfnGlobalAppCB(0, USB_EVENT_POWER_FAULT, 0, 0);
+            }
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Registers the class drivers with usblib.  Called by USBHostSerialInit().
+//
+//*****************************************************************************
+void
+USBHSUsblibInit(void)
+{
+    USBHCDRegisterDrivers(0, g_ppHostClassDrivers, g_ui32NumHostClassDrivers);
+}
+
+#ifdef USBHS_BACKEND_TABLE
+//*****************************************************************************
+//
+// The usblib backend for a library built with USBHS_BACKEND_TABLE.  The
+// operations are the ones the library calls directly otherwise.
+//
+//*****************************************************************************
+const tUSBHSBackend g_sUSBHSBackendUsblib =
+{
+    USBHSUsblibInit,
+    USBHSUsblibPipeAlloc,
+    USBHSUsblibPipeConfig,
+    USBHSUsblibPipeFree,
+    USBHSUsblibPipeSchedule,
+    USBHSUsblibPipeSizeGet,
+    USBHSUsblibPipeRead,
+    USBHSUsblibPipeTransferSizeGet,
+    USBHSUsblibControlTransfer,
+    USBHSUsblibClearFeature,
+    USBHSUsblibFrameGet
+};
+#endif
+
+#endif
@@ -0,0 +1,143 @@
+//*****************************************************************************
+//
+// usbhserialusblib.h - Host controller access of the serial host library.
+//
+// Copyright (c) 2008-2020 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+//
+// Texas Instruments (TI) is supplying this software for use solely and
+// exclusively on TI's microcontroller products. The software is owned by
+// TI and/or its suppliers, and is protected under applicable copyright
+// laws. You may not combine this software with "viral" open-source
+// software in order to form a larger program.
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" AND WITH ALL FAULTS.
+// NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT
+// NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. TI SHALL NOT, UNDER ANY
+// CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL
+// DAMAGES, FOR ANY REASON WHATSOEVER.
+//
+// This is part of revision 2.2.0.295 of the Tiva USB Library.
+//
+//*****************************************************************************
+
+#ifndef USBHSERIALUSBLIB_H_
+#define USBHSERIALUSBLIB_H_
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The usblib backend.  These are the host controller operations as the
+// library performs them on usblib, in the form of tUSBHSBackend.
+//
+//*****************************************************************************
+#if !defined(USBHS_BACKEND_TABLE) || defined(USBHS_BACKEND_USBLIB)
+
+extern void USBHSUsblibInit(void);
+
+static inline uint32_t
+USBHSUsblibPipeAlloc(uint32_t ui32Type, tUSBHostDevice *psDevice,
+                     uint32_t ui32Size, tHCDPipeCallback pfnCallback)
+{
+    return(USBHCDPipeAllocSize(0, ui32Type, psDevice, ui32Size, pfnCallback));
+}
+
+static inline void
+USBHSUsblibPipeConfig(uint32_t ui32Pipe, uint32_t ui32MaxPacket,
+                      uint32_t ui32Interval, uint32_t ui32Endpoint)
+{
+    USBHCDPipeConfig(ui32Pipe, ui32MaxPacket, ui32Interval, ui32Endpoint);
+}
+
+static inline void
+USBHSUsblibPipeFree(uint32_t ui32Pipe)
+{
+    USBHCDPipeFree(ui32Pipe);
+}
+
+static inline void
+USBHSUsblibPipeSchedule(uint32_t ui32Pipe, uint8_t *pui8Data,
+                        uint32_t ui32Size)
+{
+    USBHCDPipeSchedule(ui32Pipe, pui8Data, ui32Size);
+}
+
+static inline uint32_t
+USBHSUsblibPipeSizeGet(uint32_t ui32Pipe)
+{
+    return(USBHCDPipeCurrentSizeGet(ui32Pipe));
+}
+
+static inline void
+USBHSUsblibPipeRead(uint32_t ui32Pipe, uint8_t *pui8Data, uint32_t ui32Size)
+{
+    USBHCDPipeReadNonBlocking(ui32Pipe, pui8Data, ui32Size);
+}
+
+static inline uint32_t
+USBHSUsblibPipeTransferSizeGet(uint32_t ui32Pipe)
+{
+    return(USBHCDPipeTransferSizeGet(ui32Pipe));
+}
+
+static inline uint32_t
+USBHSUsblibControlTransfer(tUSBHostDevice *psDevice,
+                           tUSBRequest *psSetupPacket, uint8_t *pui8Data,
+                           uint32_t ui32Size)
+{
+    return(USBHCDControlTransfer(0, psSetupPacket, psDevice, pui8Data,
+                                 ui32Size, MAX_PACKET_SIZE_EP0));
+}
+
+static inline void
+USBHSUsblibClearFeature(tUSBHostDevice *psDevice, uint32_t ui32Pipe,
+                        uint32_t ui32Feature)
+{
+    USBHCDClearFeature(psDevice->ui32Address, ui32Pipe, ui32Feature);
+}
+
+static inline uint32_t
+USBHSUsblibFrameGet(void)
+{
+    return(USBFrameNumberGet(USB0_BASE));
+}
+
+#endif
+
+//*****************************************************************************
+//
+// Calls a host controller operation.  By default the call is resolved at
+// compile time to the usblib backend; a library built with
+// USBHS_BACKEND_TABLE calls the backend registered at run time.
+//
+//*****************************************************************************
+#ifdef USBHS_BACKEND_TABLE
+extern const tUSBHSBackend *g_psUSBHSBackend;
+#define USBHS_BACKEND_CALL(Op, Args)                                         \
+        g_psUSBHSBackend->pfn##Op Args
+#else
+#define USBHS_BACKEND_CALL(Op, Args)                                         \
+        USBHSUsblib##Op Args
+#endif
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USBHSERIALUSBLIB_H_ */